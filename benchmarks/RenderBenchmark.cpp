@@ -0,0 +1,266 @@
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QTemporaryFile>
+#include <fluidsynth.h>
+
+#include <algorithm>
+#include <chrono>
+#include <clocale>
+#include <iostream>
+#include <optional>
+
+#ifdef _WIN32
+// clang-format off
+#include <windows.h>
+#include <psapi.h>
+// clang-format on
+#else
+#include <sys/resource.h>
+#endif
+
+#include "cell_types/Program.hpp"
+#include "other/SongFile.hpp"
+#include "sound/OfflineSynth.hpp"
+#include "sound/PlaybackPlan.hpp"
+
+namespace {
+
+// the most memory the process has used so far
+auto get_peak_memory_bytes() -> size_t {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters{};
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                           sizeof(counters)) == 0) {
+    return 0;
+  }
+  return counters.PeakWorkingSetSize;
+#else
+  rusage usage{};
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#ifdef __APPLE__
+  // already bytes on macOS
+  return static_cast<size_t>(usage.ru_maxrss);
+#else
+  static const auto BYTES_PER_KILOBYTE = 1024;
+  return static_cast<size_t>(usage.ru_maxrss) * BYTES_PER_KILOBYTE;
+#endif
+#endif
+}
+
+struct SongBenchmark {
+  double audio_seconds = 0;
+  double render_seconds = 0;
+  QString hash;
+};
+
+// the samples in a WAV file's data chunk, or nothing if it hasn't got one.
+// The rest of the file isn't worth hashing: libsndfile stamps float WAV
+// files with the time they were written
+auto get_wav_samples(const QByteArray& wav_bytes)
+    -> std::optional<QByteArrayView> {
+  // "RIFF", the file size, then "WAVE"
+  static const auto RIFF_HEADER_SIZE = 12;
+  // a four character id, then a little-endian size
+  static const auto CHUNK_HEADER_SIZE = 8;
+  static const auto CHUNK_ID_SIZE = 4;
+  static const auto BITS_PER_BYTE = 8U;
+  static const auto BYTE_MASK = 0xFFU;
+
+  const QByteArrayView wav_view(wav_bytes);
+  auto position = qsizetype{RIFF_HEADER_SIZE};
+  while (position + CHUNK_HEADER_SIZE <= wav_view.size()) {
+    auto chunk_size = 0U;
+    for (auto byte_number = CHUNK_HEADER_SIZE - 1;
+         byte_number >= CHUNK_ID_SIZE; byte_number = byte_number - 1) {
+      chunk_size =
+          (chunk_size << BITS_PER_BYTE) |
+          (static_cast<unsigned int>(wav_view.at(position + byte_number)) &
+           BYTE_MASK);
+    }
+    const auto data_position = position + CHUNK_HEADER_SIZE;
+    if (wav_view.sliced(position, CHUNK_ID_SIZE).startsWith("data")) {
+      return wav_view.sliced(
+          data_position, std::min(static_cast<qsizetype>(chunk_size),
+                                  wav_view.size() - data_position));
+    }
+    // chunks are padded to an even size
+    position = data_position + chunk_size + chunk_size % 2;
+  }
+  return std::nullopt;
+}
+
+// renders through render_song_to_file, like exports do, into a temporary
+// WAV file of float samples, and hashes the samples. Float samples aren't
+// dithered, unlike integer ones, so the hash only depends on what the
+// synth rendered, down to the last bit
+auto run_song_benchmark(OfflineSynth& offline_synth, const SongFile& song_file,
+                        UserWarning& warning)
+    -> std::optional<SongBenchmark> {
+  static const auto MILLISECONDS_PER_SECOND = 1000.0;
+  QTemporaryFile temporary_file;
+  if (!temporary_file.open()) {
+    warning = {.title = QObject::tr("File error"),
+               .message = QObject::tr("Cannot create a temporary file")};
+    return std::nullopt;
+  }
+  temporary_file.close();
+  const auto temporary_filename = temporary_file.fileName();
+
+  const auto& song = song_file.song;
+  auto created_file = false;
+  const auto start = std::chrono::steady_clock::now();
+  if (!render_song_to_file(offline_synth, song, song_file.gain,
+                           temporary_filename,
+                           AudioFileFormat{.file_type = "wav",
+                                           .sample_format = "float"},
+                           warning, created_file)) {
+    return std::nullopt;
+  }
+  const std::chrono::duration<double> render_duration =
+      std::chrono::steady_clock::now() - start;
+
+  QFile rendered_file(temporary_filename);
+  if (!rendered_file.open(QIODevice::ReadOnly)) {
+    warning = {.title = QObject::tr("File error"),
+               .message = QObject::tr("Cannot read the rendered file")};
+    return std::nullopt;
+  }
+  const auto wav_bytes = rendered_file.readAll();
+  const auto maybe_samples = get_wav_samples(wav_bytes);
+  if (!maybe_samples.has_value()) {
+    warning = {.title = QObject::tr("File error"),
+               .message = QObject::tr("The rendered file has no samples")};
+    return std::nullopt;
+  }
+  QCryptographicHash hash(QCryptographicHash::Sha256);
+  hash.addData(*maybe_samples);
+  return SongBenchmark{
+      .audio_seconds = get_render_milliseconds(
+                           compile_playback_plan(song).played_end_time) /
+                       MILLISECONDS_PER_SECOND,
+      .render_seconds = render_duration.count(),
+      .hash = QString::fromLatin1(hash.result().toHex())};
+}
+
+auto read_baselines(const QString& filename) -> QJsonObject {
+  QFile file(filename);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return {};
+  }
+  return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+}  // namespace
+
+// renders songs offline, as fast as it can, and reports how much faster
+// than real time that was, and how much memory it took. A hash of each
+// song's exported float samples is checked against baselines recorded with
+// the same fluidsynth version, since other versions sound slightly
+// different; a song without a baseline fails
+auto main(int number_of_arguments, char* arguments[]) -> int {
+  const QCoreApplication app(number_of_arguments, arguments);
+  QCoreApplication::setApplicationName("justly-benchmark");
+  // see executable/Justly.cpp
+  static_cast<void>(std::setlocale(  // NOLINT(concurrency-mt-unsafe)
+      LC_NUMERIC, "C"));
+  LIBXML_TEST_VERSION
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(QObject::tr(
+      "Benchmarks offline rendering, and checks it against baselines"));
+  parser.addHelpOption();
+  const QCommandLineOption baselines_option(
+      "baselines", QObject::tr("JSON file of sample hashes to check."),
+      QObject::tr("file"));
+  const QCommandLineOption update_baselines_option(
+      "update-baselines",
+      QObject::tr("Record this run's hashes as the new baselines."));
+  parser.addOptions({baselines_option, update_baselines_option});
+  parser.addPositionalArgument(
+      "songs", QObject::tr("Song (.xml) or MusicXML (.musicxml, .mxl) files."),
+      "songs...");
+  parser.process(app);
+
+  const auto song_files = parser.positionalArguments();
+  if (song_files.isEmpty()) {
+    parser.showHelp(EXIT_FAILURE);
+  }
+  const auto baselines_file = parser.value(baselines_option);
+  const auto update_baselines = parser.isSet(update_baselines_option);
+  auto baselines = read_baselines(baselines_file);
+  const auto version = QString::fromLatin1(fluid_version_str());
+  auto version_baselines = baselines.value(version).toObject();
+
+  const auto load_start = std::chrono::steady_clock::now();
+  static_cast<void>(get_some_programs(true));
+  OfflineSynth offline_synth(DEFAULT_SAMPLE_RATE);
+  const std::chrono::duration<double> load_duration =
+      std::chrono::steady_clock::now() - load_start;
+  std::cout << "fluidsynth " << version.toStdString() << ": loaded in "
+            << load_duration.count() << " s\n";
+
+  auto any_failed = false;
+  for (const auto& song_file_name : song_files) {
+    const auto song_name = QFileInfo(song_file_name).fileName();
+    std::cout << song_name.toStdString() << ": ";
+    UserWarning warning;
+    const auto maybe_song_file = read_any_song_file(song_file_name, warning);
+    const auto maybe_benchmark =
+        maybe_song_file.has_value()
+            ? run_song_benchmark(offline_synth, *maybe_song_file, warning)
+            : std::nullopt;
+    if (!maybe_benchmark.has_value()) {
+      std::cout << warning.title.toStdString() << ": "
+                << warning.message.toStdString() << '\n';
+      any_failed = true;
+      continue;
+    }
+    const auto& benchmark = *maybe_benchmark;
+    std::cout << benchmark.audio_seconds << " s of audio in "
+              << benchmark.render_seconds << " s ("
+              << benchmark.audio_seconds / benchmark.render_seconds
+              << "x real time), ";
+
+    const auto baseline = version_baselines.value(song_name).toString();
+    if (update_baselines) {
+      version_baselines.insert(song_name, benchmark.hash);
+      std::cout << "recorded " << benchmark.hash.toStdString() << '\n';
+    } else if (baseline.isEmpty()) {
+      // otherwise, a fluidsynth nobody has recorded baselines for would
+      // never check anything
+      std::cout << "NO baseline for " << benchmark.hash.toStdString()
+                << " (record one with --update-baselines)\n";
+      any_failed = true;
+    } else if (baseline == benchmark.hash) {
+      std::cout << "matches baseline\n";
+    } else {
+      std::cout << "DIFFERS from baseline: " << benchmark.hash.toStdString()
+                << '\n';
+      any_failed = true;
+    }
+  }
+  static const auto BYTES_PER_MEGABYTE = 1024.0 * 1024.0;
+  std::cout << "peak memory: "
+            << static_cast<double>(get_peak_memory_bytes()) /
+                   BYTES_PER_MEGABYTE
+            << " MB\n";
+
+  if (update_baselines) {
+    baselines.insert(version, version_baselines);
+    QFile file(baselines_file);
+    if (baselines_file.isEmpty() || !file.open(QIODevice::WriteOnly) ||
+        file.write(QJsonDocument(baselines).toJson()) < 0) {
+      std::cerr << QObject::tr("Cannot write baselines").toStdString()
+                << '\n';
+      return EXIT_FAILURE;
+    }
+  }
+  return any_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
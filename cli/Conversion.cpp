@@ -0,0 +1,53 @@
+#include "Conversion.hpp"
+
+#include <QtCore/QFile>
+#include <QtCore/QObject>
+
+#include "other/MidiExport.hpp"
+#include "sound/PlaybackPlan.hpp"
+
+auto get_conversion_formats() -> const QStringList& {
+  static const QStringList formats({"wav", "flac", "ogg", "mid"});
+  return formats;
+}
+
+auto get_conversion_options(const QString& format) -> ConversionOptions {
+  Q_ASSERT(get_conversion_formats().contains(format));
+  ConversionOptions options;
+  options.to_midi = format == "mid";
+  // by extension, so ogg goes to fluidsynth's name for it
+  options.file_format.file_type = get_audio_file_type("." + format);
+  return options;
+}
+
+auto write_song(std::optional<OfflineSynth>& maybe_synth,
+                const SongFile& song_file, const ConversionOptions& options,
+                const QString& output_file, UserWarning& warning,
+                const std::function<bool(double)>& keep_rendering) -> bool {
+  const auto& song = song_file.song;
+  if (!options.to_midi) {
+    if (!maybe_synth.has_value() ||
+        maybe_synth->sample_rate != options.sample_rate) {
+      maybe_synth.emplace(options.sample_rate);
+    }
+    auto created_file = false;
+    return render_song_to_file(*maybe_synth, song, song_file.gain,
+                               output_file, options.file_format, warning,
+                               created_file, keep_rendering);
+  }
+
+  const auto maybe_bytes =
+      get_song_midi_bytes(song, compile_playback_plan(song),
+                          options.use_tuning_messages, warning);
+  if (!maybe_bytes.has_value()) {
+    return false;
+  }
+  QFile file(output_file);
+  if (!file.open(QIODevice::WriteOnly) ||
+      file.write(*maybe_bytes) != maybe_bytes->size()) {
+    warning = {.title = QObject::tr("File error"),
+               .message = QObject::tr("Cannot write file")};
+    return false;
+  }
+  return true;
+}
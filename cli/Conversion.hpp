@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QtCore/QString>
+#include <functional>
+#include <optional>
+
+#include "other/SongFile.hpp"
+#include "other/UserWarning.hpp"
+#include "sound/OfflineSynth.hpp"
+
+struct ConversionOptions {
+  bool to_midi = false;
+  bool use_tuning_messages = false;
+  // for recordings
+  AudioFileFormat file_format;
+  double sample_rate = DEFAULT_SAMPLE_RATE;
+};
+
+// the formats justly-cli writes, and the extensions of the files it writes
+// them to: wav, flac, ogg or mid
+[[nodiscard]] auto get_conversion_formats() -> const QStringList&;
+
+// options for one of get_conversion_formats; the sample format and rate
+// are left at their defaults
+[[nodiscard]] auto get_conversion_options(const QString& format)
+    -> ConversionOptions;
+
+// writes song_file as a recording or MIDI file. The soundfont is loaded into
+// maybe_synth the first time a recording is needed, and again only if the
+// sample rate changes -- fluidsynth can't share one soundfont between
+// synths, so each thread needs its own. keep_rendering is passed on to
+// render_song_to_file
+[[nodiscard]] auto write_song(
+    std::optional<OfflineSynth>& maybe_synth, const SongFile& song_file,
+    const ConversionOptions& options, const QString& output_file,
+    UserWarning& warning,
+    const std::function<bool(double)>& keep_rendering = {}) -> bool;
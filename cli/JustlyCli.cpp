@@ -0,0 +1,246 @@
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QThread>
+#include <atomic>
+#include <clocale>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "Conversion.hpp"
+#include "RenderServer.hpp"
+#include "cell_types/Program.hpp"
+#include "other/MemoryUsage.hpp"
+
+namespace {
+
+struct ConversionJob {
+  QString input_file;
+  QString output_file;
+};
+
+// shared by every worker: each takes the next job that nobody has taken yet
+struct JobQueue {
+  const QList<ConversionJob>& jobs;
+  const ConversionOptions& options;
+  std::atomic<int> next_job_number = 0;
+  std::atomic<bool> any_failed = false;
+  // keeps lines from different workers from interleaving
+  std::mutex output_mutex;
+};
+
+auto convert_file(std::optional<OfflineSynth>& maybe_synth,
+                  const ConversionOptions& options, const ConversionJob& job,
+                  UserWarning& warning) -> bool {
+  const auto maybe_song_file = read_any_song_file(job.input_file, warning);
+  return maybe_song_file.has_value() &&
+         write_song(maybe_synth, *maybe_song_file, options, job.output_file,
+                    warning);
+}
+
+void run_jobs(JobQueue& queue) {
+  std::optional<OfflineSynth> maybe_synth;
+  const auto number_of_jobs = static_cast<int>(queue.jobs.size());
+  while (true) {
+    const auto job_number = queue.next_job_number.fetch_add(1);
+    if (job_number >= number_of_jobs) {
+      return;
+    }
+    const auto& job = queue.jobs.at(job_number);
+    UserWarning warning;
+    const auto converted =
+        convert_file(maybe_synth, queue.options, job, warning);
+    if (!converted) {
+      queue.any_failed = true;
+    }
+
+    const std::lock_guard lock(queue.output_mutex);
+    if (converted) {
+      std::cout << job.output_file.toStdString() << '\n';
+    } else {
+      std::cerr << job.input_file.toStdString() << ": "
+                << warning.title.toStdString() << ": "
+                << warning.message.toStdString() << '\n';
+    }
+  }
+}
+
+// prints what each file's song takes up once read, instead of converting it
+auto print_memory_reports(const QStringList& input_files) -> int {
+  auto any_failed = false;
+  for (const auto& input_file : input_files) {
+    UserWarning warning;
+    const auto maybe_song_file = read_any_song_file(input_file, warning);
+    if (!maybe_song_file.has_value()) {
+      std::cerr << input_file.toStdString() << ": "
+                << warning.title.toStdString() << ": "
+                << warning.message.toStdString() << '\n';
+      any_failed = true;
+      continue;
+    }
+    MemoryCounter counter;
+    std::cout << input_file.toStdString() << '\n'
+              << get_memory_report_text(get_song_memory_entries(
+                                            counter, maybe_song_file->song))
+                     .toStdString()
+              << '\n';
+  }
+  return any_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+}  // namespace
+
+auto main(int number_of_arguments, char* arguments[]) -> int {
+  const QCoreApplication app(number_of_arguments, arguments);
+  QCoreApplication::setApplicationName("justly-cli");
+  // see executable/Justly.cpp
+  static_cast<void>(std::setlocale(  // NOLINT(concurrency-mt-unsafe)
+      LC_NUMERIC, "C"));
+  LIBXML_TEST_VERSION
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(QObject::tr(
+      "Converts Justly songs and MusicXML files to WAV or MIDI files, or "
+      "serves renders on a local socket"));
+  parser.addHelpOption();
+  const QCommandLineOption format_option(
+      {"f", "format"},
+      QObject::tr("Output format: wav (default), flac, ogg or mid."),
+      QObject::tr("format"), "wav");
+  const QCommandLineOption sample_format_option(
+      "sample-format",
+      QObject::tr("Recording sample format: s16 (default), s24, s32 or "
+                  "float."),
+      QObject::tr("sample format"), AudioFileFormat().sample_format);
+  const QCommandLineOption sample_rate_option(
+      "sample-rate", QObject::tr("Recording sample rate (default: 44100)."),
+      QObject::tr("sample rate"), QString::number(DEFAULT_SAMPLE_RATE));
+  const QCommandLineOption tuning_messages_option(
+      "tuning-messages",
+      QObject::tr("Tune MIDI notes with tuning messages, not pitch bends."));
+  const QCommandLineOption jobs_option(
+      {"j", "jobs"},
+      QObject::tr("Files to convert at once (default: one per core)."),
+      QObject::tr("jobs"), QString::number(QThread::idealThreadCount()));
+  const QCommandLineOption output_folder_option(
+      {"o", "output-folder"},
+      QObject::tr("Folder to write to (default: next to each input)."),
+      QObject::tr("folder"));
+  const QCommandLineOption serve_option(
+      "serve",
+      QObject::tr("Keep running, rendering requests on the local socket "
+                  "name, rather than converting files."),
+      QObject::tr("name"));
+  const QCommandLineOption memory_report_option(
+      "memory-report",
+      QObject::tr("Print how much memory each file's song takes up, rather "
+                  "than converting it."));
+  parser.addOptions({format_option, sample_format_option, sample_rate_option,
+                     tuning_messages_option, jobs_option, output_folder_option,
+                     serve_option, memory_report_option});
+  parser.addPositionalArgument(
+      "files", QObject::tr("Song (.xml) or MusicXML (.musicxml, .mxl) files."),
+      "[files...]");
+  parser.process(app);
+
+  const auto format = parser.value(format_option).toLower();
+  if (!get_conversion_formats().contains(format)) {
+    std::cerr << QObject::tr("Unknown format: ").toStdString()
+              << format.toStdString() << '\n';
+    return EXIT_FAILURE;
+  }
+  auto options = get_conversion_options(format);
+  options.use_tuning_messages = parser.isSet(tuning_messages_option);
+  options.file_format.sample_format = parser.value(sample_format_option);
+  const auto maybe_format_warning =
+      get_audio_file_format_warning(options.file_format);
+  if (!options.to_midi && maybe_format_warning.has_value()) {
+    std::cerr << maybe_format_warning->message.toStdString() << '\n';
+    return EXIT_FAILURE;
+  }
+  bool sample_rate_ok = false;
+  options.sample_rate = parser.value(sample_rate_option).toDouble(
+      &sample_rate_ok);
+  if (!sample_rate_ok || options.sample_rate < MIN_SAMPLE_RATE ||
+      options.sample_rate > MAX_SAMPLE_RATE) {
+    std::cerr << QObject::tr("Sample rate must be between ").toStdString()
+              << MIN_SAMPLE_RATE << QObject::tr(" and ").toStdString()
+              << MAX_SAMPLE_RATE << '\n';
+    return EXIT_FAILURE;
+  }
+  bool jobs_ok = false;
+  const auto number_of_workers = parser.value(jobs_option).toInt(&jobs_ok);
+  if (!jobs_ok || number_of_workers < 1) {
+    std::cerr << QObject::tr("Jobs must be a positive number").toStdString()
+              << '\n';
+    return EXIT_FAILURE;
+  }
+
+  // builds the program table up front, while there's only one thread,
+  // rather than having every worker wait on the first to get to it
+  static_cast<void>(get_some_programs(true));
+
+  if (parser.isSet(serve_option)) {
+    const auto server_name = parser.value(serve_option);
+    RenderServer render_server(number_of_workers);
+    if (!start_render_server(render_server, server_name)) {
+      std::cerr << QObject::tr("Cannot listen on ").toStdString()
+                << server_name.toStdString() << ": "
+                << render_server.server.errorString().toStdString() << '\n';
+      return EXIT_FAILURE;
+    }
+    return QCoreApplication::exec();
+  }
+
+  const auto input_files = parser.positionalArguments();
+  if (input_files.isEmpty()) {
+    parser.showHelp(EXIT_FAILURE);
+  }
+  if (parser.isSet(memory_report_option)) {
+    return print_memory_reports(input_files);
+  }
+  const auto output_folder = parser.value(output_folder_option);
+
+  QList<ConversionJob> jobs;
+  // which input is converted to each output, since two workers writing the
+  // same file at once would garble it: e.g. a.xml and a.musicxml, or, with
+  // an output folder, two a.xml files from different folders
+  QHash<QString, QString> output_inputs;
+  for (const auto& input_file : input_files) {
+    const QFileInfo input_info(input_file);
+    const auto folder = output_folder.isEmpty() ? input_info.absoluteDir()
+                                                : QDir(output_folder);
+    const auto output_file = QDir::cleanPath(folder.absoluteFilePath(
+        input_info.completeBaseName() + "." + format));
+    const auto existing = output_inputs.constFind(output_file);
+    if (existing != output_inputs.cend()) {
+      std::cerr << QObject::tr("Both ").toStdString()
+                << existing.value().toStdString()
+                << QObject::tr(" and ").toStdString()
+                << input_file.toStdString()
+                << QObject::tr(" would be converted to ").toStdString()
+                << output_file.toStdString() << '\n';
+      return EXIT_FAILURE;
+    }
+    output_inputs.insert(output_file, input_file);
+    jobs.push_back(
+        ConversionJob{.input_file = input_file, .output_file = output_file});
+  }
+
+  JobQueue queue{.jobs = jobs, .options = options};
+  std::vector<std::thread> workers;
+  for (auto worker_number = 0;
+       worker_number <
+       std::min(number_of_workers, static_cast<int>(jobs.size()));
+       worker_number = worker_number + 1) {
+    workers.emplace_back(run_jobs, std::ref(queue));
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  return queue.any_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
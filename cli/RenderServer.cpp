@@ -0,0 +1,244 @@
+#include "RenderServer.hpp"
+
+#include <QtCore/QFile>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QMetaObject>
+#include <QtCore/QObject>
+#include <QtCore/QTemporaryFile>
+
+namespace {
+
+void write_reply(QLocalSocket& socket, const QJsonObject& reply) {
+  socket.write(QJsonDocument(reply).toJson(QJsonDocument::Compact) + '\n');
+}
+
+// workers can't touch sockets, so replies go back through the main thread's
+// event loop
+void post_reply(RenderServer& render_server, const RenderRequest& request,
+                QJsonObject reply) {
+  reply.insert("id", request.id);
+  QMetaObject::invokeMethod(
+      &render_server.server,
+      [socket_pointer = request.socket_pointer,
+       reply = std::move(reply)]() -> auto {
+        if (socket_pointer != nullptr) {
+          write_reply(*socket_pointer, reply);
+        }
+      },
+      Qt::QueuedConnection);
+}
+
+auto get_error_reply(const UserWarning& warning) -> QJsonObject {
+  return QJsonObject{{"error", warning.title + ": " + warning.message}};
+}
+
+auto render_request(RenderServer& render_server,
+                    std::optional<OfflineSynth>& maybe_synth,
+                    const RenderRequest& request, UserWarning& warning)
+    -> std::optional<QJsonObject> {
+  const auto maybe_song_file =
+      request.input_file.isEmpty()
+          ? read_song_bytes(request.song_xml, warning)
+          : read_any_song_file(request.input_file, warning);
+  if (!maybe_song_file.has_value()) {
+    return std::nullopt;
+  }
+
+  const auto keep_rendering = [&render_server,
+                               &request](const double progress) -> auto {
+    if (request.closed_pointer->load()) {
+      return false;
+    }
+    post_reply(render_server, request, QJsonObject{{"progress", progress}});
+    return true;
+  };
+
+  if (!request.output_file.isEmpty()) {
+    if (!write_song(maybe_synth, *maybe_song_file, request.options,
+                    request.output_file, warning, keep_rendering)) {
+      return std::nullopt;
+    }
+    return QJsonObject{{"output_file", request.output_file}};
+  }
+
+  // fluidsynth only renders into files, so the result takes a detour
+  // through a temporary one
+  QTemporaryFile temporary_file;
+  if (!temporary_file.open()) {
+    warning = {.title = QObject::tr("File error"),
+               .message = QObject::tr("Cannot create a temporary file")};
+    return std::nullopt;
+  }
+  temporary_file.close();
+  const auto temporary_filename = temporary_file.fileName();
+  if (!write_song(maybe_synth, *maybe_song_file, request.options,
+                  temporary_filename, warning, keep_rendering)) {
+    return std::nullopt;
+  }
+  QFile result_file(temporary_filename);
+  if (!result_file.open(QIODevice::ReadOnly)) {
+    warning = {.title = QObject::tr("File error"),
+               .message = QObject::tr("Cannot read the rendered file")};
+    return std::nullopt;
+  }
+  return QJsonObject{
+      {"data", QString::fromLatin1(result_file.readAll().toBase64())}};
+}
+
+void run_renders(RenderServer& render_server) {
+  // loaded up front, rather than on the first request, so no client ever
+  // waits on it
+  std::optional<OfflineSynth> maybe_synth(std::in_place, DEFAULT_SAMPLE_RATE);
+
+  auto& pending_requests = render_server.pending_requests;
+  std::unique_lock lock(render_server.mutex);
+  while (true) {
+    render_server.condition.wait(lock, [&render_server]() -> auto {
+      return render_server.stopping ||
+             !render_server.pending_requests.empty();
+    });
+    if (render_server.stopping) {
+      return;
+    }
+    const auto request = std::move(pending_requests.front());
+    pending_requests.pop_front();
+
+    lock.unlock();
+    if (!request.closed_pointer->load()) {
+      UserWarning warning;
+      const auto maybe_reply =
+          render_request(render_server, maybe_synth, request, warning);
+      post_reply(render_server, request,
+                 maybe_reply.has_value() ? *maybe_reply
+                                         : get_error_reply(warning));
+    }
+    lock.lock();
+  }
+}
+
+// nullopt, with a warning, if the line isn't a request
+auto parse_request(const QByteArray& line, UserWarning& warning)
+    -> std::optional<RenderRequest> {
+  const auto document = QJsonDocument::fromJson(line);
+  if (!document.isObject()) {
+    warning = {.title = QObject::tr("Request error"),
+               .message = QObject::tr("Expected a JSON object")};
+    return std::nullopt;
+  }
+  const auto object = document.object();
+  const auto format = object.value("format").toString("wav");
+  if (!get_conversion_formats().contains(format)) {
+    warning = {.title = QObject::tr("Request error"),
+               .message = QObject::tr("Unknown format: ") + format};
+    return std::nullopt;
+  }
+  auto options = get_conversion_options(format);
+  options.use_tuning_messages = object.value("tuning_messages").toBool();
+  options.file_format.sample_format = object.value("sample_format").toString(
+      options.file_format.sample_format);
+  options.sample_rate =
+      object.value("sample_rate").toDouble(options.sample_rate);
+  if (!options.to_midi) {
+    auto maybe_format_warning =
+        get_audio_file_format_warning(options.file_format);
+    if (maybe_format_warning.has_value()) {
+      warning = std::move(*maybe_format_warning);
+      return std::nullopt;
+    }
+    if (options.sample_rate < MIN_SAMPLE_RATE ||
+        options.sample_rate > MAX_SAMPLE_RATE) {
+      warning = {.title = QObject::tr("Request error"),
+                 .message = QObject::tr("Sample rate out of range")};
+      return std::nullopt;
+    }
+  }
+  const auto input_file = object.value("input_file").toString();
+  const auto song_xml = object.value("song_xml").toString();
+  if (input_file.isEmpty() == song_xml.isEmpty()) {
+    warning = {.title = QObject::tr("Request error"),
+               .message =
+                   QObject::tr("Expected either input_file or song_xml")};
+    return std::nullopt;
+  }
+  return RenderRequest{
+      .id = object.value("id"),
+      .options = options,
+      .input_file = input_file,
+      .song_xml = song_xml.toUtf8(),
+      .output_file = object.value("output_file").toString()};
+}
+
+void read_requests(RenderServer& render_server, QLocalSocket& socket,
+                   const std::shared_ptr<std::atomic<bool>>& closed_pointer) {
+  while (socket.canReadLine()) {
+    const auto line = socket.readLine().trimmed();
+    if (line.isEmpty()) {
+      continue;
+    }
+    UserWarning warning;
+    auto maybe_request = parse_request(line, warning);
+    if (!maybe_request.has_value()) {
+      write_reply(socket, get_error_reply(warning));
+      continue;
+    }
+    maybe_request->socket_pointer = &socket;
+    maybe_request->closed_pointer = closed_pointer;
+    {
+      const std::lock_guard lock(render_server.mutex);
+      render_server.pending_requests.push_back(std::move(*maybe_request));
+    }
+    render_server.condition.notify_one();
+  }
+}
+
+void accept_connections(RenderServer& render_server) {
+  auto& server = render_server.server;
+  while (server.hasPendingConnections()) {
+    auto& socket = get_reference(server.nextPendingConnection());
+    auto closed_pointer = std::make_shared<std::atomic<bool>>(false);
+    QObject::connect(&socket, &QLocalSocket::readyRead, &server,
+                     [&render_server, &socket, closed_pointer]() -> auto {
+                       read_requests(render_server, socket, closed_pointer);
+                     });
+    QObject::connect(&socket, &QLocalSocket::disconnected, &server,
+                     [&socket, closed_pointer]() -> auto {
+                       closed_pointer->store(true);
+                       socket.deleteLater();
+                     });
+  }
+}
+
+}  // namespace
+
+RenderServer::RenderServer(const int number_of_workers) {
+  for (auto worker_number = 0; worker_number < number_of_workers;
+       worker_number = worker_number + 1) {
+    workers.emplace_back(run_renders, std::ref(*this));
+  }
+}
+
+RenderServer::~RenderServer() {
+  {
+    const std::lock_guard lock(mutex);
+    stopping = true;
+  }
+  condition.notify_all();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+auto start_render_server(RenderServer& render_server,
+                         const QString& server_name) -> bool {
+  QLocalServer::removeServer(server_name);
+  auto& server = render_server.server;
+  if (!server.listen(server_name)) {
+    return false;
+  }
+  QObject::connect(&server, &QLocalServer::newConnection, &server,
+                   [&render_server]() -> auto {
+                     accept_connections(render_server);
+                   });
+  return true;
+}
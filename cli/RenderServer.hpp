@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QJsonValue>
+#include <QtCore/QPointer>
+#include <QtCore/QString>
+#include <QtNetwork/QLocalServer>
+#include <QtNetwork/QLocalSocket>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Conversion.hpp"
+#include "other/helpers.hpp"
+
+// one line from a client, already parsed; the song itself is read on a
+// worker, so a big song never holds up the socket
+struct RenderRequest {
+  // only ever dereferenced on the main thread (see post_reply)
+  QPointer<QLocalSocket> socket_pointer;
+  // set on the main thread when the client hangs up, so a worker can give up
+  // on its renders
+  std::shared_ptr<std::atomic<bool>> closed_pointer;
+  QJsonValue id;
+  ConversionOptions options;
+  QString input_file;
+  QByteArray song_xml;
+  // if empty, the result is sent back instead
+  QString output_file;
+};
+
+// renders songs for any number of clients on a local socket, one JSON
+// object per line each way. Each worker loads the soundfont once, at
+// startup, and keeps it for every request after, so a request only costs
+// its own render
+struct RenderServer {
+  QLocalServer server;
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<RenderRequest> pending_requests;
+  bool stopping = false;
+
+  std::vector<std::thread> workers;
+
+  explicit RenderServer(int number_of_workers);
+  ~RenderServer();
+
+  NO_MOVE_COPY(RenderServer)
+};
+
+// replaces any stale socket left by a server that crashed; false if the
+// name can't be listened on
+[[nodiscard]] auto start_render_server(RenderServer& render_server,
+                                       const QString& server_name) -> bool;
@@ -3,9 +3,10 @@
 #include <QtGui/QUndoCommand>
 
 #include "models/RowsModel.hpp"
+#include "other/MemoryUsage.hpp"
 
 template <RowInterface SubRow>
-struct DeleteCells : public QUndoCommand {
+struct DeleteCells : public QUndoCommand, public MemoryCounted {
   RowsModel<SubRow>& rows_model;
   const int first_row_number;
   const int number_of_rows;
@@ -34,4 +35,10 @@ struct DeleteCells : public QUndoCommand {
                                        number_of_rows, left_column,
                                        right_column));
   }
+
+  [[nodiscard]] auto count_memory_bytes(MemoryCounter& counter) const
+      -> qsizetype override {
+    return static_cast<qsizetype>(sizeof(DeleteCells)) +
+           count_list_bytes(counter, old_rows);
+  }
 };
@@ -2,6 +2,8 @@
 
 #include <QtGui/QUndoStack>
 
+#include "other/MemoryUsage.hpp"
+#include "other/Song.hpp"
 #include "rows/Row.hpp"
 
 template <RowInterface SubRow>
@@ -22,13 +24,18 @@ static void insert_or_remove(RowsModel<SubRow>& rows_model,
 }
 
 template <RowInterface SubRow>
-struct InsertRemoveRows : public QUndoCommand {
+struct InsertRemoveRows : public QUndoCommand, public MemoryCounted {
   RowsModel<SubRow>& rows_model;
   const int first_row_number;
   const QList<SubRow> new_rows;
   const int left_column;
   const int right_column;
   const bool backwards;
+  // the chords model moves repeats along with the chords (see
+  // insert_repeat_chords), but can't move them back: a repeat whose chords
+  // all go is gone, and chords put back where one started land before it
+  const QList<Repeat> old_repeats;
+
   InsertRemoveRows(RowsModel<SubRow>& rows_model_input,
                    const int first_row_number_input,
                    QList<SubRow> new_rows_input, const int left_column_input,
@@ -38,15 +45,24 @@ struct InsertRemoveRows : public QUndoCommand {
         new_rows(std::move(new_rows_input)),
         left_column(left_column_input),
         right_column(right_column_input),
-        backwards(backwards_input) {}
+        backwards(backwards_input),
+        old_repeats(rows_model.song.repeats) {}
 
   void undo() override {
     insert_or_remove(rows_model, first_row_number, new_rows, left_column,
                      right_column, backwards);
+    rows_model.song.repeats = old_repeats;
   }
 
   void redo() override {
     insert_or_remove(rows_model, first_row_number, new_rows, left_column,
                      right_column, !backwards);
   }
+
+  [[nodiscard]] auto count_memory_bytes(MemoryCounter& counter) const
+      -> qsizetype override {
+    return static_cast<qsizetype>(sizeof(InsertRemoveRows)) +
+           count_list_bytes(counter, new_rows) +
+           count_list_bytes(counter, old_repeats);
+  }
 };
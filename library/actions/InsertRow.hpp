@@ -2,24 +2,39 @@
 
 #include <QtGui/QUndoStack>
 
+#include "other/MemoryUsage.hpp"
+#include "other/Song.hpp"
 #include "rows/Row.hpp"
 
 template <RowInterface SubRow>
 struct RowsModel;
 
 template <RowInterface SubRow>
-struct InsertRow : public QUndoCommand {
+struct InsertRow : public QUndoCommand, public MemoryCounted {
   RowsModel<SubRow>& rows_model;
   const int row_number;
   const SubRow new_row;
+  // see InsertRemoveRows
+  const QList<Repeat> old_repeats;
 
   InsertRow(RowsModel<SubRow>& rows_model_input, const int row_number_input,
             SubRow new_row_input = SubRow())
       : rows_model(rows_model_input),
         row_number(row_number_input),
-        new_row(std::move(new_row_input)) {}
+        new_row(std::move(new_row_input)),
+        old_repeats(rows_model.song.repeats) {}
 
-  void undo() override { rows_model.remove_rows(row_number, 1); }
+  void undo() override {
+    rows_model.remove_rows(row_number, 1);
+    rows_model.song.repeats = old_repeats;
+  }
 
   void redo() override { rows_model.insert_row(row_number, new_row); }
+
+  [[nodiscard]] auto count_memory_bytes(MemoryCounter& counter) const
+      -> qsizetype override {
+    return static_cast<qsizetype>(sizeof(InsertRow)) +
+           count_heap_bytes(counter, new_row) +
+           count_list_bytes(counter, old_repeats);
+  }
 };
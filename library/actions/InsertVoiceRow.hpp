@@ -4,6 +4,7 @@
 
 #include "actions/AffectedVoiceNote.hpp"
 #include "actions/RenumberedVoiceNote.hpp"
+#include "other/MemoryUsage.hpp"
 
 template <VoiceInterface SubVoice>
 struct VoicesModel;
@@ -12,7 +13,7 @@ struct VoicesModel;
 // a voice at or after the insertion point, including any note cells sitting
 // on the OS clipboard, so a later paste doesn't land on the wrong voice
 template <VoiceInterface SubVoice, NoteInterface SubNote>
-struct InsertVoiceRow : public QUndoCommand {
+struct InsertVoiceRow : public QUndoCommand, public MemoryCounted {
   VoicesModel<SubVoice>& voices_model;
   const int row_number;
   const SubVoice new_row;
@@ -54,4 +55,11 @@ struct InsertVoiceRow : public QUndoCommand {
                                               /*is_insertion=*/true);
     voices_model.insert_row(row_number, new_row);
   }
+
+  [[nodiscard]] auto count_memory_bytes(MemoryCounter& counter) const
+      -> qsizetype override {
+    return static_cast<qsizetype>(sizeof(InsertVoiceRow)) +
+           count_heap_bytes(counter, new_row) +
+           count_list_bytes(counter, affected_notes);
+  }
 };
@@ -4,6 +4,7 @@
 
 #include "actions/AffectedVoiceNote.hpp"
 #include "actions/RenumberedVoiceNote.hpp"
+#include "other/MemoryUsage.hpp"
 
 template <VoiceInterface SubVoice>
 struct VoicesModel;
@@ -14,7 +15,7 @@ struct VoicesModel;
 // note cells sitting on the OS clipboard, so a later paste doesn't land on
 // the wrong voice
 template <VoiceInterface SubVoice, NoteInterface SubNote>
-struct RemoveVoiceRows : public QUndoCommand {
+struct RemoveVoiceRows : public QUndoCommand, public MemoryCounted {
   VoicesModel<SubVoice>& voices_model;
   const int first_row_number;
   const QList<SubVoice> old_voice_rows;
@@ -103,4 +104,13 @@ struct RemoveVoiceRows : public QUndoCommand {
         first_row_number, number_of_rows, /*is_insertion=*/false,
         &voices_model.parent, first_voice_name);
   }
+
+  [[nodiscard]] auto count_memory_bytes(MemoryCounter& counter) const
+      -> qsizetype override {
+    return static_cast<qsizetype>(sizeof(RemoveVoiceRows)) +
+           count_list_bytes(counter, old_voice_rows) +
+           count_list_bytes(counter, renumbered_notes) +
+           count_list_bytes(counter, reassigned_notes) +
+           count_string_bytes(counter, first_voice_name);
+  }
 };
@@ -98,6 +98,7 @@ void update_actions(SongMenuBar& song_menu_bar, SongWidget& song_widget,
           current_row_type != RowType::unpitched_note_type);
 
   song_menu_bar.play_menu.play_action.setEnabled(anything_selected);
+  update_pre_render(song_menu_bar.play_menu, song_widget);
   song_menu_bar.play_menu.play_to_end_action.setEnabled(anything_selected &&
                                                         !is_voice);
 
@@ -3,9 +3,10 @@
 #include <QtGui/QUndoCommand>
 
 #include "models/RowsModel.hpp"
+#include "other/MemoryUsage.hpp"
 
 template <RowInterface SubRow>
-struct SetCells : public QUndoCommand {
+struct SetCells : public QUndoCommand, public MemoryCounted {
   RowsModel<SubRow>& rows_model;
   const int first_row_number;
   const int number_of_rows;
@@ -38,4 +39,11 @@ struct SetCells : public QUndoCommand {
                                     number_of_rows, left_column, right_column),
                          new_rows);
   }
+
+  [[nodiscard]] auto count_memory_bytes(MemoryCounter& counter) const
+      -> qsizetype override {
+    return static_cast<qsizetype>(sizeof(SetCells)) +
+           count_list_bytes(counter, old_rows) +
+           count_list_bytes(counter, new_rows);
+  }
 };
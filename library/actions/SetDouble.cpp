@@ -1,20 +1,17 @@
 #include "actions/SetDouble.hpp"
 
-#include <fluidsynth.h>
-
 #include <QtWidgets/QSpinBox>
 
 #include "actions/ChangeId.hpp"
 #include "other/Song.hpp"
-#include "sound/FluidSynth.hpp"
+#include "sound/Player.hpp"
 
 namespace {
-void set_double(Song& song, FluidSynth& synth, const ChangeId control_id,
+void set_double(Song& song, Player& player, const ChangeId control_id,
                 QDoubleSpinBox& spin_box, const double set_value) {
   switch (control_id) {
     case ChangeId::gain_id:
-      fluid_synth_set_gain(synth.internal_pointer,
-                           static_cast<float>(set_value));
+      set_gain(player, set_value);
       break;
     case ChangeId::starting_key_id:
       song.starting_key = set_value;
@@ -46,9 +43,9 @@ auto SetDouble::mergeWith(const QUndoCommand* const next_command_pointer)
 }
 
 void SetDouble::undo() {
-  set_double(song, synth, control_id, spin_box, old_value);
+  set_double(song, player, control_id, spin_box, old_value);
 }
 
 void SetDouble::redo() {
-  set_double(song, synth, control_id, spin_box, new_value);
+  set_double(song, player, control_id, spin_box, new_value);
 }
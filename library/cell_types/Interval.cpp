@@ -17,6 +17,8 @@ Interval::Interval(Rational ratio_input, const int octave_input)
     ratio.denominator = ratio.denominator / 2;
     octave = octave - 1;
   }
+  log2_value =
+      std::log2(ratio.numerator) - std::log2(ratio.denominator) + octave;
 }
 
 auto Interval::operator==(const Interval& other_interval) const -> bool {
@@ -32,8 +34,7 @@ auto Interval::operator/(const Interval& other_interval) const -> Interval {
 }
 
 auto interval_to_double(const Interval& interval) -> double {
-  return rational_to_double(interval.ratio) *
-         pow(OCTAVE_RATIO, interval.octave);
+  return std::exp2(interval.log2_value);
 }
 
 void set_interval_from_xml(Interval& interval, xmlNode& node) {
@@ -7,6 +7,9 @@ static const auto OCTAVE_RATIO = 2.0;
 struct Interval {
   Rational ratio;
   int octave;
+  // log2 of the whole interval, worked out once, so it only takes an exp2 to
+  // turn into a ratio
+  double log2_value = 0;
 
   explicit Interval(Rational ratio_input = Rational(1, 1),
                     int octave_input = 0);
@@ -0,0 +1,63 @@
+#include "cell_types/Monzo.hpp"
+
+#include <cmath>
+
+#include "cell_types/Interval.hpp"
+
+namespace {
+
+void add_factors(Monzo& monzo, int value, const int sign) {
+  auto& exponents = monzo.exponents;
+  // 0 has every prime as a factor, so it would never stop dividing
+  if (value != 0) {
+    for (auto prime_number = 0; prime_number < NUMBER_OF_MONZO_PRIMES;
+         prime_number = prime_number + 1) {
+      const auto prime = MONZO_PRIMES.at(prime_number);
+      while (value % prime == 0) {
+        value = value / prime;
+        exponents.at(prime_number) = exponents.at(prime_number) + sign;
+      }
+    }
+  }
+  if (value != 1) {
+    monzo.other_log2 = monzo.other_log2 + sign * std::log2(value);
+  }
+}
+
+}  // namespace
+
+auto interval_to_monzo(const Interval& interval) -> Monzo {
+  Monzo monzo;
+  add_factors(monzo, interval.ratio.numerator, 1);
+  add_factors(monzo, interval.ratio.denominator, -1);
+  monzo.exponents.at(0) = monzo.exponents.at(0) + interval.octave;
+  return monzo;
+}
+
+void add_monzo(Monzo& monzo, const Monzo& other_monzo) {
+  auto& exponents = monzo.exponents;
+  for (auto prime_number = 0; prime_number < NUMBER_OF_MONZO_PRIMES;
+       prime_number = prime_number + 1) {
+    exponents.at(prime_number) =
+        exponents.at(prime_number) + other_monzo.exponents.at(prime_number);
+  }
+  monzo.other_log2 = monzo.other_log2 + other_monzo.other_log2;
+}
+
+auto monzo_to_log2(const Monzo& monzo) -> double {
+  static const auto prime_log2s = []() -> auto {
+    std::array<double, NUMBER_OF_MONZO_PRIMES> log2s{};
+    for (auto prime_number = 0; prime_number < NUMBER_OF_MONZO_PRIMES;
+         prime_number = prime_number + 1) {
+      log2s.at(prime_number) = std::log2(MONZO_PRIMES.at(prime_number));
+    }
+    return log2s;
+  }();
+  auto log2_value = monzo.other_log2;
+  for (auto prime_number = 0; prime_number < NUMBER_OF_MONZO_PRIMES;
+       prime_number = prime_number + 1) {
+    log2_value = log2_value + monzo.exponents.at(prime_number) *
+                                  prime_log2s.at(prime_number);
+  }
+  return log2_value;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <array>
+
+struct Interval;
+
+// the primes a Monzo keeps exact exponents for: every ratio in 31-limit
+// just intonation
+static const auto NUMBER_OF_MONZO_PRIMES = 11;
+static const std::array<int, NUMBER_OF_MONZO_PRIMES> MONZO_PRIMES = {
+    2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31};
+
+// a ratio as the exponents of its prime factors, e.g. 3/2 is 2^-1 * 3^1.
+// Multiplying ratios is then just adding exponents, which never rounds, so
+// a key modulated chord after chord lands exactly where it should, however
+// long the song
+struct Monzo {
+  std::array<int, NUMBER_OF_MONZO_PRIMES> exponents{};
+  // the log2 of any factors beyond MONZO_PRIMES, which can only be kept
+  // approximately
+  double other_log2 = 0;
+};
+
+[[nodiscard]] auto interval_to_monzo(const Interval& interval) -> Monzo;
+
+// multiplies the ratio monzo stands for by other_monzo's
+void add_monzo(Monzo& monzo, const Monzo& other_monzo);
+
+[[nodiscard]] auto monzo_to_log2(const Monzo& monzo) -> double;
@@ -2,6 +2,7 @@
 
 #include <fluidsynth.h>
 
+#include "other/Trace.hpp"
 #include "sound/FluidSettings.hpp"
 #include "sound/FluidSynth.hpp"
 
@@ -112,6 +113,7 @@ auto get_actual_release_milliseconds(FluidSynth& synth,
 
 auto get_some_programs(const bool is_pitched) -> const QList<Program>& {
   static const auto all_programs = []() -> QList<Program> {
+    const TraceSpan trace_span("get_some_programs");
     static const auto GENERAL_BANK_NUMBER = 0;
     static const auto GENERAL_EXPRESSIVE_BANK_NUMBER = 17;
     static const auto EXTRA_BANK_NUMBER = 8;
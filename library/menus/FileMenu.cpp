@@ -1,8 +1,36 @@
 #include "menus/FileMenu.hpp"
 
+#include <QtCore/QSettings>
+
 #include "widgets/SongWidget.hpp"
 #include "widgets/SwitchColumn.hpp"
 
+namespace {
+
+// a checkable action for each value, with the one the setting already has
+// checked; picking one saves it to the setting
+void add_setting_actions(QMenu& menu, QActionGroup& group,
+                         const char* const key,
+                         const QList<std::pair<QString, QVariant>>& choices,
+                         const QVariant& default_value) {
+  const auto current_value = QSettings().value(key, default_value);
+  for (const auto& [text, value] : choices) {
+    auto& action = get_reference(group.addAction(text));
+    action.setCheckable(true);
+    action.setData(value);
+    // settings files give back strings, whatever went in
+    action.setChecked(value.toString() == current_value.toString());
+    menu.addAction(&action);
+  }
+  QObject::connect(&group, &QActionGroup::triggered, &menu,
+                   [key](const QAction* const action_pointer) -> auto {
+                     QSettings().setValue(
+                         key, get_reference(action_pointer).data());
+                   });
+}
+
+}  // namespace
+
 auto make_file_dialog(SongWidget& song_widget, const char* const caption,
                       const QString& filter,
                       const QFileDialog::AcceptMode accept_mode,
@@ -34,7 +62,11 @@ FileMenu::FileMenu(SongWidget& song_widget)
       save_as_action(FileMenu::tr("&Save As...")),
       import_action(FileMenu::tr("&Import MusicXML")),
       export_action(FileMenu::tr("&Export recording")),
-      export_midi_action(FileMenu::tr("Export &MIDI")) {
+      export_midi_action(FileMenu::tr("Export &MIDI")),
+      export_tuned_midi_action(
+          FileMenu::tr("Export MIDI with &tuning messages")),
+      recording_format_menu(FileMenu::tr("&Recording format")),
+      sample_format_group(this), sample_rate_group(this) {
   auto& save_action_ref = this->save_action;
   add_menu_action(*this, open_action, QKeySequence::Open);
   add_menu_action(*this, import_action, QKeySequence::UnknownKey, true);
@@ -43,6 +75,25 @@ FileMenu::FileMenu(SongWidget& song_widget)
   add_menu_action(*this, save_as_action, QKeySequence::SaveAs);
   add_menu_action(*this, export_action);
   add_menu_action(*this, export_midi_action);
+  add_menu_action(*this, export_tuned_midi_action);
+  addMenu(&recording_format_menu);
+
+  add_setting_actions(recording_format_menu, sample_format_group,
+                      EXPORT_SAMPLE_FORMAT_KEY,
+                      {{FileMenu::tr("16-bit"), "s16"},
+                       {FileMenu::tr("24-bit"), "s24"},
+                       {FileMenu::tr("32-bit"), "s32"},
+                       {FileMenu::tr("32-bit float"), "float"}},
+                      AudioFileFormat().sample_format);
+  recording_format_menu.addSeparator();
+  add_setting_actions(recording_format_menu, sample_rate_group,
+                      EXPORT_SAMPLE_RATE_KEY,
+                      {{FileMenu::tr("22050 Hz"), 22050.0},
+                       {FileMenu::tr("44100 Hz"), 44100.0},
+                       {FileMenu::tr("48000 Hz"), 48000.0},
+                       {FileMenu::tr("88200 Hz"), 88200.0},
+                       {FileMenu::tr("96000 Hz"), 96000.0}},
+                      DEFAULT_SAMPLE_RATE);
 
   QObject::connect(
       &song_widget.undo_stack, &QUndoStack::cleanChanged, this,
@@ -76,25 +127,37 @@ FileMenu::FileMenu(SongWidget& song_widget)
   QObject::connect(
       &export_action, &QAction::triggered, this, [&song_widget]() -> auto {
         auto& dialog = make_file_dialog(
-            song_widget, "Export — Justly", "WAV file (*.wav)",
+            song_widget, "Export — Justly",
+            "WAV file (*.wav);;FLAC file (*.flac);;Ogg Vorbis file (*.ogg)",
             QFileDialog::AcceptSave, ".wav", QFileDialog::AnyFile);
         dialog.setLabelText(QFileDialog::Accept, "Export");
+        // the file type goes by the extension (see get_export_file_format),
+        // so a name typed without one gets the chosen filter's
+        QObject::connect(&dialog, &QFileDialog::filterSelected, &dialog,
+                         [&dialog](const QString& filter) -> auto {
+                           dialog.setDefaultSuffix(
+                               filter.section("*", 1).chopped(1));
+                         });
         if (dialog.exec() != 0) {
           export_to_file(song_widget, get_selected_file(song_widget, dialog));
         }
         dialog.deleteLater();
       });
 
-  QObject::connect(
-      &export_midi_action, &QAction::triggered, this, [&song_widget]() -> auto {
-        auto& dialog = make_file_dialog(
-            song_widget, "Export MIDI — Justly", "MIDI file (*.mid)",
-            QFileDialog::AcceptSave, ".mid", QFileDialog::AnyFile);
-        dialog.setLabelText(QFileDialog::Accept, "Export");
-        if (dialog.exec() != 0) {
-          export_midi_to_file(song_widget,
-                              get_selected_file(song_widget, dialog));
-        }
-        dialog.deleteLater();
-      });
+  const auto export_midi = [&song_widget](
+                               const bool use_tuning_messages) -> auto {
+    auto& dialog = make_file_dialog(
+        song_widget, "Export MIDI — Justly", "MIDI file (*.mid)",
+        QFileDialog::AcceptSave, ".mid", QFileDialog::AnyFile);
+    dialog.setLabelText(QFileDialog::Accept, "Export");
+    if (dialog.exec() != 0) {
+      export_midi_to_file(song_widget, get_selected_file(song_widget, dialog),
+                          use_tuning_messages);
+    }
+    dialog.deleteLater();
+  };
+  QObject::connect(&export_midi_action, &QAction::triggered, this,
+                   [export_midi]() -> auto { export_midi(false); });
+  QObject::connect(&export_tuned_midi_action, &QAction::triggered, this,
+                   [export_midi]() -> auto { export_midi(true); });
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <QtGui/QActionGroup>
 #include <QtWidgets/QFileDialog>
 #include <QtWidgets/QMenu>
 
@@ -22,6 +23,12 @@ struct FileMenu : public QMenu {
   QAction import_action;
   QAction export_action;
   QAction export_midi_action;
+  QAction export_tuned_midi_action;
+  // the sample format and rate recordings are exported with; the file type
+  // comes from the export dialog instead
+  QMenu recording_format_menu;
+  QActionGroup sample_format_group;
+  QActionGroup sample_rate_group;
 
   explicit FileMenu(SongWidget& song_widget);
 };
@@ -1,5 +1,6 @@
 #include "menus/PasteMenu.hpp"
 
+#include "other/Trace.hpp"
 #include "widgets/SwitchColumn.hpp"
 #include "widgets/SwitchTable.hpp"
 
@@ -20,6 +21,7 @@ auto get_mime_description(const QString& mime_type) -> QString {
 namespace {
 
 void add_paste_insert(SongWidget& song_widget, const int row_number) {
+  const TraceSpan trace_span("paste_insert");
   auto& switch_column = song_widget.switch_column;
   auto& switch_table = switch_column.switch_table;
 
@@ -49,6 +51,7 @@ PasteMenu::PasteMenu(SongWidget& song_widget)
 
   QObject::connect(
       &paste_over_action, &QAction::triggered, this, [&song_widget]() -> auto {
+        const TraceSpan trace_span("paste_over");
         auto& switch_table = song_widget.switch_column.switch_table;
 
         const auto first_row_number = get_only_range(switch_table).top();
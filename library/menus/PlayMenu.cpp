@@ -4,21 +4,6 @@
 #include "widgets/SwitchColumn.hpp"
 #include "widgets/SwitchTable.hpp"
 
-namespace {
-
-void modulate_before_chord(const Song& song, PlayState& play_state,
-                           const int next_chord_number) {
-  const auto& chords = song.chords;
-  if (next_chord_number > 0) {
-    std::ranges::for_each(chords | std::views::take(next_chord_number),
-                          [&play_state](const auto& chord) -> void {
-                            modulate(play_state, chord);
-                          });
-  }
-}
-
-}  // namespace
-
 auto get_play_selection(const SongWidget& song_widget) -> PlaySelection {
   const auto& switch_table = song_widget.switch_column.switch_table;
   const auto& range = get_only_range(switch_table);
@@ -28,59 +13,153 @@ auto get_play_selection(const SongWidget& song_widget) -> PlaySelection {
           .number_of_rows = get_number_of_rows(range)};
 }
 
+auto is_audition(const PlaySelection& play_selection) -> bool {
+  switch (play_selection.row_type) {
+    case RowType::chord_type:
+      return false;
+    case RowType::pitched_note_type:
+    case RowType::unpitched_note_type:
+      return play_selection.number_of_rows == 1;
+    case RowType::pitched_voice_type:
+    case RowType::unpitched_voice_type:
+      return true;
+  }
+  Q_UNREACHABLE();
+}
+
+namespace {
+
+// which of the playback plan's notes playing selection would sound, for
+// anything that isn't an audition
+auto get_selected_planned_notes(SongWidget& song_widget,
+                                const PlaySelection& selection)
+    -> std::span<const PlannedNote> {
+  const auto& playback_plan = get_playback_plan(song_widget);
+  const auto row_type = selection.row_type;
+  if (row_type == RowType::chord_type) {
+    return get_planned_chords(playback_plan, selection.first_row_number,
+                              selection.number_of_rows);
+  }
+  return get_planned_notes(playback_plan, selection.chord_number,
+                           row_type == RowType::pitched_note_type,
+                           selection.first_row_number,
+                           selection.number_of_rows);
+}
+
+// how long playing selection live takes, from the start of its chord
+auto get_selected_duration(SongWidget& song_widget,
+                           const PlaySelection& selection) -> double {
+  const auto& playback_plan = get_playback_plan(song_widget);
+  if (selection.row_type == RowType::chord_type) {
+    const auto first_chord_number = selection.first_row_number;
+    return get_chord_start_time(playback_plan,
+                                first_chord_number + selection.number_of_rows) -
+           get_chord_start_time(playback_plan, first_chord_number);
+  }
+  const auto chord_number = selection.chord_number;
+  return get_chord_start_time(playback_plan, chord_number + 1) -
+         get_chord_start_time(playback_plan, chord_number);
+}
+
+auto play_pre_rendered_selection(const PlayMenu& play_menu,
+                                 SongWidget& song_widget,
+                                 const PlaySelection& selection) -> bool {
+  return song_widget.player.use_pre_rendering &&
+         play_menu.pre_render_request_number > 0 &&
+         play_menu.pre_render_song_revision == song_widget.song_revision &&
+         play_menu.pre_render_selection == selection &&
+         play_pre_rendered(song_widget.player,
+                           play_menu.pre_render_request_number,
+                           get_selected_duration(song_widget, selection));
+}
+
+}  // namespace
+
+void update_pre_render(PlayMenu& play_menu, SongWidget& song_widget) {
+  if (!song_widget.player.use_pre_rendering ||
+      get_selection_model(song_widget.switch_column.switch_table)
+              .selection()
+              .size() != 1) {
+    return;
+  }
+  const auto selection = get_play_selection(song_widget);
+  if (selection.row_type == RowType::pitched_voice_type ||
+      selection.row_type == RowType::unpitched_voice_type ||
+      is_audition(selection) ||
+      (play_menu.pre_render_song_revision == song_widget.song_revision &&
+       play_menu.pre_render_selection == selection)) {
+    return;
+  }
+  play_menu.pre_render_selection = selection;
+  play_menu.pre_render_song_revision = song_widget.song_revision;
+  play_menu.pre_render_request_number = request_pre_render(
+      song_widget.player, get_selected_planned_notes(song_widget, selection),
+      get_chord_start_time(get_playback_plan(song_widget),
+                           selection.row_type == RowType::chord_type
+                               ? selection.first_row_number
+                               : selection.chord_number));
+}
+
 PlayMenu::PlayMenu(SongWidget& song_widget)
     : QMenu(PlayMenu::tr("&Play")),
       play_action(PlayMenu::tr("&Play selection")),
       play_to_end_action(PlayMenu::tr("Play to &end")),
-      stop_playing_action(PlayMenu::tr("&Stop playing")) {
+      stop_playing_action(PlayMenu::tr("&Stop playing")),
+      key_tuning_action(PlayMenu::tr("Share channels with key &tuning")),
+      pre_render_action(PlayMenu::tr("Pre-&render selection")) {
   add_menu_action(*this, play_action, QKeySequence::UnknownKey, false);
   play_action.setShortcut(Qt::Key_Space);
   add_menu_action(*this, play_to_end_action, QKeySequence::UnknownKey, false);
   play_to_end_action.setShortcut(Qt::ShiftModifier | Qt::Key_Space);
   add_menu_action(*this, stop_playing_action, QKeySequence::Cancel);
+  addSeparator();
+  key_tuning_action.setCheckable(true);
+  add_menu_action(*this, key_tuning_action);
+  pre_render_action.setCheckable(true);
+  add_menu_action(*this, pre_render_action);
 
-  const auto& player = song_widget.player;
+  auto& player = song_widget.player;
   QObject::connect(
-      &play_action, &QAction::triggered, this, [&song_widget]() -> auto {
+      &play_action, &QAction::triggered, this, [this, &song_widget]() -> auto {
         const auto& song = song_widget.song;
         const auto& pitched_voices = song.pitched_voices;
         const auto& unpitched_voices = song.unpitched_voices;
         auto& player = song_widget.player;
-        auto& play_state = player.play_state;
 
         const auto selection = get_play_selection(song_widget);
         const auto current_row_type = selection.row_type;
         const auto first_row_number = selection.first_row_number;
         const auto number_of_rows = selection.number_of_rows;
 
-        stop_playing(player.sequencer, player.event);
+        stop_playing(player);
         initialize_play(song_widget);
 
         switch (current_row_type) {
           case RowType::chord_type:
-            modulate_before_chord(song, play_state, first_row_number);
-            play_chords(song_widget, first_row_number, number_of_rows);
+            // falls back on live playback while the render is in progress
+            if (!play_pre_rendered_selection(*this, song_widget,
+                                             selection) &&
+                !play_chords(song_widget, first_row_number, number_of_rows)) {
+              return;
+            }
             break;
           case RowType::pitched_note_type:
           case RowType::unpitched_note_type: {
             const auto chord_number = selection.chord_number;
-            modulate_before_chord(song, play_state, chord_number);
-            const auto& chord = song.chords.at(chord_number);
-            modulate(play_state, chord);
-            if (current_row_type == RowType::pitched_note_type) {
-              const auto pitched_result = play_notes(
-                  player, pitched_voices, unpitched_voices, chord_number,
-                  chord.pitched_notes, first_row_number, number_of_rows);
-              if (!pitched_result) {
-                return;
-              }
-            } else {
-              const auto unpitched_result = play_notes(
-                  player, pitched_voices, unpitched_voices, chord_number,
-                  chord.unpitched_notes, first_row_number, number_of_rows);
-              if (!unpitched_result) {
+            const auto is_pitched =
+                current_row_type == RowType::pitched_note_type;
+            if (play_pre_rendered_selection(*this, song_widget, selection)) {
+              break;
+            }
+            if (is_audition(selection)) {
+              if (!audition_chord_note(song_widget, chord_number, is_pitched,
+                                       first_row_number)) {
                 return;
               }
+            } else if (!play_chord_notes(song_widget, chord_number,
+                                         is_pitched, first_row_number,
+                                         number_of_rows)) {
+              return;
             }
             break;
           }
@@ -105,51 +184,33 @@ PlayMenu::PlayMenu(SongWidget& song_widget)
         const auto& pitched_voices = song.pitched_voices;
         const auto& unpitched_voices = song.unpitched_voices;
         auto& player = song_widget.player;
-        auto& play_state = player.play_state;
-        const auto number_of_chords = static_cast<int>(song.chords.size());
 
         const auto selection = get_play_selection(song_widget);
         const auto current_row_type = selection.row_type;
         const auto first_row_number = selection.first_row_number;
 
-        stop_playing(player.sequencer, player.event);
+        stop_playing(player);
         initialize_play(song_widget);
 
         switch (current_row_type) {
           case RowType::chord_type:
-            modulate_before_chord(song, play_state, first_row_number);
-            play_chords(song_widget, first_row_number,
-                        number_of_chords - first_row_number);
+            play_chords_to_end(song_widget, first_row_number);
             break;
           case RowType::pitched_note_type:
           case RowType::unpitched_note_type: {
             const auto chord_number = selection.chord_number;
-            modulate_before_chord(song, play_state, chord_number);
+            const auto is_pitched =
+                current_row_type == RowType::pitched_note_type;
             const auto& chord = song.chords.at(chord_number);
-            modulate(play_state, chord);
-            if (current_row_type == RowType::pitched_note_type) {
-              const auto pitched_result = play_notes(
-                  player, pitched_voices, unpitched_voices, chord_number,
-                  chord.pitched_notes, first_row_number,
-                  static_cast<int>(chord.pitched_notes.size()) -
-                      first_row_number);
-              if (!pitched_result) {
-                return;
-              }
-            } else {
-              const auto unpitched_result = play_notes(
-                  player, pitched_voices, unpitched_voices, chord_number,
-                  chord.unpitched_notes, first_row_number,
-                  static_cast<int>(chord.unpitched_notes.size()) -
-                      first_row_number);
-              if (!unpitched_result) {
-                return;
-              }
+            const auto number_of_notes =
+                static_cast<int>(is_pitched ? chord.pitched_notes.size()
+                                            : chord.unpitched_notes.size());
+            if (!play_chord_notes(song_widget, chord_number, is_pitched,
+                                  first_row_number,
+                                  number_of_notes - first_row_number)) {
+              return;
             }
-            move_time(play_state, chord);
-            update_final_time(player, play_state.current_time);
-            play_chords(song_widget, chord_number + 1,
-                        number_of_chords - chord_number - 1);
+            play_chords_to_end(song_widget, chord_number + 1);
             break;
           }
           case RowType::pitched_voice_type:
@@ -162,5 +223,24 @@ PlayMenu::PlayMenu(SongWidget& song_widget)
 
   QObject::connect(
       &stop_playing_action, &QAction::triggered, this,
-      [&player]() -> auto { stop_playing(player.sequencer, player.event); });
+      [&player]() -> auto { stop_playing(player); });
+
+  // takes effect from the next play, since initialize_play is what clears
+  // out tunings left over from the other mode
+  QObject::connect(&key_tuning_action, &QAction::toggled, this,
+                   [&player](const bool checked) -> auto {
+                     player.use_key_tuning = checked;
+                   });
+
+  QObject::connect(&pre_render_action, &QAction::toggled, this,
+                   [this, &song_widget](const bool checked) -> auto {
+                     song_widget.player.use_pre_rendering = checked;
+                     update_pre_render(*this, song_widget);
+                   });
+  // an edit changes what the selection sounds like, even when the
+  // selection itself stays put
+  QObject::connect(&song_widget.undo_stack, &QUndoStack::indexChanged, this,
+                   [this, &song_widget]() -> auto {
+                     update_pre_render(*this, song_widget);
+                   });
 }
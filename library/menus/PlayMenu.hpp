@@ -10,15 +10,33 @@ struct PlaySelection {
   int chord_number;  // -1 unless row_type is a note type
   int first_row_number;
   int number_of_rows;
+
+  [[nodiscard]] auto operator==(const PlaySelection& other) const
+      -> bool = default;
 };
 
 [[nodiscard]] auto get_play_selection(const SongWidget& song_widget)
     -> PlaySelection;
 
+// voices and lone notes get previewed straight on the synth, for the
+// quickest feedback (see Auditioner), instead of played through the sequencer
+[[nodiscard]] auto is_audition(const PlaySelection& play_selection) -> bool;
+
 struct PlayMenu : public QMenu {
   QAction play_action;
   QAction play_to_end_action;
   QAction stop_playing_action;
+  QAction key_tuning_action;
+  QAction pre_render_action;
+
+  // what the newest pre-render (see PreRenderer) is of
+  PlaySelection pre_render_selection{};
+  int pre_render_song_revision = -1;
+  int pre_render_request_number = 0;
 
   explicit PlayMenu(SongWidget& song_widget);
 };
+
+// starts rendering the current selection ahead of time, if pre-rendering is
+// on and it hasn't been already
+void update_pre_render(PlayMenu& play_menu, SongWidget& song_widget);
@@ -10,6 +10,8 @@ ViewMenu::ViewMenu()
       previous_chord_action(ViewMenu::tr("&Previous chord")),
       next_chord_action(ViewMenu::tr("&Next chord")),
       show_piano_roll_action(ViewMenu::tr("&Piano roll")),
+      show_performance_action(ViewMenu::tr("Pe&rformance")),
+      memory_report_action(ViewMenu::tr("&Memory report")),
       zoom_in_action(ViewMenu::tr("Zoom &in")),
       zoom_out_action(ViewMenu::tr("Zoom &out")) {
   add_menu_action(*this, back_to_chords_action, QKeySequence::Back, false);
@@ -25,6 +27,11 @@ ViewMenu::ViewMenu()
   add_menu_action(*this, show_piano_roll_action, QKeySequence::UnknownKey,
                   true);
   show_piano_roll_action.setCheckable(true);
+  add_menu_action(*this, show_performance_action, QKeySequence::UnknownKey,
+                  true);
+  show_performance_action.setCheckable(true);
+  add_menu_action(*this, memory_report_action, QKeySequence::UnknownKey,
+                  true);
 
   add_menu_action(*this, zoom_in_action, QKeySequence::ZoomIn, true);
   add_menu_action(*this, zoom_out_action, QKeySequence::ZoomOut, true);
@@ -9,6 +9,8 @@ struct ViewMenu : public QMenu {
   QAction previous_chord_action;
   QAction next_chord_action;
   QAction show_piano_roll_action;
+  QAction show_performance_action;
+  QAction memory_report_action;
   QAction zoom_in_action;
   QAction zoom_out_action;
 
@@ -3,7 +3,23 @@
 #include "other/Song.hpp"
 
 ChordsModel::ChordsModel(QUndoStack& undo_stack, Song& song_input)
-    : UndoRowsModel(undo_stack, song_input) {}
+    : UndoRowsModel(undo_stack, song_input) {
+  // repeats go by chord number, so they have to follow their chords around
+  QObject::connect(
+      this, &QAbstractItemModel::rowsInserted, this,
+      [this](const QModelIndex& /*parent*/, const int first_row_number,
+             const int last_row_number) -> auto {
+        insert_repeat_chords(song.repeats, first_row_number,
+                             last_row_number - first_row_number + 1);
+      });
+  QObject::connect(
+      this, &QAbstractItemModel::rowsRemoved, this,
+      [this](const QModelIndex& /*parent*/, const int first_row_number,
+             const int last_row_number) -> auto {
+        remove_repeat_chords(song.repeats, first_row_number,
+                             last_row_number - first_row_number + 1);
+      });
+}
 
 void ChordsModel::add_to_status(QTextStream& stream, const int row_number,
                                 const Chord& chord) const {
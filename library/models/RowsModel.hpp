@@ -12,6 +12,11 @@ struct RowsModel : public QAbstractTableModel {
   QItemSelectionModel* selection_model_pointer = nullptr;
   QList<SubRow>* rows_pointer = nullptr;
   int parent_chord_number = -1;
+  // what each cell displays, worked out the first time it's painted, so
+  // scrolling and repainting are a lookup rather than a reformat. A row of
+  // cells per row, with an invalid QVariant for a cell not worked out yet;
+  // every change to the rows below clears just the cells it touches
+  mutable QList<QVariant> display_cache;
 
   explicit RowsModel(Song& song_input) : song(song_input) {}
 
@@ -28,9 +33,36 @@ struct RowsModel : public QAbstractTableModel {
     QAbstractTableModel::beginResetModel();
     rows_pointer = new_rows_pointer;
     parent_chord_number = new_parent_chord_number;
+    display_cache.clear();
+    if (new_rows_pointer != nullptr) {
+      display_cache.resize(new_rows_pointer->size() *
+                           SubRow::get_number_of_columns());
+    }
     QAbstractTableModel::endResetModel();
   }
 
+  void clear_display_cache(const int first_row_number,
+                           const int number_of_rows, const int left_column,
+                           const int right_column) {
+    const auto number_of_columns = SubRow::get_number_of_columns();
+    for (auto row_number = first_row_number;
+         row_number < first_row_number + number_of_rows;
+         row_number = row_number + 1) {
+      for (auto column_number = left_column; column_number <= right_column;
+           column_number = column_number + 1) {
+        display_cache[(row_number * number_of_columns) + column_number] =
+            QVariant();
+      }
+    }
+  }
+
+  void insert_display_cache_rows(const int first_row_number,
+                                 const int number_of_rows) {
+    const auto number_of_columns = SubRow::get_number_of_columns();
+    display_cache.insert(first_row_number * number_of_columns,
+                         number_of_rows * number_of_columns, QVariant());
+  }
+
   [[nodiscard]] auto rowCount(const QModelIndex& /*parent_index*/) const
       -> int override {
     if (!is_valid()) {
@@ -70,10 +102,27 @@ struct RowsModel : public QAbstractTableModel {
   virtual void add_to_status(QTextStream& /*stream*/, const int /*row_number*/,
                              const SubRow& /*row*/) const {}
 
+  // only editable columns are cached: the others, like a chord's number of
+  // notes, can change without this model knowing
   [[nodiscard]] virtual auto get_display_data(const int row_number,
                                               const int column_number) const
       -> QVariant {
-    return get_rows().at(row_number).get_data(column_number);
+    const auto& row = get_rows().at(row_number);
+    if (!SubRow::is_column_editable(column_number)) {
+      return row.get_data(column_number);
+    }
+    auto& cached_value =
+        display_cache[(row_number * SubRow::get_number_of_columns()) +
+                      column_number];
+    if (!cached_value.isValid()) {
+      cached_value = row.get_data(column_number);
+      // our own types, like Rational and Interval, only display as text
+      // through the converters SongEditor registers, which is the slow part
+      if (cached_value.metaType().id() >= QMetaType::User) {
+        cached_value = cached_value.toString();
+      }
+    }
+    return cached_value;
   }
 
   [[nodiscard]] auto data(const QModelIndex& index, const int role) const
@@ -112,6 +161,7 @@ struct RowsModel : public QAbstractTableModel {
     const auto column_number = set_index.column();
 
     get_rows()[row_number].set_data(column_number, new_value);
+    clear_display_cache(row_number, 1, column_number, column_number);
     dataChanged(set_index, set_index);
     get_reference(selection_model_pointer)
         .select(set_index,
@@ -141,6 +191,8 @@ struct RowsModel : public QAbstractTableModel {
         row.copy_column_from(new_row, column_number);
       }
     }
+    clear_display_cache(first_row_number, static_cast<int>(number_of_new_rows),
+                        left_column, right_column);
     dataChanged(top_left_index, bottom_right_index);
     get_reference(selection_model_pointer)
         .select(QItemSelection(top_left_index, bottom_right_index),
@@ -168,25 +220,42 @@ struct RowsModel : public QAbstractTableModel {
         row.copy_column_from(empty_row, column_number);
       }
     }
+    clear_display_cache(first_row_number, number_of_rows, left_column,
+                        right_column);
     dataChanged(top_left_index, bottom_right_index);
     get_reference(selection_model_pointer)
         .select(QItemSelection(top_left_index, bottom_right_index),
                 QItemSelectionModel::Select | QItemSelectionModel::Clear);
   }
 
-  void insert_xml_rows(const int first_row_number, xmlNode& rows_node) {
-    QList<SubRow> new_rows;
-    xml_to_rows(new_rows, rows_node);
+  // unlike insert_rows, leaves the selection alone, for loading a file. All
+  // the rows go in with a single notification, however many there are, and
+  // into an empty model, without so much as a copy
+  void insert_loaded_rows(const int first_row_number, QList<SubRow> new_rows) {
     const auto number_of_rows = static_cast<int>(new_rows.size());
+    if (number_of_rows == 0) {
+      return;
+    }
 
     auto& rows = get_rows();
     beginInsertRows(QModelIndex(), first_row_number,
                     first_row_number + number_of_rows - 1);
-    std::copy(new_rows.cbegin(), new_rows.cend(),
-              std::inserter(rows, rows.begin() + first_row_number));
+    if (rows.empty()) {
+      rows = std::move(new_rows);
+    } else {
+      std::move(new_rows.begin(), new_rows.end(),
+                std::inserter(rows, rows.begin() + first_row_number));
+    }
+    insert_display_cache_rows(first_row_number, number_of_rows);
     endInsertRows();
   }
 
+  void insert_xml_rows(const int first_row_number, xmlNode& rows_node) {
+    QList<SubRow> new_rows;
+    xml_to_rows(new_rows, rows_node);
+    insert_loaded_rows(first_row_number, std::move(new_rows));
+  }
+
   void insert_rows(const int first_row_number, const QList<SubRow>& new_rows,
                    const int left_column, const int right_column) {
     auto& rows = get_rows();
@@ -195,6 +264,7 @@ struct RowsModel : public QAbstractTableModel {
                     first_row_number + number_of_rows - 1);
     std::copy(new_rows.cbegin(), new_rows.cend(),
               std::inserter(rows, rows.begin() + first_row_number));
+    insert_display_cache_rows(first_row_number, number_of_rows);
     endInsertRows();
     get_reference(selection_model_pointer)
         .select(QItemSelection(
@@ -207,6 +277,7 @@ struct RowsModel : public QAbstractTableModel {
     beginInsertRows(QModelIndex(), row_number, row_number);
     auto& rows = get_rows();
     rows.insert(rows.begin() + row_number, std::move(new_row));
+    insert_display_cache_rows(row_number, 1);
     endInsertRows();
     get_reference(selection_model_pointer)
         .select(index(row_number, 0), QItemSelectionModel::Select |
@@ -220,6 +291,9 @@ struct RowsModel : public QAbstractTableModel {
                     first_row_number + number_of_rows - 1);
     rows.erase(rows.begin() + first_row_number,
                rows.begin() + first_row_number + number_of_rows);
+    const auto number_of_columns = SubRow::get_number_of_columns();
+    display_cache.remove(first_row_number * number_of_columns,
+                         number_of_rows * number_of_columns);
     endRemoveRows();
   }
 };
\ No newline at end of file
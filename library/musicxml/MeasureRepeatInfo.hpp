@@ -10,3 +10,15 @@ struct MeasureRepeatInfo {
   int repeat_times = 2;
   QList<int> ending_numbers;
 };
+
+// a repeated block of measures, by index into a part's measures; the last
+// measure includes any later endings that follow the backward repeat
+struct MeasureRepeat {
+  int first_measure_index = 0;
+  int last_measure_index = 0;
+  int times = 2;
+  bool has_endings = false;
+
+  [[nodiscard]] auto operator==(const MeasureRepeat& other) const
+      -> bool = default;
+};
@@ -0,0 +1,1026 @@
+#include "musicxml/MusicXMLImport.hpp"
+
+#include <QtCore/QObject>
+#include <QtCore/QSet>
+#include <QtCore/QTextStream>
+#include <algorithm>
+#include <numeric>
+
+#include "iterators/MostRecentIterator.hpp"
+#include "iterators/TimeIterator.hpp"
+#include "musicxml/MeasureRepeatInfo.hpp"
+#include "musicxml/MusicXMLChord.hpp"
+#include "musicxml/PartInfo.hpp"
+#include "other/StringPool.hpp"
+#include "other/Trace.hpp"
+#include "rows/Chord.hpp"
+#include "rows/PitchedNote.hpp"
+#include "rows/UnpitchedNote.hpp"
+#include "xml/XMLDocument.hpp"
+#include "xml/XMLValidator.hpp"
+#include "xml/ZipArchive.hpp"
+
+namespace {
+
+auto get_property(xmlNode& node, const char* name) -> std::string {
+  return xml_string_to_string(xmlGetProp(&node, c_string_to_xml_string(name)));
+}
+
+// some musicxml fields (e.g. fifths, octave-change, repeat times) are
+// unbounded xs:integer with no schema-enforced range, so a malformed or
+// hostile file can contain a magnitude that overflows int; used to reject
+// such a file with a warning instead of letting string_to_int assert
+auto get_int_or_warn(UserWarning& warning, const std::string& content,
+                     const QString& title, const QString& message)
+    -> std::optional<int> {
+  auto maybe_int = string_to_maybe_int(content);
+  if (!maybe_int.has_value()) {
+    warning = {.title = title, .message = message};
+  }
+  return maybe_int;
+}
+
+auto get_int_or_warn(UserWarning& warning, const xmlNode& element,
+                     const QString& title, const QString& message)
+    -> std::optional<int> {
+  return get_int_or_warn(warning, get_content(element), title, message);
+}
+
+auto node_is(const xmlNode& node, const char* name) -> bool {
+  return get_xml_name(node) == name;
+}
+
+auto maybe_get_xml_child(xmlNode& node, const char* name) -> xmlNode* {
+  auto* child_pointer = xmlFirstElementChild(&node);
+  while (child_pointer != nullptr) {
+    if (node_is(get_reference(child_pointer), name)) {
+      return child_pointer;
+    }
+    child_pointer = xmlNextElementSibling(child_pointer);
+  }
+  return nullptr;
+}
+
+auto get_xml_child(xmlNode& node, const char* name) -> xmlNode& {
+  return get_reference(maybe_get_xml_child(node, name));
+}
+
+auto get_duration(UserWarning& warning, xmlNode& measure_element)
+    -> std::optional<int> {
+  auto& duration_element = get_xml_child(measure_element, "duration");
+  if (!xml_content_is_integer(duration_element)) {
+    warning = {.title = QObject::tr("Duration error"),
+               .message = QObject::tr(
+                   "Fractional durations are not supported")};
+    return std::nullopt;
+  }
+  return get_int_or_warn(warning, duration_element,
+                         QObject::tr("Duration error"),
+                         QObject::tr("Duration is out of range"));
+}
+
+auto get_interval(const int midi_interval) -> Interval {
+  const auto [octave, degree] = get_octave_degree(midi_interval);
+  static const QList<Rational> scale = {
+      Rational(1, 1), Rational(16, 15), Rational(9, 8),   Rational(6, 5),
+      Rational(5, 4), Rational(4, 3),   Rational(45, 32), Rational(3, 2),
+      Rational(8, 5), Rational(5, 3),   Rational(9, 5),   Rational(15, 8)};
+  return Interval(scale[degree], octave);
+}
+
+auto get_max_duration(const QList<MusicXMLNote>& notes) -> int {
+  if (notes.empty()) {
+    return 0;
+  }
+  return std::ranges::max_element(notes,
+                                  [](const MusicXMLNote& first_note,
+                                     const MusicXMLNote& second_note) -> auto {
+                                    return first_note.duration <
+                                           second_note.duration;
+                                  })
+      ->duration;
+}
+
+// every note of a part has the same words, so string_pool keeps a big
+// import from holding a copy per note
+void add_chord(QList<Chord>& chords, StringPool& string_pool,
+               const MusicXMLChord& parse_chord, const int measure_number,
+               const int key, const int last_midi_key,
+               const int song_divisions, const int time_delta) {
+  Chord new_chord;
+  new_chord.beats = Rational(time_delta, song_divisions);
+  new_chord.interval = get_interval(key - last_midi_key);
+  new_chord.words =
+      get_pooled_string(string_pool, QString::number(measure_number));
+  auto& unpitched_notes = new_chord.unpitched_notes;
+  unpitched_notes.reserve(parse_chord.unpitched_notes.size());
+  for (const auto& parse_unpitched_note : parse_chord.unpitched_notes) {
+    UnpitchedNote new_note;
+    new_note.beats = Rational(parse_unpitched_note.duration, song_divisions);
+    new_note.words =
+        get_pooled_string(string_pool, parse_unpitched_note.words);
+    new_note.voice_number = parse_unpitched_note.voice_number;
+    unpitched_notes.push_back(std::move(new_note));
+  }
+  auto& pitched_notes = new_chord.pitched_notes;
+  pitched_notes.reserve(parse_chord.pitched_notes.size());
+  for (const auto& parse_pitched_note : parse_chord.pitched_notes) {
+    PitchedNote new_note;
+    new_note.beats = Rational(parse_pitched_note.duration, song_divisions);
+    new_note.words = get_pooled_string(string_pool, parse_pitched_note.words);
+    new_note.interval = get_interval(parse_pitched_note.midi_number - key);
+    new_note.voice_number = parse_pitched_note.voice_number;
+    pitched_notes.push_back(std::move(new_note));
+  }
+  chords.push_back(std::move(new_chord));
+}
+
+void add_note(MusicXMLChord& chord, MusicXMLNote note, bool is_pitched) {
+  (is_pitched ? chord.pitched_notes : chord.unpitched_notes)
+      .push_back(std::move(note));
+}
+
+void add_note_and_maybe_chord(QMap<int, MusicXMLChord>& chords_dict,
+                              MusicXMLNote note, bool is_pitched) {
+  const auto start_time = note.start_time;
+  if (chords_dict.contains(start_time)) {
+    add_note(chords_dict[start_time], std::move(note), is_pitched);
+  } else {
+    MusicXMLChord new_chord;
+    add_note(new_chord, std::move(note), is_pitched);
+    chords_dict[start_time] = std::move(new_chord);
+  }
+}
+
+auto get_most_recent(MostRecentIterator& iterator, const int time) -> int {
+  auto& iterator_state = iterator.state;
+  auto& iterator_value = iterator.value;
+  const auto& iterator_end = iterator.end;
+  while (iterator_state != iterator_end && iterator_state.key() <= time) {
+    iterator_value = iterator_state.value();
+    ++iterator_state;
+  }
+  return iterator_value;
+}
+
+}  // namespace
+
+void reset(TimeIterator& iterator) {
+  iterator.state = iterator.dict.begin();
+  iterator.last_change_time = 0;
+  iterator.next_change_divisions_time = 0;
+  iterator.time_per_division = 1;
+}
+
+auto get_measure_repeats(const QList<MeasureRepeatInfo>& measure_infos)
+    -> QList<MeasureRepeat> {
+  QList<MeasureRepeat> measure_repeats;
+  const auto number_of_measures = static_cast<int>(measure_infos.size());
+  auto repeat_start_index = -1;
+  auto block_start_index = 0;
+
+  auto measure_index = 0;
+  while (measure_index < number_of_measures) {
+    const auto& measure_info = measure_infos.at(measure_index);
+    if (measure_info.has_forward_repeat) {
+      repeat_start_index = measure_index;
+      block_start_index = measure_index;
+    }
+    if (measure_info.has_backward_repeat) {
+      const auto start_index =
+          repeat_start_index == -1 ? block_start_index : repeat_start_index;
+      // a later ending (e.g. the second ending) has no repeat barline of
+      // its own; it just continues on directly after the measure with the
+      // backward repeat, so absorb any immediately-following ending measures
+      auto block_end_index = measure_index;
+      while (block_end_index + 1 < number_of_measures &&
+             !measure_infos.at(block_end_index + 1).ending_numbers.isEmpty()) {
+        block_end_index = block_end_index + 1;
+      }
+      measure_repeats.push_back(MeasureRepeat{
+          .first_measure_index = start_index,
+          .last_measure_index = block_end_index,
+          .times = measure_info.repeat_times,
+          .has_endings = std::any_of(
+              measure_infos.begin() + start_index,
+              measure_infos.begin() + block_end_index + 1,
+              [](const MeasureRepeatInfo& inner_measure) -> auto {
+                return !inner_measure.ending_numbers.isEmpty();
+              })});
+      measure_index = block_end_index;
+      block_start_index = block_end_index + 1;
+      repeat_start_index = -1;
+    }
+    measure_index = measure_index + 1;
+  }
+  return measure_repeats;
+}
+
+auto compute_measure_expansion(const QList<MeasureRepeatInfo>& measure_infos,
+                               const QList<MeasureRepeat>& folded_repeats)
+    -> QList<std::pair<int, int>> {
+  QList<std::pair<int, int>> expansion;
+
+  const auto flush = [&](const int first_index, const int last_index) -> auto {
+    for (auto index = first_index; index <= last_index; index = index + 1) {
+      const auto& measure_info = measure_infos.at(index);
+      expansion.push_back({measure_info.start_time, measure_info.end_time});
+    }
+  };
+
+  auto next_index = 0;
+  for (const auto& measure_repeat : get_measure_repeats(measure_infos)) {
+    const auto first_index = measure_repeat.first_measure_index;
+    const auto last_index = measure_repeat.last_measure_index;
+    flush(next_index, first_index - 1);
+    if (folded_repeats.contains(measure_repeat)) {
+      flush(first_index, last_index);
+    } else {
+      for (auto pass_number = 1; pass_number <= measure_repeat.times;
+           pass_number = pass_number + 1) {
+        for (auto inner_index = first_index; inner_index <= last_index;
+             inner_index = inner_index + 1) {
+          const auto& inner_measure = measure_infos.at(inner_index);
+          if (inner_measure.ending_numbers.isEmpty() ||
+              inner_measure.ending_numbers.contains(pass_number)) {
+            expansion.push_back(
+                {inner_measure.start_time, inner_measure.end_time});
+          }
+        }
+      }
+    }
+    next_index = last_index + 1;
+  }
+  flush(next_index, static_cast<int>(measure_infos.size()) - 1);
+  return expansion;
+}
+
+namespace {
+
+auto get_time_and_time_per_division(TimeIterator& iterator,
+                                    const int check_divisions_time)
+    -> std::tuple<int, int> {
+  auto& iterator_state = iterator.state;
+  const auto song_divisions = iterator.song_divisions;
+  const auto& iterator_end = iterator.end;
+  while (iterator_state != iterator_end) {
+    const auto next_change_divisions_time = iterator_state.key();
+    if (next_change_divisions_time > check_divisions_time) {
+      break;
+    }
+    const auto divisions_delta =
+        next_change_divisions_time - iterator.next_change_divisions_time;
+    iterator.next_change_divisions_time = next_change_divisions_time;
+    const auto next_divisions = iterator_state.value();
+    Q_ASSERT(next_divisions > 0);
+    const auto time_per_division = song_divisions / next_divisions;
+    iterator.time_per_division = time_per_division;
+    iterator.last_change_time =
+        iterator.last_change_time + time_per_division * divisions_delta;
+    iterator.next_change_divisions_time = next_change_divisions_time;
+    iterator_state++;
+  }
+  const auto time_per_division = iterator.time_per_division;
+  return std::make_tuple(
+      iterator.last_change_time +
+          (time_per_division *
+           (check_divisions_time - iterator.next_change_divisions_time)),
+      time_per_division);
+}
+
+auto deduplicate_voice_names(QList<QString> voice_names) -> QList<QString> {
+  QSet<QString> used_names;
+  for (auto& voice_name : voice_names) {
+    if (voice_name.isEmpty()) {
+      voice_name = QObject::tr("Unnamed instrument");
+    }
+    auto candidate_name = voice_name;
+    for (auto suffix_number = 2; used_names.contains(candidate_name);
+         suffix_number = suffix_number + 1) {
+      candidate_name = voice_name + QString(" (%1)").arg(suffix_number);
+    }
+    voice_name = candidate_name;
+    used_names.insert(candidate_name);
+  }
+  return voice_names;
+}
+
+auto maybe_read_compressed_musicxml_bytes(const QString& filename)
+    -> QByteArray {
+  const ZipArchive archive(filename);
+  if (archive.internal_pointer == nullptr) {
+    return {};
+  }
+
+  const auto container_bytes =
+      read_zip_entry(archive, "META-INF/container.xml");
+  if (container_bytes.isEmpty()) {
+    return {};
+  }
+
+  const auto container_document = read_xml_document(container_bytes);
+  if (container_document.internal_pointer == nullptr) {
+    return {};
+  }
+
+  auto* rootfiles_pointer =
+      maybe_get_xml_child(get_root(container_document), "rootfiles");
+  auto* rootfile_pointer =
+      rootfiles_pointer == nullptr
+          ? nullptr
+          : maybe_get_xml_child(get_reference(rootfiles_pointer), "rootfile");
+  if (rootfile_pointer == nullptr) {
+    return {};
+  }
+
+  const auto root_path =
+      get_property(get_reference(rootfile_pointer), "full-path");
+
+  return read_zip_entry(archive, root_path);
+}
+
+auto maybe_read_musicxml_document(const QString& filename) -> XMLDocument {
+  if (filename.endsWith(".mxl", Qt::CaseInsensitive)) {
+    return read_xml_document(maybe_read_compressed_musicxml_bytes(filename));
+  }
+  return read_xml_file(filename);
+}
+
+template <VoiceInterface SubVoice>
+auto get_imported_voices(const QList<QString>& voice_names)
+    -> QList<SubVoice> {
+  const auto& programs = get_some_programs(SubVoice::is_pitched());
+  QList<SubVoice> voices;
+  for (const auto& voice_name : voice_names) {
+    SubVoice new_voice;
+    new_voice.name = voice_name;
+    const auto matching_program = get_named_index(programs, voice_name);
+    if (matching_program != programs.cend()) {
+      new_voice.program = matching_program->name;
+      new_voice.program_pointer = &*matching_program;
+    }
+    voices.push_back(std::move(new_voice));
+  }
+  return voices;
+}
+
+// whether any part has a chord right at the start of a measure
+auto has_chord_at_measure(const QMap<std::string, PartInfo>& part_info_dict,
+                          const int measure_index) -> bool {
+  return std::any_of(
+      part_info_dict.cbegin(), part_info_dict.cend(),
+      [measure_index](const PartInfo& part_info) -> auto {
+        const auto& measure_infos = part_info.measure_infos;
+        return measure_index < measure_infos.size() &&
+               part_info.part_chords_dict.contains(
+                   measure_infos.at(measure_index).start_time);
+      });
+}
+
+// the repeats that can stay folded, as a song Repeat, rather than being
+// unrolled: a Repeat can't pick an ending for each pass, so only blocks
+// without endings qualify, and only if every part repeats them. They also
+// need a chord right at their start and right after their end, so the
+// chords around them don't run into them, and each pass sounds just like it
+// would unrolled
+auto get_folded_repeats(const QMap<std::string, PartInfo>& part_info_dict)
+    -> QList<MeasureRepeat> {
+  QList<QList<MeasureRepeat>> parts_measure_repeats;
+  for (const auto& part_info : part_info_dict) {
+    // parts in the part list with no measures don't get a say
+    if (!part_info.measure_infos.isEmpty()) {
+      parts_measure_repeats.push_back(
+          get_measure_repeats(part_info.measure_infos));
+    }
+  }
+  QList<MeasureRepeat> folded_repeats;
+  if (parts_measure_repeats.isEmpty()) {
+    return folded_repeats;
+  }
+  for (const auto& measure_repeat : parts_measure_repeats.front()) {
+    if (!measure_repeat.has_endings && measure_repeat.times >= 1 &&
+        measure_repeat.times <= MAX_REPEAT_TIMES &&
+        std::ranges::all_of(
+            parts_measure_repeats,
+            [&measure_repeat](
+                const QList<MeasureRepeat>& part_measure_repeats) -> auto {
+              return part_measure_repeats.contains(measure_repeat);
+            }) &&
+        has_chord_at_measure(part_info_dict,
+                             measure_repeat.first_measure_index) &&
+        has_chord_at_measure(part_info_dict,
+                             measure_repeat.last_measure_index + 1)) {
+      folded_repeats.push_back(measure_repeat);
+    }
+  }
+  return folded_repeats;
+}
+
+}  // namespace
+
+auto read_musicxml_file(const QString& filename, UserWarning& warning,
+                        const std::function<bool(double)>& keep_reading)
+    -> std::optional<Song> {
+  const TraceSpan trace_span("read_musicxml_file");
+  static const auto DEFAULT_REPEAT_TIMES = 2;
+  static const auto FIFTH_HALFSTEPS = 7;
+
+  const auto set_cancelled_warning = [&warning]() -> auto {
+    warning = {.title = QObject::tr("Import cancelled"),
+               .message = QObject::tr("The import was cancelled")};
+  };
+
+  if (keep_reading && !keep_reading(0)) {
+    set_cancelled_warning();
+    return std::nullopt;
+  }
+
+  auto document = maybe_read_musicxml_document(filename);
+  if (document.internal_pointer == nullptr) {
+    warning = {.title = QObject::tr("XML error"),
+               .message = QObject::tr("Invalid XML file")};
+    return std::nullopt;
+  }
+
+  thread_local XMLValidator musicxml_validator("musicxml.xsd");
+  if (validate_against_schema(musicxml_validator, document) != 0) {
+    warning = {.title = QObject::tr("Validation Error"),
+               .message = QObject::tr("Invalid musicxml file")};
+    return std::nullopt;
+  }
+
+  // Get root_pointer element
+  auto& score_partwise = get_root(document);
+  if (!node_is(score_partwise, "score-partwise")) {
+    warning = {.title = QObject::tr("Partwise error"),
+               .message = QObject::tr(
+                   "Justly only supports partwise musicxml scores")};
+    return std::nullopt;  // endpoint
+  }
+
+  // Get part-list
+  QMap<std::string, PartInfo> part_info_dict;
+
+  auto song_divisions = 1;
+
+  QMap<QString, int> pitched_voice_numbers;
+  QList<QString> pitched_voice_names;
+  QMap<QString, int> unpitched_voice_numbers;
+  QList<QString> unpitched_voice_names;
+
+  // progress goes by part, then by measure within it
+  auto number_of_parts = 0;
+  auto* counted_node_pointer = xmlFirstElementChild(&score_partwise);
+  while (counted_node_pointer != nullptr) {
+    if (node_is(get_reference(counted_node_pointer), "part")) {
+      number_of_parts = number_of_parts + 1;
+    }
+    counted_node_pointer = xmlNextElementSibling(counted_node_pointer);
+  }
+  auto part_number = 0;
+
+  auto* part_node_pointer = xmlFirstElementChild(&score_partwise);
+  while (part_node_pointer != nullptr) {
+    auto& part_node = get_reference(part_node_pointer);
+    const auto part_node_name = get_xml_name(part_node);
+    if (part_node_name == "part-list") {
+      auto* score_part_pointer = xmlFirstElementChild(&part_node);
+      while (score_part_pointer != nullptr) {
+        auto& score_part = get_reference(score_part_pointer);
+        if (node_is(score_part, "score-part")) {
+          PartInfo part_info;
+          auto& instrument_map = part_info.instrument_map;
+          auto* field_pointer = xmlFirstElementChild(score_part_pointer);
+          while (field_pointer != nullptr) {
+            auto& field_node = get_reference(field_pointer);
+            const auto child_name = get_xml_name(field_node);
+            if (child_name == "part-name") {
+              part_info.part_name = get_qstring_content(field_node);
+            } else if (child_name == "score-instrument") {
+              instrument_map[get_property(field_node, "id")] =
+                  get_qstring_content(
+                      get_xml_child(field_node, "instrument-name"));
+            }
+            field_pointer = xmlNextElementSibling(field_pointer);
+          }
+          part_info_dict[get_property(score_part, "id")] = std::move(part_info);
+        }
+        score_part_pointer = xmlNextElementSibling(score_part_pointer);
+      }
+    } else if (part_node_name == "part") {
+      const auto part_id = get_property(part_node, "id");
+      auto& part_info = part_info_dict[part_id];
+
+      auto& part_chords_dict = part_info.part_chords_dict;
+      auto& part_divisions_dict = part_info.part_divisions_dict;
+      auto& part_measure_number_dict = part_info.part_measure_number_dict;
+      auto& part_midi_keys_dict = part_info.part_midi_keys_dict;
+
+      auto current_time = 0;
+      auto chord_start_time = current_time;
+      auto measure_number = 1;
+      auto current_transpose_semitones = 0;
+
+      QMap<QString, MusicXMLNote> tied_notes;
+      auto& measure_infos = part_info.measure_infos;
+      QList<int> active_ending_numbers;
+
+      const auto number_of_measures =
+          static_cast<double>(xmlChildElementCount(&part_node));
+      auto measure_index = 0;
+
+      auto* measure_pointer = xmlFirstElementChild(&part_node);
+      while (measure_pointer != nullptr) {
+        if (keep_reading &&
+            !keep_reading((part_number + measure_index / number_of_measures) /
+                          number_of_parts)) {
+          set_cancelled_warning();
+          return std::nullopt;
+        }
+        measure_index = measure_index + 1;
+        auto& measure = get_reference(measure_pointer);
+        part_measure_number_dict[current_time] = measure_number;
+        MeasureRepeatInfo measure_info;
+        measure_info.start_time = current_time;
+        measure_info.ending_numbers = active_ending_numbers;
+        auto* measure_element_pointer = xmlFirstElementChild(&measure);
+        while (measure_element_pointer != nullptr) {
+          auto& measure_element = get_reference(measure_element_pointer);
+          const auto measure_element_name = get_xml_name(measure_element);
+          if (measure_element_name == "attributes") {
+            auto* attribute_element_pointer =
+                xmlFirstElementChild(&measure_element);
+            while (attribute_element_pointer != nullptr) {
+              auto& attribute_element =
+                  get_reference(attribute_element_pointer);
+              const auto attribute_name = get_xml_name(attribute_element);
+              if (attribute_name == "key") {
+                const auto maybe_fifths = get_int_or_warn(
+                    warning, get_xml_child(attribute_element, "fifths"),
+                    QObject::tr("Key error"),
+                    QObject::tr("Fifths value is out of range"));
+                if (!maybe_fifths.has_value()) {
+                  return std::nullopt;  // endpoint
+                }
+                const auto [octave, degree] =
+                    get_octave_degree(FIFTH_HALFSTEPS * maybe_fifths.value());
+                part_midi_keys_dict[current_time] = MIDDLE_C_MIDI + degree;
+              } else if (attribute_name == "divisions") {
+                if (!xml_content_is_integer(attribute_element)) {
+                  warning = {.title = QObject::tr("Divisions error"),
+                             .message = QObject::tr(
+                                 "Fractional divisions are not supported")};
+                  return std::nullopt;  // endpoint
+                }
+                const auto maybe_divisions = get_int_or_warn(
+                    warning, attribute_element,
+                    QObject::tr("Divisions error"),
+                    QObject::tr("Divisions value is out of range"));
+                if (!maybe_divisions.has_value()) {
+                  return std::nullopt;  // endpoint
+                }
+                const auto new_divisions = maybe_divisions.value();
+                Q_ASSERT(new_divisions > 0);
+                song_divisions = std::lcm(song_divisions, new_divisions);
+                part_divisions_dict[current_time] = new_divisions;
+              } else if (attribute_name == "transpose") {
+                auto& chromatic_element =
+                    get_xml_child(attribute_element, "chromatic");
+                if (!xml_content_is_integer(chromatic_element)) {
+                  warning = {.title = QObject::tr("Transpose error"),
+                             .message = QObject::tr(
+                                 "Microtonal transpositions are not "
+                                 "supported")};
+                  return std::nullopt;  // endpoint
+                }
+                const auto maybe_chromatic = get_int_or_warn(
+                    warning, chromatic_element,
+                    QObject::tr("Transpose error"),
+                    QObject::tr("Chromatic value is out of range"));
+                if (!maybe_chromatic.has_value()) {
+                  return std::nullopt;  // endpoint
+                }
+                const auto chromatic_semitones = maybe_chromatic.value();
+                auto octave_change_octaves = 0;
+                auto* transpose_field_pointer =
+                    xmlFirstElementChild(&attribute_element);
+                while (transpose_field_pointer != nullptr) {
+                  auto& transpose_field =
+                      get_reference(transpose_field_pointer);
+                  if (node_is(transpose_field, "octave-change")) {
+                    const auto maybe_octave_change = get_int_or_warn(
+                        warning, transpose_field,
+                        QObject::tr("Transpose error"),
+                        QObject::tr("Octave change value is out of range"));
+                    if (!maybe_octave_change.has_value()) {
+                      return std::nullopt;  // endpoint
+                    }
+                    octave_change_octaves = maybe_octave_change.value();
+                  }
+                  transpose_field_pointer =
+                      xmlNextElementSibling(transpose_field_pointer);
+                }
+                current_transpose_semitones =
+                    chromatic_semitones +
+                    octave_change_octaves * HALFSTEPS_PER_OCTAVE;
+              }
+              attribute_element_pointer =
+                  xmlNextElementSibling(attribute_element_pointer);
+            }
+          } else if (measure_element_name == "note") {
+            auto note_duration = 0;
+            auto midi_number = -1;
+            bool is_pitched = true;
+            bool tie_start = false;
+            bool tie_end = false;
+            bool new_chord = true;
+            bool is_rest = false;
+            QString instrument_name = "";
+            std::string instrument_id;
+
+            static const QMap<std::string, int> note_to_midi = {
+                {"C", 0},   {"C#", 1}, {"Db", 1}, {"D", 2},  {"D#", 3},
+                {"Eb", 3},  {"E", 4},  {"F", 5},  {"F#", 6}, {"Gb", 6},
+                {"G", 7},   {"G#", 8}, {"Ab", 8}, {"A", 9},  {"A#", 10},
+                {"Bb", 10}, {"B", 11}};
+
+            auto* note_field_pointer =
+                xmlFirstElementChild(measure_element_pointer);
+            while ((note_field_pointer != nullptr)) {
+              auto& note_field = get_reference(note_field_pointer);
+              const auto& name = get_xml_name(note_field);
+              if (name == "pitch") {
+                auto midi_degree = 0;
+                auto octave_number = 0;
+                auto alter = 0;
+
+                auto* pitch_field_pointer = xmlFirstElementChild(&note_field);
+                while (pitch_field_pointer != nullptr) {
+                  auto& pitch_field = get_reference(pitch_field_pointer);
+                  const auto& pitch_field_name = get_xml_name(pitch_field);
+                  if (pitch_field_name == "step") {
+                    midi_degree = note_to_midi[get_content(pitch_field)];
+                  } else if (pitch_field_name == "octave") {
+                    octave_number = xml_to_int(pitch_field);
+                  } else if (pitch_field_name == "alter") {
+                    if (!xml_content_is_integer(pitch_field)) {
+                      warning = {.title = QObject::tr("Pitch error"),
+                                 .message = QObject::tr(
+                                     "Microtonal pitches are not supported")};
+                      return std::nullopt;  // endpoint
+                    }
+                    const auto maybe_alter = get_int_or_warn(
+                        warning, pitch_field, QObject::tr("Pitch error"),
+                        QObject::tr("Alter value is out of range"));
+                    if (!maybe_alter.has_value()) {
+                      return std::nullopt;  // endpoint
+                    }
+                    alter = maybe_alter.value();
+                  }
+                  pitch_field_pointer =
+                      xmlNextElementSibling(pitch_field_pointer);
+                }
+                midi_number = midi_degree + alter +
+                              octave_number * HALFSTEPS_PER_OCTAVE + C_0_MIDI;
+              } else if (name == "duration") {
+                if (!xml_content_is_integer(note_field)) {
+                  warning = {.title = QObject::tr("Note duration error"),
+                             .message = QObject::tr(
+                                 "Fractional note durations are not "
+                                 "supported")};
+                  return std::nullopt;  // endpoint
+                }
+                const auto maybe_duration = get_int_or_warn(
+                    warning, note_field, QObject::tr("Note duration error"),
+                    QObject::tr("Note duration is out of range"));
+                if (!maybe_duration.has_value()) {
+                  return std::nullopt;  // endpoint
+                }
+                note_duration = maybe_duration.value();
+              } else if (name == "unpitched") {
+                is_pitched = false;
+              } else if (name == "tie") {
+                const auto tie_type = get_property(note_field, "type");
+                if (tie_type == "stop") {
+                  tie_end = true;
+                } else if (tie_type == "start") {
+                  tie_start = true;
+                }
+              } else if (name == "chord") {
+                new_chord = false;
+              } else if (name == "rest") {
+                is_rest = true;
+              } else if (name == "instrument") {
+                instrument_id = get_property(note_field, "id");
+                instrument_name = part_info.instrument_map[instrument_id];
+              }
+              note_field_pointer = xmlNextElementSibling(note_field_pointer);
+            }
+
+            if (is_pitched) {
+              midi_number += current_transpose_semitones;
+            }
+
+            if (note_duration == 0) {
+              warning = {.title = QObject::tr("Note duration error"),
+                         .message = QObject::tr(
+                             "Notes without durations not supported")};
+              return std::nullopt;  // endpoint
+            }
+            if (new_chord) {
+              chord_start_time = current_time;
+              current_time += note_duration;
+            }
+            if (!is_rest) {
+              QString voice_key;
+              QTextStream voice_key_stream(&voice_key);
+              voice_key_stream << QString::fromStdString(part_id) << ":"
+                               << QString::fromStdString(instrument_id);
+              // a tie only ever connects notes within the same voice, so an
+              // in-progress tie must be looked up by voice as well as pitch
+              // -- otherwise two simultaneous voices (e.g. two instruments
+              // in one part, or an unresolved tie carried over from an
+              // earlier part) tying the same pitch clobber each other's
+              // still-open note
+              const auto tied_note_key =
+                  voice_key + ":" + QString::number(midi_number);
+              if (tie_end && !tied_notes.contains(tied_note_key)) {
+                // no matching tie-start -- the schema doesn't require ties
+                // to be well-formed, so a malformed or hand-edited file can
+                // have an orphan tie-stop; fall back to treating this as an
+                // unstarted note rather than dereferencing a missing entry
+                tie_end = false;
+              }
+              if (tie_end) {
+                const auto tied_notes_iterator = tied_notes.find(tied_note_key);
+                auto& previous_note = tied_notes_iterator.value();
+                previous_note.duration = previous_note.duration + note_duration;
+                if (!tie_start) {
+                  add_note_and_maybe_chord(part_chords_dict, previous_note,
+                                           is_pitched);
+                  tied_notes.erase(tied_notes_iterator);
+                }
+              } else {
+                MusicXMLNote new_note;
+                new_note.duration = note_duration;
+                QTextStream stream(&new_note.words);
+                stream << QObject::tr("Part ") << part_info.part_name;
+                if (instrument_name != "") {
+                  stream << QObject::tr(" instrument ") << instrument_name;
+                }
+                new_note.midi_number = midi_number;
+                new_note.start_time = chord_start_time;
+                auto& voice_numbers = is_pitched ? pitched_voice_numbers
+                                                 : unpitched_voice_numbers;
+                auto& voice_names =
+                    is_pitched ? pitched_voice_names : unpitched_voice_names;
+                const auto voice_name = instrument_name.isEmpty()
+                                            ? part_info.part_name
+                                            : instrument_name;
+                const auto found_voice_number = voice_numbers.find(voice_key);
+                if (found_voice_number != voice_numbers.end()) {
+                  new_note.voice_number = found_voice_number.value();
+                } else {
+                  new_note.voice_number = static_cast<int>(voice_names.size());
+                  voice_numbers[voice_key] = new_note.voice_number;
+                  voice_names.push_back(voice_name);
+                }
+                if (tie_start) {  // also not tie end
+                  tied_notes[tied_note_key] = std::move(new_note);
+                } else {  // not tie start or end
+                  add_note_and_maybe_chord(part_chords_dict,
+                                           std::move(new_note), is_pitched);
+                }
+              }
+            }
+          } else if (measure_element_name == "backup") {
+            const auto duration = get_duration(warning, measure_element);
+            if (!duration.has_value()) {
+              return std::nullopt;  // endpoint
+            }
+            current_time -= duration.value();
+            chord_start_time = current_time;
+          } else if (measure_element_name == "forward") {
+            const auto duration = get_duration(warning, measure_element);
+            if (!duration.has_value()) {
+              return std::nullopt;  // endpoint
+            }
+            current_time += duration.value();
+            chord_start_time = current_time;
+          } else if (measure_element_name == "barline") {
+            // records forward/backward repeats and first/second-ending
+            // brackets onto the current measure, so the raw per-part
+            // timeline can be unrolled below
+            auto* barline_child_pointer =
+                xmlFirstElementChild(&measure_element);
+            while (barline_child_pointer != nullptr) {
+              auto& child = get_reference(barline_child_pointer);
+              if (node_is(child, "repeat")) {
+                const auto direction = get_property(child, "direction");
+                if (direction == "forward") {
+                  measure_info.has_forward_repeat = true;
+                } else if (direction == "backward") {
+                  measure_info.has_backward_repeat = true;
+                  auto* const times_property =
+                      xmlGetProp(&child, c_string_to_xml_string("times"));
+                  const auto times_text =
+                      times_property == nullptr
+                          ? std::string()
+                          : xml_string_to_string(times_property);
+                  if (times_text.empty()) {
+                    measure_info.repeat_times = DEFAULT_REPEAT_TIMES;
+                  } else {
+                    const auto maybe_times = get_int_or_warn(
+                        warning, times_text, QObject::tr("Repeat error"),
+                        QObject::tr("Repeat times is out of range"));
+                    if (!maybe_times.has_value()) {
+                      return std::nullopt;  // endpoint
+                    }
+                    measure_info.repeat_times = maybe_times.value();
+                  }
+                }
+              } else if (node_is(child, "ending")) {
+                if (get_property(child, "type") == "start") {
+                  QList<int> ending_numbers;
+                  const auto numbers_text =
+                      QString::fromStdString(get_property(child, "number"));
+                  for (const auto& token :
+                       numbers_text.split(',', Qt::SkipEmptyParts)) {
+                    bool is_number = false;
+                    const auto number = token.trimmed().toInt(&is_number);
+                    if (is_number) {
+                      ending_numbers.push_back(number);
+                    }
+                  }
+                  for (const auto number : ending_numbers) {
+                    if (!active_ending_numbers.contains(number)) {
+                      active_ending_numbers.push_back(number);
+                    }
+                    if (!measure_info.ending_numbers.contains(number)) {
+                      measure_info.ending_numbers.push_back(number);
+                    }
+                  }
+                } else {  // "stop" or "discontinue"
+                  active_ending_numbers.clear();
+                }
+              }
+              barline_child_pointer =
+                  xmlNextElementSibling(barline_child_pointer);
+            }
+          }
+          measure_element_pointer =
+              xmlNextElementSibling(measure_element_pointer);
+        }
+        measure_info.end_time = current_time;
+        measure_infos.push_back(std::move(measure_info));
+        measure_number++;
+        measure_pointer = xmlNextElementSibling(&measure);
+      }
+      part_number = part_number + 1;
+    }
+    part_node_pointer = xmlNextElementSibling(part_node_pointer);
+  }
+
+  const auto folded_repeats = get_folded_repeats(part_info_dict);
+  for (auto& part_info : part_info_dict) {
+    const auto expansion =
+        compute_measure_expansion(part_info.measure_infos, folded_repeats);
+    part_info.part_chords_dict =
+        remap_by_expansion(part_info.part_chords_dict, expansion);
+    part_info.part_divisions_dict =
+        remap_by_expansion(part_info.part_divisions_dict, expansion);
+    part_info.part_midi_keys_dict =
+        remap_by_expansion(part_info.part_midi_keys_dict, expansion);
+    part_info.part_measure_number_dict =
+        remap_by_expansion(part_info.part_measure_number_dict, expansion);
+  }
+
+  QMap<int, MusicXMLChord> chords_dict;
+  QMap<int, int> midi_keys_dict;
+  QMap<int, int> measure_number_dict;
+
+  for (auto [part_id, part_info] : part_info_dict.asKeyValueRange()) {
+    TimeIterator time_iterator(part_info.part_divisions_dict, song_divisions);
+    for (auto [divisions_time, chord] :
+         part_info.part_chords_dict.asKeyValueRange()) {
+      auto [time, time_per_division] =
+          get_time_and_time_per_division(time_iterator, divisions_time);
+      auto& new_pitched_notes = chord.pitched_notes;
+      auto& new_unpitched_notes = chord.unpitched_notes;
+      for (auto& pitched_note : new_pitched_notes) {
+        pitched_note.duration = pitched_note.duration * time_per_division;
+      }
+      for (auto& unpitched_note : new_unpitched_notes) {
+        unpitched_note.duration = unpitched_note.duration * time_per_division;
+      }
+      if (chords_dict.contains(time)) {
+        auto& old_chord = chords_dict[time];
+
+        old_chord.pitched_notes.append(std::move(new_pitched_notes));
+        old_chord.unpitched_notes.append(std::move(new_unpitched_notes));
+      } else {
+        chords_dict[time] = std::move(chord);
+      }
+    }
+
+    reset(time_iterator);
+    for (const auto [divisions_time, measure_number] :
+         part_info.part_measure_number_dict.asKeyValueRange()) {
+      auto [time, time_per_division] =
+          get_time_and_time_per_division(time_iterator, divisions_time);
+      measure_number_dict[time] = measure_number;
+    }
+
+    reset(time_iterator);
+    for (const auto [divisions_time, midi_key] :
+         part_info.part_midi_keys_dict.asKeyValueRange()) {
+      auto [time, time_per_division] =
+          get_time_and_time_per_division(time_iterator, divisions_time);
+      midi_keys_dict[time] = midi_key;
+    }
+  }
+
+  auto chord_state = chords_dict.begin();
+  const auto chord_dict_end = chords_dict.end();
+
+  if (chord_state == chord_dict_end) {
+    warning = {.title = QObject::tr("Empty MusicXML error"),
+               .message = QObject::tr("No chords")};
+    return std::nullopt;  // endpoint
+  }
+
+  if (unpitched_voice_names.empty()) {
+    // a file with no percussion/unpitched notes would otherwise leave
+    // song.unpitched_voices completely empty, so manually inserting any
+    // unpitched note afterward (which defaults its voice_number to 0)
+    // would reference a voice that doesn't exist
+    unpitched_voice_names.push_back(QObject::tr("unpitched voice 1"));
+  }
+
+  Song song;
+  song.pitched_voices = get_imported_voices<PitchedVoice>(
+      deduplicate_voice_names(pitched_voice_names));
+  song.unpitched_voices = get_imported_voices<UnpitchedVoice>(
+      deduplicate_voice_names(unpitched_voice_names));
+  auto& chords = song.chords;
+  chords.reserve(chords_dict.size());
+  StringPool string_pool;
+
+  MostRecentIterator measure_number_iterator(measure_number_dict, 1);
+  MostRecentIterator midi_key_iterator(midi_keys_dict, DEFAULT_STARTING_MIDI);
+
+  auto time = chord_state.key();
+
+  auto parse_chord = std::move(chord_state.value());
+
+  auto midi_key = get_most_recent(midi_key_iterator, time);
+
+  song.starting_key = midi_number_to_frequency(midi_key);
+
+  auto last_midi_key = midi_key;
+
+  // for finding the folded repeats' chords afterwards
+  QList<int> chord_measure_numbers;
+  auto measure_number = get_most_recent(measure_number_iterator, time);
+
+  ++chord_state;
+  while (chord_state != chord_dict_end) {
+    const auto next_time = chord_state.key();
+    add_chord(chords, string_pool, parse_chord, measure_number, midi_key,
+              last_midi_key, song_divisions, next_time - time);
+    chord_measure_numbers.push_back(measure_number);
+
+    time = next_time;
+    parse_chord = std::move(chord_state.value());
+
+    last_midi_key = midi_key;
+    midi_key = get_most_recent(midi_key_iterator, time);
+    measure_number = get_most_recent(measure_number_iterator, time);
+
+    ++chord_state;
+  }
+  add_chord(chords, string_pool, parse_chord, measure_number, midi_key,
+            last_midi_key, song_divisions,
+            std::max(get_max_duration(parse_chord.pitched_notes),
+                     get_max_duration(parse_chord.unpitched_notes)));
+  chord_measure_numbers.push_back(measure_number);
+
+  // measure numbers count from 1
+  for (const auto& measure_repeat : folded_repeats) {
+    const auto first_chord = std::ranges::find(
+        chord_measure_numbers, measure_repeat.first_measure_index + 1);
+    Q_ASSERT(first_chord != chord_measure_numbers.end());
+    const auto end_chord = std::find_if(
+        first_chord, chord_measure_numbers.end(),
+        [&measure_repeat](const int chord_measure_number) -> auto {
+          return chord_measure_number > measure_repeat.last_measure_index + 1;
+        });
+    song.repeats.push_back(Repeat{
+        .first_chord_number = static_cast<int>(
+            std::distance(chord_measure_numbers.begin(), first_chord)),
+        .number_of_chords =
+            static_cast<int>(std::distance(first_chord, end_chord)),
+        .times = measure_repeat.times});
+  }
+  return song;
+}
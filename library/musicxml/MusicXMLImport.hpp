@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QtCore/QList>
+#include <QtCore/QMap>
+#include <QtCore/QString>
+#include <functional>
+#include <optional>
+
+#include "musicxml/MeasureRepeatInfo.hpp"
+#include "other/Song.hpp"
+#include "other/UserWarning.hpp"
+#include "rows/Chord.hpp"
+
+struct TimeIterator;
+
+void reset(TimeIterator& iterator);
+
+// the repeated blocks in a linear list of measures (each optionally tagged
+// with a forward/backward repeat and/or first-/second-ending numbers), in
+// order. A backward repeat with no forward repeat since the last block
+// repeats from the end of that block
+[[nodiscard]] auto get_measure_repeats(
+    const QList<MeasureRepeatInfo>& measure_infos) -> QList<MeasureRepeat>;
+
+// turns a linear list of measures into an ordered list of (start_time,
+// end_time) spans describing the actual playback order, unrolling repeated
+// sections and picking the ending that belongs to each pass. Blocks in
+// folded_repeats are left as they're written instead, for a song Repeat to
+// play again
+[[nodiscard]] auto compute_measure_expansion(
+    const QList<MeasureRepeatInfo>& measure_infos,
+    const QList<MeasureRepeat>& folded_repeats = {})
+    -> QList<std::pair<int, int>>;
+
+// replays a raw per-part dict (keyed by the original, un-repeated division
+// time) onto the unrolled timeline described by an expansion computed by
+// compute_measure_expansion
+template <typename Value>
+[[nodiscard]] static auto remap_by_expansion(
+    const QMap<int, Value>& raw_dict,
+    const QList<std::pair<int, int>>& expansion) {
+  QMap<int, Value> expanded_dict;
+  auto new_cursor = 0;
+  for (const auto& [raw_start, raw_end] : expansion) {
+    for (auto iterator = raw_dict.lowerBound(raw_start);
+         iterator != raw_dict.end() && iterator.key() < raw_end; ++iterator) {
+      expanded_dict[new_cursor + (iterator.key() - raw_start)] =
+          iterator.value();
+    }
+    new_cursor = new_cursor + (raw_end - raw_start);
+  }
+  return expanded_dict;
+}
+
+// a song from a .musicxml file, or a compressed .mxl one, with a voice for
+// each part (or instrument within a part). Doesn't touch any widgets, so
+// it's safe to call from any thread (see MusicXMLImporter); import_musicxml
+// then loads the result into the editor. keep_reading, if given, is called
+// with the fraction read so far before each measure, and stops the import if
+// it returns false
+[[nodiscard]] auto read_musicxml_file(
+    const QString& filename, UserWarning& warning,
+    const std::function<bool(double)>& keep_reading = {})
+    -> std::optional<Song>;
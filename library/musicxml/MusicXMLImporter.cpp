@@ -0,0 +1,28 @@
+#include "musicxml/MusicXMLImporter.hpp"
+
+#include "musicxml/MusicXMLImport.hpp"
+
+namespace {
+
+void run_musicxml_import(MusicXMLImporter& importer) {
+  importer.maybe_song = read_musicxml_file(
+      importer.filename, importer.warning,
+      [&importer](const double progress) -> auto {
+        importer.progress.store(progress);
+        return !importer.cancelled.load();
+      });
+  importer.finished.store(true);
+}
+
+}  // namespace
+
+MusicXMLImporter::MusicXMLImporter(QString filename_input)
+    : filename(std::move(filename_input)),
+      thread(std::thread(run_musicxml_import, std::ref(*this))) {}
+
+MusicXMLImporter::~MusicXMLImporter() {
+  if (thread.joinable()) {
+    cancelled.store(true);
+    thread.join();
+  }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QtCore/QString>
+#include <atomic>
+#include <optional>
+#include <thread>
+
+#include "other/Song.hpp"
+#include "other/UserWarning.hpp"
+#include "other/helpers.hpp"
+
+// a MusicXML file being read (see read_musicxml_file) on a thread of its
+// own, so the editor stays responsive; the song it reads is only loaded into
+// the editor once it's finished (see finish_import)
+struct MusicXMLImporter {
+  const QString filename;
+
+  // the fraction read so far
+  std::atomic<double> progress = 0;
+  // checked before each measure
+  std::atomic<bool> cancelled = false;
+  std::atomic<bool> finished = false;
+  // only written by the thread, and only read once finished is set
+  std::optional<Song> maybe_song;
+  UserWarning warning;
+
+  // declared last, so everything the thread touches exists before it starts
+  std::thread thread;
+
+  explicit MusicXMLImporter(QString filename_input);
+
+  NO_MOVE_COPY(MusicXMLImporter)
+
+  // cancels the import, unless the thread has already been joined
+  ~MusicXMLImporter();
+};
@@ -2,6 +2,7 @@
 
 #include <QtCore/QMap>
 
+#include "musicxml/MeasureRepeatInfo.hpp"
 #include "musicxml/MusicXMLChord.hpp"
 
 struct PartInfo {
@@ -11,4 +12,5 @@ struct PartInfo {
   QMap<int, int> part_divisions_dict;
   QMap<int, int> part_midi_keys_dict;
   QMap<int, int> part_measure_number_dict;
+  QList<MeasureRepeatInfo> measure_infos;
 };
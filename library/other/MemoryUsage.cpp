@@ -0,0 +1,115 @@
+#include "other/MemoryUsage.hpp"
+
+#include <QtCore/QFileInfo>
+#include <QtCore/QLocale>
+#include <QtCore/QObject>
+#include <QtCore/QTextStream>
+#include <QtGui/QUndoStack>
+
+#include "other/Song.hpp"
+#include "rows/Chord.hpp"
+
+auto count_buffer_bytes(MemoryCounter& counter, const void* const data_pointer,
+                        const qsizetype bytes) -> qsizetype {
+  // empty containers and string literals don't allocate
+  if (data_pointer == nullptr || bytes == 0) {
+    return 0;
+  }
+  auto& counted_buffers = counter.counted_buffers;
+  if (counted_buffers.contains(data_pointer)) {
+    return 0;
+  }
+  counted_buffers.insert(data_pointer);
+  return bytes;
+}
+
+auto count_string_bytes(MemoryCounter& counter, const QString& text)
+    -> qsizetype {
+  return count_buffer_bytes(
+      counter, text.constData(),
+      text.capacity() * static_cast<qsizetype>(sizeof(QChar)));
+}
+
+auto count_heap_bytes(MemoryCounter& counter, const Note& note) -> qsizetype {
+  return count_string_bytes(counter, note.words);
+}
+
+auto count_heap_bytes(MemoryCounter& counter, const Voice& voice)
+    -> qsizetype {
+  return count_string_bytes(counter, voice.name) +
+         count_string_bytes(counter, voice.program);
+}
+
+auto count_heap_bytes(MemoryCounter& counter, const Chord& chord)
+    -> qsizetype {
+  return count_string_bytes(counter, chord.words) +
+         count_list_bytes(counter, chord.pitched_notes) +
+         count_list_bytes(counter, chord.unpitched_notes);
+}
+
+auto get_song_memory_entries(MemoryCounter& counter, const Song& song)
+    -> QList<MemoryEntry> {
+  const auto& chords = song.chords;
+  // each chord's notes go under notes, rather than count_heap_bytes
+  // counting them along with the chord
+  auto chord_bytes =
+      count_buffer_bytes(counter, chords.constData(),
+                         chords.capacity() *
+                             static_cast<qsizetype>(sizeof(Chord)));
+  auto pitched_note_bytes = qsizetype{0};
+  auto unpitched_note_bytes = qsizetype{0};
+  for (const auto& chord : chords) {
+    chord_bytes = chord_bytes + count_string_bytes(counter, chord.words);
+    pitched_note_bytes =
+        pitched_note_bytes + count_list_bytes(counter, chord.pitched_notes);
+    unpitched_note_bytes = unpitched_note_bytes +
+                           count_list_bytes(counter, chord.unpitched_notes);
+  }
+  return {
+      {.name = QObject::tr("Chords"), .bytes = chord_bytes},
+      {.name = QObject::tr("Pitched notes"), .bytes = pitched_note_bytes},
+      {.name = QObject::tr("Unpitched notes"), .bytes = unpitched_note_bytes},
+      {.name = QObject::tr("Pitched voices"),
+       .bytes = count_list_bytes(counter, song.pitched_voices)},
+      {.name = QObject::tr("Unpitched voices"),
+       .bytes = count_list_bytes(counter, song.unpitched_voices)},
+  };
+}
+
+auto get_undo_memory_entries(MemoryCounter& counter,
+                             const QUndoStack& undo_stack)
+    -> QList<MemoryEntry> {
+  QList<MemoryEntry> entries;
+  const auto number_of_commands = undo_stack.count();
+  entries.reserve(number_of_commands);
+  for (auto command_number = 0; command_number < number_of_commands;
+       command_number = command_number + 1) {
+    const auto* const counted_pointer =
+        dynamic_cast<const MemoryCounted*>(undo_stack.command(command_number));
+    entries.push_back(
+        {.name = QObject::tr("Undo command %1").arg(command_number + 1),
+         .bytes = counted_pointer == nullptr
+                      ? static_cast<qsizetype>(sizeof(QUndoCommand))
+                      : counted_pointer->count_memory_bytes(counter)});
+  }
+  return entries;
+}
+
+auto get_soundfont_file_bytes() -> qsizetype {
+  return QFileInfo(QString::fromStdString(get_share_file("MS_Basic.sf3")))
+      .size();
+}
+
+auto get_memory_report_text(const QList<MemoryEntry>& entries) -> QString {
+  const QLocale locale;
+  QString text;
+  QTextStream stream(&text);
+  auto total_bytes = qsizetype{0};
+  for (const auto& entry : entries) {
+    stream << entry.name << QObject::tr(": ")
+           << locale.formattedDataSize(entry.bytes) << '\n';
+    total_bytes = total_bytes + entry.bytes;
+  }
+  stream << QObject::tr("Total: ") << locale.formattedDataSize(total_bytes);
+  return text;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QtCore/QList>
+#include <QtCore/QSet>
+#include <QtCore/QString>
+
+#include "rows/Row.hpp"
+
+class QUndoStack;
+struct Chord;
+struct Note;
+struct Song;
+struct Voice;
+
+// a rough tally of heap memory. Qt's containers share their buffers between
+// copies until one of them changes, so each buffer only counts the first
+// time it's seen: count the song before its undo commands, and their copies
+// of unchanged rows come to nothing, as they should
+struct MemoryCounter {
+  QSet<const void*> counted_buffers;
+};
+
+// bytes, unless data_pointer has been counted already
+[[nodiscard]] auto count_buffer_bytes(MemoryCounter& counter,
+                                      const void* data_pointer,
+                                      qsizetype bytes) -> qsizetype;
+
+[[nodiscard]] auto count_string_bytes(MemoryCounter& counter,
+                                      const QString& text) -> qsizetype;
+
+// what a row holds outside of itself, e.g. its words
+[[nodiscard]] auto count_heap_bytes(MemoryCounter& counter, const Note& note)
+    -> qsizetype;
+
+[[nodiscard]] auto count_heap_bytes(MemoryCounter& counter, const Voice& voice)
+    -> qsizetype;
+
+[[nodiscard]] auto count_heap_bytes(MemoryCounter& counter, const Chord& chord)
+    -> qsizetype;
+
+// the list's buffer, and what its rows hold in turn
+template <typename Item>
+[[nodiscard]] static auto count_list_bytes(MemoryCounter& counter,
+                                           const QList<Item>& items)
+    -> qsizetype {
+  auto bytes = count_buffer_bytes(
+      counter, items.constData(),
+      items.capacity() * static_cast<qsizetype>(sizeof(Item)));
+  // a buffer counted before shares its rows too
+  if (bytes > 0) {
+    if constexpr (std::derived_from<Item, Row>) {
+      for (const auto& item : items) {
+        bytes = bytes + count_heap_bytes(counter, item);
+      }
+    }
+  }
+  return bytes;
+}
+
+// an undo command that knows what its copies of the song take up
+struct MemoryCounted {
+  virtual ~MemoryCounted() = default;
+  [[nodiscard]] virtual auto count_memory_bytes(MemoryCounter& counter) const
+      -> qsizetype = 0;
+};
+
+struct MemoryEntry {
+  QString name;
+  qsizetype bytes = 0;
+};
+
+// the song's chords, notes and voices, each on their own
+[[nodiscard]] auto get_song_memory_entries(MemoryCounter& counter,
+                                           const Song& song)
+    -> QList<MemoryEntry>;
+
+// one per undo command, oldest first. Commands that aren't MemoryCounted
+// hold no rows, so only count themselves
+[[nodiscard]] auto get_undo_memory_entries(MemoryCounter& counter,
+                                           const QUndoStack& undo_stack)
+    -> QList<MemoryEntry>;
+
+// fluidsynth doesn't say how much memory a soundfont takes up once loaded,
+// so this is the size of the file. Samples in an .sf3 are compressed on
+// disk, so a loaded copy is at least this big
+[[nodiscard]] auto get_soundfont_file_bytes() -> qsizetype;
+
+// a line per entry, then their total
+[[nodiscard]] auto get_memory_report_text(const QList<MemoryEntry>& entries)
+    -> QString;
@@ -0,0 +1,431 @@
+#include "other/MidiExport.hpp"
+
+#include <QtCore/QObject>
+#include <QtCore/QTextStream>
+#include <algorithm>
+#include <ranges>
+
+#include "cell_types/Program.hpp"
+#include "other/MidiTrackEvent.hpp"
+#include "other/Song.hpp"
+#include "other/helpers.hpp"
+#include "rows/PitchedNote.hpp"
+#include "rows/UnpitchedNote.hpp"
+#include "sound/PlaybackPlan.hpp"
+#include "sound/TunedChannel.hpp"
+
+namespace {
+
+const auto BREATH_ID = 2;
+const auto MIDI_PERCUSSION_CHANNEL = 9;
+
+auto get_channels_exhausted_warning() -> UserWarning {
+  return {.title = QObject::tr("MIDI channel exhausted"),
+          .message = QObject::tr("More notes are sounding at once than there "
+                                 "are available MIDI channels")};
+}
+
+auto get_pitched_midi_channels() -> const QList<int>& {
+  static const auto channels = []() -> QList<int> {
+    // the standard MIDI file format has a hard 16-channel limit (a 4-bit
+    // channel nibble), unlike FluidSynth's own NUMBER_OF_MIDI_CHANNELS (64),
+    // which is an internal extension used only for live playback/WAV
+    // rendering
+    static const auto NUMBER_OF_STANDARD_MIDI_CHANNELS = 16;
+    QList<int> result;
+    std::ranges::copy_if(std::views::iota(0, NUMBER_OF_STANDARD_MIDI_CHANNELS),
+                         std::back_inserter(result),
+                         [](const int channel_number) -> auto {
+                           return channel_number != MIDI_PERCUSSION_CHANNEL;
+                         });
+    return result;
+  }();
+  return channels;
+}
+
+// what get_song_midi_bytes has already sent a pitched channel, when
+// exporting with tuning messages; unlike TunedChannel, a key can be retuned
+// partway through, since a retuning in a file lands at its own tick, so it
+// only has to wait out the release tail of the key's previous note
+struct MidiTuningChannel {
+  const Program* program_pointer = nullptr;
+  int breath = -1;
+  // when the last note on this channel finishes its release tail
+  double release_time = 0;
+  // each key's tuning, or negative if the key hasn't been retuned yet
+  QList<double> key_midi_numbers = QList<double>(NUMBER_OF_MIDI_KEYS, -1);
+  QList<double> key_end_times = QList<double>(NUMBER_OF_MIDI_KEYS, 0);
+  QList<double> key_release_times = QList<double>(NUMBER_OF_MIDI_KEYS, 0);
+};
+
+// a key already tuned to this note's pitch only has to be done with its
+// previous note; otherwise, the retuning would bend that note's release tail
+auto midi_key_is_free(const MidiTuningChannel& tuning_channel, const int key,
+                      const double midi_number, const double start_tick)
+    -> bool {
+  return tuning_channel.key_midi_numbers.at(key) == midi_number
+             ? tuning_channel.key_end_times.at(key) <= start_tick
+             : tuning_channel.key_release_times.at(key) <= start_tick;
+}
+
+// where a note sounds, when exporting with tuning messages
+struct MidiTuningSlot {
+  // an index into get_pitched_midi_channels
+  int channel_index = 0;
+  int key = 0;
+};
+
+// picks a channel and key the same way get_tuned_note_slot does for key
+// tuning playback
+auto get_midi_tuning_slot(const QList<MidiTuningChannel>& tuning_channels,
+                          const Program& program, const double midi_number,
+                          const int velocity, const double start_tick)
+    -> std::optional<MidiTuningSlot> {
+  static const QList<int> key_offsets{0, -1, 1};
+
+  const auto closest_key = to_int(midi_number);
+  const auto number_of_channels = static_cast<int>(tuning_channels.size());
+  const auto find_channel = [&](const bool sharing,
+                                const int key)
+      -> std::optional<MidiTuningSlot> {
+    for (auto channel_index = 0; channel_index < number_of_channels;
+         channel_index = channel_index + 1) {
+      const auto& tuning_channel = tuning_channels.at(channel_index);
+      const auto is_idle = tuning_channel.release_time <= start_tick;
+      const auto usable =
+          sharing ? tuning_channel.program_pointer == &program &&
+                        (is_idle || tuning_channel.breath == velocity)
+                  : is_idle;
+      if (usable &&
+          midi_key_is_free(tuning_channel, key, midi_number, start_tick)) {
+        return MidiTuningSlot{.channel_index = channel_index, .key = key};
+      }
+    }
+    return std::nullopt;
+  };
+
+  for (const auto key_offset : key_offsets) {
+    const auto key = closest_key + key_offset;
+    if (key < 0 || key >= NUMBER_OF_MIDI_KEYS) {
+      continue;
+    }
+    auto maybe_note_slot = find_channel(true, key);
+    if (!maybe_note_slot.has_value()) {
+      maybe_note_slot = find_channel(false, key);
+    }
+    if (maybe_note_slot.has_value()) {
+      return maybe_note_slot;
+    }
+  }
+  return std::nullopt;
+}
+
+void emit_note_events(MidiTrack& track, unsigned int channel_number,
+                      unsigned int midi_number, unsigned int velocity,
+                      double start_tick, double end_tick) {
+  // same-tick ordering: a note-off must land before any note-on, so a
+  // still-sounding note doesn't get truncated
+  static const auto MIDI_EXPORT_NOTE_OFF_TIE_BREAK = 0;
+  static const auto MIDI_EXPORT_NOTE_ON_TIE_BREAK = 5;
+  add_track_event(
+      track,
+      MidiTrackEvent{.tick = start_tick,
+                     .tie_break = MIDI_EXPORT_NOTE_ON_TIE_BREAK,
+                     .info = NoteOnEventInfo{.channel_number = channel_number,
+                                             .midi_number = midi_number,
+                                             .velocity = velocity}});
+
+  add_track_event(
+      track,
+      MidiTrackEvent{.tick = end_tick,
+                     .tie_break = MIDI_EXPORT_NOTE_OFF_TIE_BREAK,
+                     .info = NoteOffEventInfo{.channel_number = channel_number,
+                                              .midi_number = midi_number}});
+}
+
+}  // namespace
+
+auto get_song_midi_bytes(const Song& song, const PlaybackPlan& playback_plan,
+                         const bool use_tuning_messages, UserWarning& warning)
+    -> std::optional<QByteArray> {
+  // 1 tick == 1 millisecond at this fixed tempo (500000 microseconds per
+  // quarter / 500 ticks per quarter == 1000 microseconds per tick), so the
+  // playback plan's already-computed absolute millisecond timestamps can be
+  // used directly as tick values; the declared tempo itself is arbitrary and
+  // doesn't reflect the song's actual tempo, which (like in live playback
+  // and WAV export) is already baked into those timestamps via each chord's
+  // tempo_ratio
+  static const auto MIDI_TICKS_PER_QUARTER = 500;
+  static const auto MIDI_MICROSECONDS_PER_QUARTER = 500000U;
+  // same-tick ordering: a bank select must land before the program change
+  // it's meant to modify, and a program change/pitch bend must land before
+  // the note-on it's meant to apply to. A key's retuning takes the pitch
+  // bend's place, since the two are never used together
+  static const auto MIDI_EXPORT_BANK_SELECT_TIE_BREAK = 1;
+  static const auto MIDI_EXPORT_PROGRAM_CHANGE_TIE_BREAK = 2;
+  static const auto MIDI_EXPORT_PITCH_BEND_TIE_BREAK = 3;
+  static const auto MIDI_EXPORT_NOTE_TUNING_TIE_BREAK = 3;
+  static const auto MIDI_EXPORT_BREATH_TIE_BREAK = 4;
+  static const auto MIDI_BANK_SELECT_MSB_CONTROLLER = 0x00U;
+  // GM2's standard bank-select value for the percussion bank -- distinct
+  // from this soundfont's own internal SF2 bank number (128, which doesn't
+  // even fit in a 7-bit MIDI data byte) used to look up drum presets within
+  // FluidSynth
+  static const auto GM2_PERCUSSION_BANK_SELECT_MSB = 120U;
+
+  const auto& pitched_voices = song.pitched_voices;
+  const auto& unpitched_voices = song.unpitched_voices;
+  const auto number_of_pitched_voices = static_cast<int>(pitched_voices.size());
+  const auto number_of_unpitched_voices =
+      static_cast<int>(unpitched_voices.size());
+
+  QList<MidiTrack> tracks(1 + number_of_pitched_voices +
+                          number_of_unpitched_voices);
+  add_track_event(
+      tracks[0],
+      {.tick = 0,
+       .tie_break = 0,
+       .info = TempoEventInfo{.microseconds_per_quarter =
+                                  MIDI_MICROSECONDS_PER_QUARTER}});
+  for (auto voice_number = 0; voice_number < number_of_pitched_voices;
+       voice_number = voice_number + 1) {
+    add_track_event(
+        tracks[1 + voice_number],
+        {.tick = 0,
+         .tie_break = 0,
+         .info = TrackNameEventInfo{
+             .name_bytes = pitched_voices.at(voice_number).name.toUtf8()}});
+  }
+  for (auto voice_number = 0; voice_number < number_of_unpitched_voices;
+       voice_number = voice_number + 1) {
+    add_track_event(
+        tracks[1 + number_of_pitched_voices + voice_number],
+        {.tick = 0,
+         .tie_break = 0,
+         .info = TrackNameEventInfo{
+             .name_bytes = unpitched_voices.at(voice_number).name.toUtf8()}});
+  }
+
+  const auto& pitched_channels = get_pitched_midi_channels();
+  QList<double> pitched_channel_end_times(pitched_channels.size(), 0.0);
+  QList<MidiTuningChannel> tuning_channels;
+  if (use_tuning_messages) {
+    static const auto MIDI_RPN_MSB_CONTROLLER = 101U;
+    static const auto MIDI_RPN_LSB_CONTROLLER = 100U;
+    static const auto MIDI_DATA_ENTRY_MSB_CONTROLLER = 6U;
+    static const auto MIDI_TUNING_PROGRAM_SELECT_RPN = 3U;
+    static const auto MIDI_NULL_RPN = 127U;
+    tuning_channels.resize(pitched_channels.size());
+    // each channel gets a tuning program of its own, numbered after the
+    // channel, like key tuning playback, so retuning a key on one channel
+    // never touches any other. The registered parameter is deselected again
+    // afterwards, so a stray data entry can't change it
+    for (const auto channel_number : pitched_channels) {
+      const auto channel = static_cast<unsigned int>(channel_number);
+      for (const auto& [controller, value] :
+           {std::pair{MIDI_RPN_MSB_CONTROLLER, 0U},
+            std::pair{MIDI_RPN_LSB_CONTROLLER, MIDI_TUNING_PROGRAM_SELECT_RPN},
+            std::pair{MIDI_DATA_ENTRY_MSB_CONTROLLER, channel},
+            std::pair{MIDI_RPN_MSB_CONTROLLER, MIDI_NULL_RPN},
+            std::pair{MIDI_RPN_LSB_CONTROLLER, MIDI_NULL_RPN}}) {
+        add_track_event(tracks[0],
+                        {.tick = 0,
+                         .tie_break = 0,
+                         .info = ControlChangeEventInfo{
+                             .channel_number = channel,
+                             .controller = controller,
+                             .value = value}});
+      }
+    }
+  }
+
+  // General MIDI has exactly one percussion channel, so two unpitched
+  // voices with different programs can't both sound at the same tick --
+  // a program change is channel-wide state, and only one can be in effect
+  // when the resulting note-ons fire
+  auto has_percussion_program = false;
+  auto percussion_tick = 0.0;
+  short percussion_preset_number = 0;
+
+  // passes play in order, and each one's notes are in start order, so a
+  // voice's notes still go into its track in start order
+  std::vector<std::pair<const PlannedNote*, double>> played_notes;
+  for (const auto& pass : playback_plan.passes) {
+    for (const auto& planned_note :
+         get_planned_chords(playback_plan, pass.first_chord_number,
+                            pass.number_of_chords)) {
+      played_notes.emplace_back(&planned_note, pass.time_offset);
+    }
+  }
+
+  for (const auto& [planned_note_pointer, time_offset] : played_notes) {
+    const auto& planned_note = get_reference(planned_note_pointer);
+    const auto start_tick = planned_note.start_time + time_offset;
+    const auto end_tick = planned_note.end_time + time_offset;
+
+    // the same checks live playback makes -- export aborts on the same
+    // problems, rather than silently clamping and producing a file with
+    // quieter notes than the user asked for
+    auto maybe_warning = get_planned_note_warning(planned_note);
+    if (maybe_warning.has_value()) {
+      warning = std::move(*maybe_warning);
+      return std::nullopt;
+    }
+    const auto velocity = planned_note.velocity;
+    const auto& program = get_reference(planned_note.program_pointer);
+
+    if (planned_note.is_pitched) {
+      const auto midi_float = planned_note.midi_number;
+      auto& track = tracks[1 + planned_note.voice_number];
+
+      auto channel_number = 0;
+      auto key = 0;
+      // a shared channel keeps its program and breath from note to note
+      auto needs_program_change = true;
+      auto needs_breath = true;
+      if (use_tuning_messages) {
+        const auto maybe_note_slot = get_midi_tuning_slot(
+            tuning_channels, program, midi_float, velocity, start_tick);
+        if (!maybe_note_slot.has_value()) {
+          warning = get_channels_exhausted_warning();
+          return std::nullopt;
+        }
+        const auto channel_index = maybe_note_slot->channel_index;
+        key = maybe_note_slot->key;
+        channel_number = pitched_channels.at(channel_index);
+
+        auto& tuning_channel = tuning_channels[channel_index];
+        needs_program_change = tuning_channel.program_pointer != &program;
+        tuning_channel.program_pointer = &program;
+        needs_breath = tuning_channel.breath != velocity;
+        tuning_channel.breath = velocity;
+        const auto release_time = end_tick + program.release_milliseconds;
+        tuning_channel.release_time =
+            std::max(tuning_channel.release_time, release_time);
+        tuning_channel.key_end_times[key] = end_tick;
+        tuning_channel.key_release_times[key] = release_time;
+
+        auto& key_midi_number = tuning_channel.key_midi_numbers[key];
+        if (key_midi_number != midi_float) {
+          add_track_event(
+              track,
+              {.tick = start_tick,
+               .tie_break = MIDI_EXPORT_NOTE_TUNING_TIE_BREAK,
+               .info = NoteTuningEventInfo{
+                   .tuning_program = static_cast<unsigned int>(channel_number),
+                   .key = static_cast<unsigned int>(key),
+                   .midi_number = midi_float}});
+          key_midi_number = midi_float;
+        }
+      } else {
+        key = to_int(midi_float);
+        const auto channel_index = static_cast<int>(std::distance(
+            std::begin(pitched_channel_end_times),
+            std::ranges::min_element(pitched_channel_end_times)));
+        if (pitched_channel_end_times.at(channel_index) > start_tick) {
+          warning = get_channels_exhausted_warning();
+          return std::nullopt;
+        }
+        channel_number = pitched_channels.at(channel_index);
+        pitched_channel_end_times[channel_index] =
+            end_tick + program.release_milliseconds;
+
+        const auto bend = to_int((midi_float - key + ZERO_BEND_HALFSTEPS) *
+                                 BEND_PER_HALFSTEP);
+        add_track_event(
+            track,
+            {.tick = start_tick,
+             .tie_break = MIDI_EXPORT_PITCH_BEND_TIE_BREAK,
+             .info = PitchBendEventInfo{
+                 .channel_number = static_cast<unsigned int>(channel_number),
+                 .bend_14_bit = static_cast<unsigned int>(bend)}});
+      }
+
+      // no bank-select here: program.bank_number is this soundfont's own
+      // private numbering (e.g. 17 for "Expr." variants), not a portable GM2
+      // bank -- an unrecognized bank-select MSB is undefined behavior on
+      // generic GM2 hardware, so the exported instrument intentionally falls
+      // back to the plain bank-0 sibling everywhere except when reopened with
+      // this exact soundfont
+      if (needs_program_change) {
+        add_track_event(
+            track,
+            {.tick = start_tick,
+             .tie_break = MIDI_EXPORT_PROGRAM_CHANGE_TIE_BREAK,
+             .info = ProgramChangeEventInfo{
+                 .channel_number = static_cast<unsigned int>(channel_number),
+                 .program_number =
+                     static_cast<unsigned int>(program.preset_number)}});
+      }
+
+      // mirrors play_note's live-playback behavior: single note dynamics
+      // (see MS_Basic.sf3's "Expr." presets) read note volume from
+      // the breath controller, not note-on velocity, so both must carry the
+      // same value for expressive instruments to have correct dynamics.
+      // Breath is channel-wide, which is why only notes with the same
+      // velocity share a channel when exporting with tuning messages
+      if (needs_breath) {
+        add_track_event(
+            track,
+            {.tick = start_tick,
+             .tie_break = MIDI_EXPORT_BREATH_TIE_BREAK,
+             .info = ControlChangeEventInfo{
+                 .channel_number = static_cast<unsigned int>(channel_number),
+                 .controller = BREATH_ID,
+                 .value = static_cast<unsigned int>(velocity)}});
+      }
+
+      emit_note_events(track, static_cast<unsigned int>(channel_number),
+                       static_cast<unsigned int>(key),
+                       static_cast<unsigned int>(velocity), start_tick,
+                       end_tick);
+    } else {
+      if (has_percussion_program && start_tick == percussion_tick &&
+          program.preset_number != percussion_preset_number) {
+        QString message;
+        QTextStream stream(&message);
+        stream << QObject::tr("Percussion instrument ") << program.name;
+        add_note_location<UnpitchedNote>(stream, planned_note.chord_number,
+                                         planned_note.note_number);
+        stream << QObject::tr(
+            " starts at the same time as a different percussion instrument "
+            "on the shared MIDI percussion channel");
+        warning = {.title = QObject::tr("Percussion channel conflict"),
+                   .message = message};
+        return std::nullopt;
+      }
+      has_percussion_program = true;
+      percussion_tick = start_tick;
+      percussion_preset_number = program.preset_number;
+
+      auto& track =
+          tracks[1 + number_of_pitched_voices + planned_note.voice_number];
+      add_track_event(
+          track,
+          {.tick = start_tick,
+           .tie_break = MIDI_EXPORT_BANK_SELECT_TIE_BREAK,
+           .info = ControlChangeEventInfo{
+               .channel_number =
+                   static_cast<unsigned int>(MIDI_PERCUSSION_CHANNEL),
+               .controller = MIDI_BANK_SELECT_MSB_CONTROLLER,
+               .value = GM2_PERCUSSION_BANK_SELECT_MSB}});
+
+      add_track_event(
+          track,
+          {.tick = start_tick,
+           .tie_break = MIDI_EXPORT_PROGRAM_CHANGE_TIE_BREAK,
+           .info = ProgramChangeEventInfo{
+               .channel_number =
+                   static_cast<unsigned int>(MIDI_PERCUSSION_CHANNEL),
+               .program_number =
+                   static_cast<unsigned int>(program.preset_number)}});
+
+      emit_note_events(
+          track, static_cast<unsigned int>(MIDI_PERCUSSION_CHANNEL),
+          static_cast<unsigned int>(planned_note.midi_number),
+          static_cast<unsigned int>(velocity), start_tick, end_tick);
+    }
+  }
+
+  return get_midi_file_bytes(tracks, MIDI_TICKS_PER_QUARTER);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <optional>
+
+#include "other/UserWarning.hpp"
+
+struct PlaybackPlan;
+struct Song;
+
+// a standard MIDI file of the song, from its compiled playback_plan, or
+// nothing if one of its notes can't be written. With use_tuning_messages,
+// pitched notes are tuned with MIDI Tuning Standard messages rather than
+// pitch bends, so, like key tuning playback, overlapping notes of one
+// program can share a channel, each on a key of its own, instead of every
+// sounding note needing one of the file's 15 pitched channels
+[[nodiscard]] auto get_song_midi_bytes(const Song& song,
+                                       const PlaybackPlan& playback_plan,
+                                       bool use_tuning_messages,
+                                       UserWarning& warning)
+    -> std::optional<QByteArray>;
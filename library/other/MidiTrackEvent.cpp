@@ -1,6 +1,11 @@
 #include "other/MidiTrackEvent.hpp"
 
 #include <QtCore/QList>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "other/helpers.hpp"
 
 namespace {
 const auto MIDI_BITS_PER_BYTE = 8U;
@@ -12,24 +17,41 @@ const auto MIDI_DATA_BYTE_MASK = 0x7FU;  // a 7-bit data byte, or one
                                          // septet
 const auto MIDI_CHANNEL_MASK = 0x0FU;
 const auto MIDI_BYTE_MASK = 0xFFU;
+const auto MIDI_CHUNK_ID_LENGTH = 4;
+const auto MIDI_CHUNK_LENGTH_SIZE = 4;
+const auto MIDI_CHUNK_HEADER_SIZE =
+    MIDI_CHUNK_ID_LENGTH + MIDI_CHUNK_LENGTH_SIZE;
+// a status byte and two data bytes
+const auto MIDI_CHANNEL_EVENT_SIZE = 3;
+// a status byte and one data byte
+const auto MIDI_PROGRAM_CHANGE_SIZE = 2;
+const auto MIDI_TEMPO_PAYLOAD_SIZE = 3;
+// universal real-time id, all devices, tuning, single note change, the
+// tuning program, one change, then the key and its three frequency bytes,
+// ending with the end-of-exclusive byte
+const auto MIDI_NOTE_TUNING_PAYLOAD_SIZE = 11;
 }  // namespace
 
 void append_variable_length(QByteArray& bytes, unsigned int value) {
   static const auto MIDI_CONTINUATION_BIT = 0x80U;  // marks a non-final
                                                     // variable-length-quantity
                                                     // byte
-  QList<unsigned int> septets;
-  septets.push_back(value & MIDI_DATA_BYTE_MASK);
+  // enough septets for any 32-bit value
+  static const auto MAX_VARIABLE_LENGTH_SIZE = 5;
+  std::array<unsigned int, MAX_VARIABLE_LENGTH_SIZE> septets{};
+  auto number_of_septets = 0;
+  septets.at(number_of_septets) = value & MIDI_DATA_BYTE_MASK;
+  number_of_septets = number_of_septets + 1;
   value = value >> MIDI_SEPTET_BITS;
   while (value > 0) {
-    septets.push_back(value & MIDI_DATA_BYTE_MASK);
+    septets.at(number_of_septets) = value & MIDI_DATA_BYTE_MASK;
+    number_of_septets = number_of_septets + 1;
     value = value >> MIDI_SEPTET_BITS;
   }
   // septets were collected least-significant-first; the MIDI variable-length
   // encoding is written most-significant-first, with the continuation bit
   // set on every byte except the last
-  for (auto index = static_cast<int>(septets.size()) - 1; index >= 0;
-       index = index - 1) {
+  for (auto index = number_of_septets - 1; index >= 0; index = index - 1) {
     auto byte = septets.at(index);
     if (index != 0) {
       byte = byte | MIDI_CONTINUATION_BIT;
@@ -38,18 +60,46 @@ void append_variable_length(QByteArray& bytes, unsigned int value) {
   }
 }
 
-void append_meta_event(QByteArray& bytes, unsigned int type,
-                       const QByteArray& payload) {
+auto get_variable_length_size(unsigned int value) -> int {
+  auto size = 1;
+  value = value >> MIDI_SEPTET_BITS;
+  while (value > 0) {
+    size = size + 1;
+    value = value >> MIDI_SEPTET_BITS;
+  }
+  return size;
+}
+
+namespace {
+
+// the two bytes before a meta event's variable-length payload size
+const auto MIDI_META_EVENT_PREFIX_SIZE = 2;
+
+void append_meta_event_header(QByteArray& bytes, const unsigned int type,
+                              const unsigned int length) {
   static const auto MIDI_META_EVENT_PREFIX = 0xFFU;
   bytes.append(static_cast<char>(MIDI_META_EVENT_PREFIX));
   bytes.append(static_cast<char>(type));
-  append_variable_length(bytes, static_cast<unsigned int>(payload.size()));
+  append_variable_length(bytes, length);
+}
+
+auto get_meta_event_size(const int length) -> int {
+  return MIDI_META_EVENT_PREFIX_SIZE +
+         get_variable_length_size(static_cast<unsigned int>(length)) + length;
+}
+
+}  // namespace
+
+void append_meta_event(QByteArray& bytes, unsigned int type,
+                       const QByteArray& payload) {
+  append_meta_event_header(bytes, type,
+                           static_cast<unsigned int>(payload.size()));
   bytes.append(payload);
 }
 
-void append_track_name_meta(QByteArray& bytes, const QString& name) {
+void append_track_name_meta(QByteArray& bytes, const QByteArray& name_bytes) {
   static const auto MIDI_TRACK_NAME_META_TYPE = 0x03U;
-  append_meta_event(bytes, MIDI_TRACK_NAME_META_TYPE, name.toUtf8());
+  append_meta_event(bytes, MIDI_TRACK_NAME_META_TYPE, name_bytes);
 }
 
 void append_control_change(QByteArray& bytes, unsigned int channel_number,
@@ -97,17 +147,62 @@ void append_pitch_bend(QByteArray& bytes, unsigned int channel_number,
                                  MIDI_DATA_BYTE_MASK));
 }
 
+void append_note_tuning(QByteArray& bytes, unsigned int tuning_program,
+                        unsigned int key, double midi_number) {
+  static const auto MIDI_SYSTEM_EXCLUSIVE_STATUS = 0xF0U;
+  static const auto MIDI_END_OF_EXCLUSIVE = 0xF7U;
+  static const auto MIDI_REAL_TIME_ID = 0x7FU;
+  static const auto MIDI_ALL_DEVICES_ID = 0x7FU;
+  static const auto MIDI_TUNING_ID = 0x08U;
+  static const auto MIDI_SINGLE_NOTE_TUNING_ID = 0x02U;
+  static const auto MAX_SEMITONE = 127;
+  // two septets of fraction, so 1/16384 of a semitone
+  static const auto FRACTION_STEPS = 1 << (2 * MIDI_SEPTET_BITS);
+  // 7F 7F 7F means "no change", so the highest pitch is one step below it
+  static const auto MAX_FRACTION = FRACTION_STEPS - 2;
+
+  auto semitone = static_cast<int>(std::floor(midi_number));
+  auto fraction = static_cast<int>(
+      std::lround((midi_number - semitone) * FRACTION_STEPS));
+  if (fraction == FRACTION_STEPS) {
+    semitone = semitone + 1;
+    fraction = 0;
+  }
+  if (semitone < 0) {
+    semitone = 0;
+    fraction = 0;
+  } else if (semitone >= MAX_SEMITONE) {
+    fraction = semitone > MAX_SEMITONE ? MAX_FRACTION
+                                       : std::min(fraction, MAX_FRACTION);
+    semitone = MAX_SEMITONE;
+  }
+  const auto fraction_bits = static_cast<unsigned int>(fraction);
+
+  bytes.append(static_cast<char>(MIDI_SYSTEM_EXCLUSIVE_STATUS));
+  append_variable_length(bytes, MIDI_NOTE_TUNING_PAYLOAD_SIZE);
+  bytes.append(static_cast<char>(MIDI_REAL_TIME_ID));
+  bytes.append(static_cast<char>(MIDI_ALL_DEVICES_ID));
+  bytes.append(static_cast<char>(MIDI_TUNING_ID));
+  bytes.append(static_cast<char>(MIDI_SINGLE_NOTE_TUNING_ID));
+  bytes.append(static_cast<char>(tuning_program & MIDI_DATA_BYTE_MASK));
+  bytes.append(static_cast<char>(1));
+  bytes.append(static_cast<char>(key & MIDI_DATA_BYTE_MASK));
+  bytes.append(static_cast<char>(semitone));
+  bytes.append(static_cast<char>((fraction_bits >> MIDI_SEPTET_BITS) &
+                                 MIDI_DATA_BYTE_MASK));
+  bytes.append(static_cast<char>(fraction_bits & MIDI_DATA_BYTE_MASK));
+  bytes.append(static_cast<char>(MIDI_END_OF_EXCLUSIVE));
+}
+
 void append_be16(QByteArray& bytes, unsigned int value) {
   bytes.append(
       static_cast<char>((value >> MIDI_BITS_PER_BYTE) & MIDI_BYTE_MASK));
   bytes.append(static_cast<char>(value & MIDI_BYTE_MASK));
 }
 
-void append_chunk(QByteArray& output, const char* const chunk_id,
-                  const QByteArray& chunk_data) {
-  static const auto MIDI_CHUNK_ID_LENGTH = 4;
+void append_chunk_header(QByteArray& output, const char* const chunk_id,
+                         const unsigned int length) {
   output.append(chunk_id, MIDI_CHUNK_ID_LENGTH);
-  const auto length = static_cast<unsigned int>(chunk_data.size());
   output.append(
       static_cast<char>((length >> (3 * MIDI_BITS_PER_BYTE)) & MIDI_BYTE_MASK));
   output.append(
@@ -115,43 +210,93 @@ void append_chunk(QByteArray& output, const char* const chunk_id,
   output.append(
       static_cast<char>((length >> MIDI_BITS_PER_BYTE) & MIDI_BYTE_MASK));
   output.append(static_cast<char>(length & MIDI_BYTE_MASK));
+}
+
+void append_chunk(QByteArray& output, const char* const chunk_id,
+                  const QByteArray& chunk_data) {
+  append_chunk_header(output, chunk_id,
+                      static_cast<unsigned int>(chunk_data.size()));
   output.append(chunk_data);
 }
 
+auto TempoEventInfo::get_size() const -> int {
+  return get_meta_event_size(MIDI_TEMPO_PAYLOAD_SIZE);
+}
+
 void TempoEventInfo::write(QByteArray& track_data) const {
-  QByteArray payload;
-  payload.append(static_cast<char>(
+  append_meta_event_header(track_data, MIDI_TEMPO_META_TYPE,
+                           MIDI_TEMPO_PAYLOAD_SIZE);
+  track_data.append(static_cast<char>(
       (microseconds_per_quarter >> (2 * MIDI_BITS_PER_BYTE)) & MIDI_BYTE_MASK));
-  payload.append(static_cast<char>(
+  track_data.append(static_cast<char>(
       (microseconds_per_quarter >> MIDI_BITS_PER_BYTE) & MIDI_BYTE_MASK));
-  payload.append(static_cast<char>(microseconds_per_quarter & MIDI_BYTE_MASK));
-  append_meta_event(track_data, MIDI_TEMPO_META_TYPE, payload);
+  track_data.append(
+      static_cast<char>(microseconds_per_quarter & MIDI_BYTE_MASK));
+}
+
+auto TrackNameEventInfo::get_size() const -> int {
+  return get_meta_event_size(static_cast<int>(name_bytes.size()));
 }
 
 void TrackNameEventInfo::write(QByteArray& track_data) const {
-  append_track_name_meta(track_data, name);
+  append_track_name_meta(track_data, name_bytes);
+}
+
+auto ProgramChangeEventInfo::get_size() const -> int {
+  return MIDI_PROGRAM_CHANGE_SIZE;
 }
 
 void ProgramChangeEventInfo::write(QByteArray& track_data) const {
   append_program_change(track_data, channel_number, program_number);
 }
 
+auto PitchBendEventInfo::get_size() const -> int {
+  return MIDI_CHANNEL_EVENT_SIZE;
+}
+
 void PitchBendEventInfo::write(QByteArray& track_data) const {
   append_pitch_bend(track_data, channel_number, bend_14_bit);
 }
 
+auto ControlChangeEventInfo::get_size() const -> int {
+  return MIDI_CHANNEL_EVENT_SIZE;
+}
+
 void ControlChangeEventInfo::write(QByteArray& track_data) const {
   append_control_change(track_data, channel_number, controller, value);
 }
 
+auto NoteOnEventInfo::get_size() const -> int {
+  return MIDI_CHANNEL_EVENT_SIZE;
+}
+
 void NoteOnEventInfo::write(QByteArray& track_data) const {
   append_note_on(track_data, channel_number, midi_number, velocity);
 }
 
+auto NoteOffEventInfo::get_size() const -> int {
+  return MIDI_CHANNEL_EVENT_SIZE;
+}
+
 void NoteOffEventInfo::write(QByteArray& track_data) const {
   append_note_off(track_data, channel_number, midi_number);
 }
 
+auto NoteTuningEventInfo::get_size() const -> int {
+  // the status byte, then the payload size, which fits in one byte
+  return 1 + 1 + MIDI_NOTE_TUNING_PAYLOAD_SIZE;
+}
+
+void NoteTuningEventInfo::write(QByteArray& track_data) const {
+  append_note_tuning(track_data, tuning_program, key, midi_number);
+}
+
+auto MidiTrackEvent::get_size() const -> int {
+  return std::visit(
+      [](const auto& event_info) -> int { return event_info.get_size(); },
+      info);
+}
+
 void MidiTrackEvent::write(QByteArray& track_data) const {
   std::visit(
       [&track_data](const auto& event_info) -> void {
@@ -159,3 +304,163 @@ void MidiTrackEvent::write(QByteArray& track_data) const {
       },
       info);
 }
+
+void add_track_event(MidiTrack& track, MidiTrackEvent event) {
+  const auto tie_break = event.tie_break;
+  Q_ASSERT(tie_break >= 0);
+  Q_ASSERT(tie_break < NUMBER_OF_MIDI_TIE_BREAKS);
+  auto& ordered_events = track.ordered_events.at(tie_break);
+  // anything that would break a stream's order goes with the unordered
+  // events instead
+  if (tie_break == 0 ||
+      (!ordered_events.empty() && ordered_events.back().tick > event.tick)) {
+    track.unordered_events.push_back(std::move(event));
+  } else {
+    ordered_events.push_back(std::move(event));
+  }
+}
+
+namespace {
+
+auto get_event_order(const MidiTrackEvent& event)
+    -> std::pair<double, int> {
+  return {event.tick, event.tie_break};
+}
+
+auto get_tick(const MidiTrackEvent& event) -> unsigned int {
+  return static_cast<unsigned int>(std::llround(event.tick));
+}
+
+// fills merged_events with the track's events in the order they get
+// written: by tick, then tie_break, then the order they were added in. Both
+// buffers get cleared first, so they can be reused from track to track
+// without allocating again
+void merge_track_events(const MidiTrack& track,
+                        std::vector<int>& unordered_indices,
+                        std::vector<const MidiTrackEvent*>& merged_events) {
+  const auto& unordered_events = track.unordered_events;
+  unordered_indices.resize(unordered_events.size());
+  std::iota(unordered_indices.begin(), unordered_indices.end(), 0);
+  std::ranges::sort(unordered_indices, std::less<>(),
+                    [&unordered_events](const int index) -> auto {
+                      const auto& event = unordered_events.at(index);
+                      return std::make_tuple(event.tick, event.tie_break,
+                                             index);
+                    });
+
+  auto number_of_events = unordered_events.size();
+  for (const auto& ordered_events : track.ordered_events) {
+    number_of_events = number_of_events + ordered_events.size();
+  }
+  merged_events.clear();
+  merged_events.reserve(number_of_events);
+
+  size_t unordered_position = 0;
+  std::array<size_t, NUMBER_OF_MIDI_TIE_BREAKS> ordered_positions{};
+  while (merged_events.size() < number_of_events) {
+    // the unordered events win ties, since tie_break 0 comes first anyway
+    const MidiTrackEvent* next_event_pointer = nullptr;
+    size_t* next_position_pointer = nullptr;
+    if (unordered_position < unordered_indices.size()) {
+      next_event_pointer =
+          &unordered_events.at(unordered_indices.at(unordered_position));
+      next_position_pointer = &unordered_position;
+    }
+    for (auto tie_break = 0; tie_break < NUMBER_OF_MIDI_TIE_BREAKS;
+         tie_break = tie_break + 1) {
+      const auto& ordered_events = track.ordered_events.at(tie_break);
+      auto& ordered_position = ordered_positions.at(tie_break);
+      if (ordered_position < ordered_events.size()) {
+        const auto& event = ordered_events.at(ordered_position);
+        if (next_event_pointer == nullptr ||
+            get_event_order(event) < get_event_order(*next_event_pointer)) {
+          next_event_pointer = &event;
+          next_position_pointer = &ordered_position;
+        }
+      }
+    }
+    merged_events.push_back(next_event_pointer);
+    get_reference(next_position_pointer) =
+        get_reference(next_position_pointer) + 1;
+  }
+}
+
+// at least as many bytes as the event takes up in the file, whatever order
+// it ends up in, since its delta time can't be longer than its tick
+auto get_max_event_size(const MidiTrackEvent& event) -> int {
+  return get_variable_length_size(get_tick(event)) + event.get_size();
+}
+
+// fills in the length append_chunk_header left for a chunk that starts at
+// chunk_position, once its data has been written
+void set_chunk_length(QByteArray& output, const qsizetype chunk_position,
+                      const unsigned int length) {
+  const auto length_position = chunk_position + MIDI_CHUNK_ID_LENGTH;
+  for (auto byte_number = 0; byte_number < MIDI_CHUNK_LENGTH_SIZE;
+       byte_number = byte_number + 1) {
+    const auto shift = static_cast<unsigned int>(
+        (MIDI_CHUNK_LENGTH_SIZE - 1 - byte_number) * MIDI_BITS_PER_BYTE);
+    output[length_position + byte_number] =
+        static_cast<char>((length >> shift) & MIDI_BYTE_MASK);
+  }
+}
+
+}  // namespace
+
+auto get_midi_file_bytes(const QList<MidiTrack>& tracks,
+                         const unsigned int ticks_per_quarter) -> QByteArray {
+  static const auto MIDI_FORMAT_MULTI_TRACK = 1U;
+  static const auto MIDI_HEADER_SIZE = 6;
+  static const auto MIDI_END_OF_TRACK_META_TYPE = 0x2FU;
+  // a zero delta time, then the empty end-of-track meta event
+  static const auto MIDI_END_OF_TRACK_SIZE = 1 + get_meta_event_size(0);
+
+  // the exact size depends on each track's delta times, which aren't known
+  // until its events are merged, so the buffer is reserved for the most the
+  // file could take up, and each track's length is filled in afterwards
+  auto max_file_size = MIDI_CHUNK_HEADER_SIZE + MIDI_HEADER_SIZE;
+  for (const auto& track : tracks) {
+    max_file_size =
+        max_file_size + MIDI_CHUNK_HEADER_SIZE + MIDI_END_OF_TRACK_SIZE;
+    for (const auto& ordered_events : track.ordered_events) {
+      for (const auto& event : ordered_events) {
+        max_file_size = max_file_size + get_max_event_size(event);
+      }
+    }
+    for (const auto& event : track.unordered_events) {
+      max_file_size = max_file_size + get_max_event_size(event);
+    }
+  }
+
+  QByteArray output;
+  output.reserve(max_file_size);
+
+  append_chunk_header(output, "MThd", MIDI_HEADER_SIZE);
+  append_be16(output, MIDI_FORMAT_MULTI_TRACK);
+  append_be16(output, static_cast<unsigned int>(tracks.size()));
+  append_be16(output, ticks_per_quarter);
+
+  // shared by every track, so they only grow as big as the biggest one
+  std::vector<int> unordered_indices;
+  std::vector<const MidiTrackEvent*> merged_events;
+  for (const auto& track : tracks) {
+    merge_track_events(track, unordered_indices, merged_events);
+    const auto chunk_position = output.size();
+    append_chunk_header(output, "MTrk", 0);
+    auto previous_tick = 0U;
+    for (const auto* const event_pointer : merged_events) {
+      const auto& event = get_reference(event_pointer);
+      const auto tick = get_tick(event);
+      append_variable_length(output, tick - previous_tick);
+      event.write(output);
+      previous_tick = tick;
+    }
+    append_variable_length(output, 0);
+    append_meta_event_header(output, MIDI_END_OF_TRACK_META_TYPE, 0);
+    set_chunk_length(output, chunk_position,
+                     static_cast<unsigned int>(output.size() - chunk_position -
+                                               MIDI_CHUNK_HEADER_SIZE));
+  }
+  Q_ASSERT(output.size() <= max_file_size);
+  return output;
+}
@@ -1,15 +1,26 @@
 #pragma once
 
-#include <QtCore/QString>
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <array>
+#include <variant>
+#include <vector>
 
 static const auto MIDI_TEMPO_META_TYPE = 0x51U;
+// every MidiTrackEvent's tie_break is below this
+static const auto NUMBER_OF_MIDI_TIE_BREAKS = 6;
 
+// encodes on the stack, so appending to a reserved buffer never allocates
 void append_variable_length(QByteArray& bytes, unsigned int value);
 
+// how many bytes append_variable_length writes for value
+[[nodiscard]] auto get_variable_length_size(unsigned int value) -> int;
+
 void append_meta_event(QByteArray& bytes, unsigned int type,
                        const QByteArray& payload);
 
-void append_track_name_meta(QByteArray& bytes, const QString& name);
+// name_bytes is the name, already encoded as UTF-8
+void append_track_name_meta(QByteArray& bytes, const QByteArray& name_bytes);
 
 void append_control_change(QByteArray& bytes, unsigned int channel_number,
                            unsigned int controller, unsigned int value);
@@ -26,28 +37,42 @@ void append_note_off(QByteArray& bytes, unsigned int channel_number,
 void append_pitch_bend(QByteArray& bytes, unsigned int channel_number,
                        unsigned int bend_14_bit);
 
+// a MIDI Tuning Standard real-time single note tuning change: from now on,
+// key (in tuning_program) sounds at midi_number, which can be fractional
+void append_note_tuning(QByteArray& bytes, unsigned int tuning_program,
+                        unsigned int key, double midi_number);
+
 void append_be16(QByteArray& bytes, unsigned int value);
 
+// the chunk's data follows, length bytes of it
+void append_chunk_header(QByteArray& output, const char* chunk_id,
+                         unsigned int length);
+
 void append_chunk(QByteArray& output, const char* chunk_id,
                   const QByteArray& chunk_data);
 
 // base of the per-event-kind payload hierarchy; each subclass knows how to
-// write only its own bytes, so a MidiTrackEvent never owns a QByteArray of
-// its own -- the payload is written straight into the track's shared buffer
-// at export time instead of being allocated and copied per event. Dispatch
-// goes through std::visit on MidiEventPayload below, never through an
-// EventInfo pointer/reference, so this base stays non-polymorphic
+// write only its own bytes, and how many there are, so a file's size can be
+// worked out before any of it is written. A MidiTrackEvent never owns a
+// QByteArray of its own -- the payload is written straight into the file's
+// one buffer at export time instead of being allocated and copied per
+// event. Dispatch goes through std::visit on MidiEventPayload below, never
+// through an EventInfo pointer/reference, so this base stays non-polymorphic
 struct EventInfo {};
 
 struct TempoEventInfo : EventInfo {
   unsigned int microseconds_per_quarter = 0;
 
+  [[nodiscard]] auto get_size() const -> int;
   void write(QByteArray& track_data) const;
 };
 
 struct TrackNameEventInfo : EventInfo {
-  QString name;
+  // encoded as UTF-8 once, when the event is made, rather than again each
+  // time its size is needed or it's written
+  QByteArray name_bytes;
 
+  [[nodiscard]] auto get_size() const -> int;
   void write(QByteArray& track_data) const;
 };
 
@@ -55,6 +80,7 @@ struct ProgramChangeEventInfo : EventInfo {
   unsigned int channel_number = 0;
   unsigned int program_number = 0;
 
+  [[nodiscard]] auto get_size() const -> int;
   void write(QByteArray& track_data) const;
 };
 
@@ -62,6 +88,7 @@ struct PitchBendEventInfo : EventInfo {
   unsigned int channel_number = 0;
   unsigned int bend_14_bit = 0;
 
+  [[nodiscard]] auto get_size() const -> int;
   void write(QByteArray& track_data) const;
 };
 
@@ -70,6 +97,7 @@ struct ControlChangeEventInfo : EventInfo {
   unsigned int controller = 0;
   unsigned int value = 0;
 
+  [[nodiscard]] auto get_size() const -> int;
   void write(QByteArray& track_data) const;
 };
 
@@ -78,6 +106,7 @@ struct NoteOnEventInfo : EventInfo {
   unsigned int midi_number = 0;
   unsigned int velocity = 0;
 
+  [[nodiscard]] auto get_size() const -> int;
   void write(QByteArray& track_data) const;
 };
 
@@ -85,13 +114,23 @@ struct NoteOffEventInfo : EventInfo {
   unsigned int channel_number = 0;
   unsigned int midi_number = 0;
 
+  [[nodiscard]] auto get_size() const -> int;
+  void write(QByteArray& track_data) const;
+};
+
+struct NoteTuningEventInfo : EventInfo {
+  unsigned int tuning_program = 0;
+  unsigned int key = 0;
+  double midi_number = 0;
+
+  [[nodiscard]] auto get_size() const -> int;
   void write(QByteArray& track_data) const;
 };
 
 using MidiEventPayload =
     std::variant<TempoEventInfo, TrackNameEventInfo, ProgramChangeEventInfo,
                  PitchBendEventInfo, ControlChangeEventInfo, NoteOnEventInfo,
-                 NoteOffEventInfo>;
+                 NoteOffEventInfo, NoteTuningEventInfo>;
 
 // a single channel or meta event, timed in absolute ticks; tie_break orders
 // same-tick events (lower first), e.g. so a note-off lands before a note-on
@@ -102,5 +141,27 @@ struct MidiTrackEvent {
   int tie_break = 0;
   MidiEventPayload info;
 
+  [[nodiscard]] auto get_size() const -> int;
   void write(QByteArray& track_data) const;
 };
+
+// a track's events, split into streams that each come out of
+// export_midi_to_file already in order: one per tie_break, since a voice's
+// notes are added in start order, except that note-offs (tie_break 0, along
+// with the meta events at tick 0) go in unordered, since a long note can end
+// after a later, shorter one. Writing the track is then a merge of the
+// streams, with only the unordered events' keys needing a sort, rather than
+// a sort of a copy of every event
+struct MidiTrack {
+  std::array<std::vector<MidiTrackEvent>, NUMBER_OF_MIDI_TIE_BREAKS>
+      ordered_events;
+  std::vector<MidiTrackEvent> unordered_events;
+};
+
+void add_track_event(MidiTrack& track, MidiTrackEvent event);
+
+// a standard MIDI file, format 1, written into a buffer reserved up front,
+// with the tracks merged one at a time into one shared list
+[[nodiscard]] auto get_midi_file_bytes(const QList<MidiTrack>& tracks,
+                                       unsigned int ticks_per_quarter)
+    -> QByteArray;
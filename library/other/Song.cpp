@@ -1,7 +1,67 @@
 #include "other/Song.hpp"
 
+#include "other/StringPool.hpp"
 #include "rows/Chord.hpp"
 
+namespace {
+
+void append_played_run(QList<PlayedRun>& played_runs,
+                       const int first_chord_number,
+                       const int end_chord_number) {
+  if (first_chord_number >= end_chord_number) {
+    return;
+  }
+  // runs that pick up right where the last left off can play as one
+  if (!played_runs.isEmpty()) {
+    auto& last_run = played_runs.back();
+    if (last_run.first_chord_number + last_run.number_of_chords ==
+        first_chord_number) {
+      last_run.number_of_chords =
+          end_chord_number - last_run.first_chord_number;
+      return;
+    }
+  }
+  played_runs.push_back(
+      PlayedRun{.first_chord_number = first_chord_number,
+                .number_of_chords = end_chord_number - first_chord_number});
+}
+
+// repeat_number is the first repeat that might start in the chords, and
+// ends up at the first repeat after them
+void append_played_runs(QList<PlayedRun>& played_runs,
+                        const QList<Repeat>& repeats, qsizetype& repeat_number,
+                        const int first_chord_number,
+                        const int end_chord_number) {
+  auto chord_number = first_chord_number;
+  while (repeat_number < repeats.size() &&
+         repeats.at(repeat_number).first_chord_number < end_chord_number) {
+    const auto& repeat = repeats.at(repeat_number);
+    const auto repeat_end_number =
+        repeat.first_chord_number + repeat.number_of_chords;
+    append_played_run(played_runs, chord_number, repeat.first_chord_number);
+    repeat_number = repeat_number + 1;
+    // every pass goes through the same nested repeats again
+    const auto nested_repeat_number = repeat_number;
+    for (auto pass_number = 0; pass_number < repeat.times;
+         pass_number = pass_number + 1) {
+      repeat_number = nested_repeat_number;
+      append_played_runs(played_runs, repeats, repeat_number,
+                         repeat.first_chord_number, repeat_end_number);
+    }
+    chord_number = repeat_end_number;
+  }
+  append_played_run(played_runs, chord_number, end_chord_number);
+}
+
+template <NoteInterface SubNote>
+void pool_notes_words(StringPool& string_pool, QList<SubNote>& notes) {
+  for (auto& note : notes) {
+    note.words = get_pooled_string(string_pool, note.words);
+  }
+}
+
+}  // namespace
+
 Song::Song() : starting_key(midi_number_to_frequency(DEFAULT_STARTING_MIDI)) {}
 
 auto get_octave_degree(int midi_interval) -> std::tuple<int, int> {
@@ -11,8 +71,26 @@ auto get_octave_degree(int midi_interval) -> std::tuple<int, int> {
                          midi_interval - (octave * HALFSTEPS_PER_OCTAVE));
 }
 
+auto make_song_snapshot(const Song& song) -> std::shared_ptr<const Song> {
+  auto snapshot_pointer = std::make_shared<Song>(song);
+  // the chords' own notes are still shared, and copied on write
+  snapshot_pointer->chords.detach();
+  return snapshot_pointer;
+}
+
+void pool_song_words(Song& song) {
+  StringPool string_pool;
+  for (auto& chord : song.chords) {
+    chord.words = get_pooled_string(string_pool, chord.words);
+    pool_notes_words(string_pool, chord.pitched_notes);
+    pool_notes_words(string_pool, chord.unpitched_notes);
+  }
+}
+
 void initialize_playstate(const Song& song, PlayState& play_state,
                           double current_time) {
+  play_state.starting_key = song.starting_key;
+  play_state.key_monzo = Monzo();
   play_state.current_key = song.starting_key;
   play_state.current_velocity = song.starting_velocity;
   play_state.current_tempo = song.starting_tempo;
@@ -34,6 +112,95 @@ auto get_play_state_at_chord(const Song& song, const int chord_number)
   return play_state;
 }
 
+auto get_repeats_warning(const QList<Repeat>& repeats,
+                         const int number_of_chords)
+    -> std::optional<UserWarning> {
+  // where each repeat that later ones might still be nested in ends,
+  // innermost last
+  QList<int> end_chord_numbers;
+  auto last_first_chord_number = 0;
+  for (auto repeat_number = 0; repeat_number < repeats.size();
+       repeat_number = repeat_number + 1) {
+    const auto& repeat = repeats.at(repeat_number);
+    const auto first_chord_number = repeat.first_chord_number;
+    if (first_chord_number < 0 || first_chord_number >= number_of_chords ||
+        repeat.number_of_chords < 1 ||
+        repeat.number_of_chords > number_of_chords - first_chord_number ||
+        repeat.times < 1 || repeat.times > MAX_REPEAT_TIMES) {
+      QString message;
+      QTextStream stream(&message);
+      stream << QObject::tr("Repeat ") << repeat_number + 1
+             << QObject::tr(" doesn't fit within the chords");
+      return UserWarning{.title = QObject::tr("Repeat error"),
+                         .message = message};
+    }
+    const auto end_chord_number =
+        first_chord_number + repeat.number_of_chords;
+    while (!end_chord_numbers.isEmpty() &&
+           end_chord_numbers.back() <= first_chord_number) {
+      end_chord_numbers.pop_back();
+    }
+    if (first_chord_number < last_first_chord_number ||
+        (!end_chord_numbers.isEmpty() &&
+         end_chord_number > end_chord_numbers.back())) {
+      QString message;
+      QTextStream stream(&message);
+      stream << QObject::tr("Repeat ") << repeat_number + 1
+             << QObject::tr(" is out of order, or overlaps an earlier repeat");
+      return UserWarning{.title = QObject::tr("Repeat error"),
+                         .message = message};
+    }
+    end_chord_numbers.push_back(end_chord_number);
+    last_first_chord_number = first_chord_number;
+  }
+  return std::nullopt;
+}
+
+auto get_played_runs(const Song& song) -> QList<PlayedRun> {
+  QList<PlayedRun> played_runs;
+  qsizetype repeat_number = 0;
+  append_played_runs(played_runs, song.repeats, repeat_number, 0,
+                     static_cast<int>(song.chords.size()));
+  return played_runs;
+}
+
+void insert_repeat_chords(QList<Repeat>& repeats,
+                          const int first_chord_number,
+                          const int number_of_chords) {
+  for (auto& repeat : repeats) {
+    if (first_chord_number <= repeat.first_chord_number) {
+      repeat.first_chord_number =
+          repeat.first_chord_number + number_of_chords;
+    } else if (first_chord_number <
+               repeat.first_chord_number + repeat.number_of_chords) {
+      repeat.number_of_chords = repeat.number_of_chords + number_of_chords;
+    }
+  }
+}
+
+void remove_repeat_chords(QList<Repeat>& repeats,
+                          const int first_chord_number,
+                          const int number_of_chords) {
+  const auto end_chord_number = first_chord_number + number_of_chords;
+  for (auto& repeat : repeats) {
+    const auto repeat_end_number =
+        repeat.first_chord_number + repeat.number_of_chords;
+    const auto removed_before =
+        std::clamp(repeat.first_chord_number, first_chord_number,
+                   end_chord_number) -
+        first_chord_number;
+    const auto removed_within =
+        std::max(0, std::min(repeat_end_number, end_chord_number) -
+                        std::max(repeat.first_chord_number,
+                                 first_chord_number));
+    repeat.first_chord_number = repeat.first_chord_number - removed_before;
+    repeat.number_of_chords = repeat.number_of_chords - removed_within;
+  }
+  repeats.removeIf([](const Repeat& repeat) -> auto {
+    return repeat.number_of_chords == 0;
+  });
+}
+
 auto get_note_name(const int closest_midi) -> QString {
   static const QMap<int, QString> degrees_to_name{
       {0, QObject::tr("C")},  {1, QObject::tr("C♯")},  {2, QObject::tr("D")},
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+
 #include "rows/PitchedVoice.hpp"
 #include "rows/UnpitchedVoice.hpp"
 #include "sound/PlayState.hpp"
@@ -7,9 +9,30 @@
 struct Chord;
 
 static const auto C_0_MIDI = 12;
+static const auto DEFAULT_GAIN = 5;
 static const auto DEFAULT_STARTING_MIDI = MIDDLE_C_MIDI;
 static const auto DEFAULT_STARTING_TEMPO = 100;
 static const auto DEFAULT_STARTING_VELOCITY = 64;
+// as many times as song.xsd lets a repeat play
+static const auto MAX_REPEAT_TIMES = 999;
+
+// a run of chords that plays more than once in a row, e.g. a repeated
+// section of a score, without its chords having to be copied. Every pass
+// starts over with the key, velocity and tempo the first one started with,
+// so each sounds the same, just later
+struct Repeat {
+  int first_chord_number = 0;
+  int number_of_chords = 1;
+  int times = 2;
+
+  [[nodiscard]] auto operator==(const Repeat& other) const -> bool = default;
+};
+
+// a run of chords that plays straight through, once
+struct PlayedRun {
+  int first_chord_number = 0;
+  int number_of_chords = 0;
+};
 
 struct Song {
   double starting_key;
@@ -18,18 +41,54 @@ struct Song {
   QList<Chord> chords;
   QList<PitchedVoice> pitched_voices;
   QList<UnpitchedVoice> unpitched_voices;
+  // sorted by first chord, outer repeats before the repeats nested inside
+  // them (see get_repeats_warning)
+  QList<Repeat> repeats;
 
   Song();
 };
 
 [[nodiscard]] auto get_octave_degree(int midi_interval) -> std::tuple<int, int>;
 
+// a copy of song that another thread can go on reading while song is
+// edited. It shares everything it can with song, since Qt's containers copy
+// on write, except the list of chords itself: the notes models point
+// straight into song's chords, which mustn't move when song is next edited
+[[nodiscard]] auto make_song_snapshot(const Song& song)
+    -> std::shared_ptr<const Song>;
+
+// lets chords and notes with the same words share one copy of them (see
+// StringPool), for a freshly read song, which would otherwise have a copy
+// per row
+void pool_song_words(Song& song);
+
 void initialize_playstate(const Song& song, PlayState& play_state,
                           double current_time);
 
 [[nodiscard]] auto get_play_state_at_chord(const Song& song, int chord_number)
     -> PlayState;
 
+// the first problem, if any, with repeats: every repeat has to fit within
+// the chords, and any two have to be either apart or nested
+[[nodiscard]] auto get_repeats_warning(const QList<Repeat>& repeats,
+                                       int number_of_chords)
+    -> std::optional<UserWarning>;
+
+// the song's chords, in the order they play, with every repeat expanded.
+// There's a run for each pass, not each chord, so this stays short however
+// long the song is
+[[nodiscard]] auto get_played_runs(const Song& song) -> QList<PlayedRun>;
+
+// keeps repeats on the same chords when chords are inserted: chords
+// inserted inside a repeat join it
+void insert_repeat_chords(QList<Repeat>& repeats, int first_chord_number,
+                          int number_of_chords);
+
+// likewise when chords are removed; a repeat that loses all of its chords
+// goes too
+void remove_repeat_chords(QList<Repeat>& repeats, int first_chord_number,
+                          int number_of_chords);
+
 [[nodiscard]] auto get_note_name(int closest_midi) -> QString;
 
 void add_frequency_to_stream(QTextStream& stream, double frequency);
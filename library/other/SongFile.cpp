@@ -0,0 +1,153 @@
+#include "other/SongFile.hpp"
+
+#include <QtCore/QObject>
+
+#include "musicxml/MusicXMLImport.hpp"
+#include "rows/PitchedNote.hpp"
+#include "rows/UnpitchedNote.hpp"
+#include "xml/XMLDocument.hpp"
+#include "xml/XMLValidator.hpp"
+
+namespace {
+
+auto xml_to_double(const xmlNode& element) -> double {
+  // std::stod uses the current C locale; QString::toDouble is always
+  // locale-independent, so this matches set_xml_double in SongWidget.cpp
+  bool was_ok = false;
+  const auto value =
+      QString::fromStdString(get_content(element)).toDouble(&was_ok);
+  Q_ASSERT(was_ok);
+  return value;
+}
+
+auto xml_to_repeats(xmlNode& repeats_node) -> QList<Repeat> {
+  QList<Repeat> repeats;
+  auto* repeat_pointer = xmlFirstElementChild(&repeats_node);
+  while (repeat_pointer != nullptr) {
+    Repeat repeat;
+    auto* field_pointer = xmlFirstElementChild(repeat_pointer);
+    while (field_pointer != nullptr) {
+      auto& field_node = get_reference(field_pointer);
+      const auto name = get_xml_name(field_node);
+      if (name == "first_chord_number") {
+        repeat.first_chord_number = xml_to_int(field_node);
+      } else if (name == "number_of_chords") {
+        repeat.number_of_chords = xml_to_int(field_node);
+      } else if (name == "times") {
+        repeat.times = xml_to_int(field_node);
+      } else {
+        Q_UNREACHABLE();
+      }
+      field_pointer = xmlNextElementSibling(field_pointer);
+    }
+    repeats.push_back(repeat);
+    repeat_pointer = xmlNextElementSibling(repeat_pointer);
+  }
+  return repeats;
+}
+
+auto read_song_document(XMLDocument& document, UserWarning& warning)
+    -> std::optional<SongFile> {
+  if (document.internal_pointer == nullptr) {
+    warning = {.title = QObject::tr("XML error"),
+               .message = QObject::tr("Invalid XML file")};
+    return std::nullopt;
+  }
+
+  thread_local XMLValidator song_validator("song.xsd");
+  if (validate_against_schema(song_validator, document) != 0) {
+    warning = {.title = QObject::tr("Validation Error"),
+               .message = QObject::tr("Invalid song file")};
+    return std::nullopt;
+  }
+
+  SongFile song_file;
+  auto& song = song_file.song;
+  auto* field_pointer = xmlFirstElementChild(&get_root(document));
+  while (field_pointer != nullptr) {
+    auto& field_node = get_reference(field_pointer);
+    const auto name = get_xml_name(field_node);
+    if (name == "gain") {
+      song_file.gain = xml_to_double(field_node);
+    } else if (name == "starting_key") {
+      song.starting_key = xml_to_double(field_node);
+    } else if (name == "starting_velocity") {
+      song.starting_velocity = xml_to_double(field_node);
+    } else if (name == "starting_tempo") {
+      song.starting_tempo = xml_to_double(field_node);
+    } else if (name == "chords") {
+      xml_to_rows(song.chords, field_node);
+    } else if (name == "pitched_voices") {
+      xml_to_rows(song.pitched_voices, field_node);
+    } else if (name == "unpitched_voices") {
+      xml_to_rows(song.unpitched_voices, field_node);
+    } else if (name == "repeats") {
+      song.repeats = xml_to_repeats(field_node);
+    } else {
+      Q_UNREACHABLE();
+    }
+    field_pointer = xmlNextElementSibling(field_pointer);
+  }
+  pool_song_words(song);
+
+  auto maybe_warning = get_voice_names_warning(song.pitched_voices);
+  if (!maybe_warning.has_value()) {
+    maybe_warning = get_voice_names_warning(song.unpitched_voices);
+  }
+  const auto number_of_pitched_voices =
+      static_cast<int>(song.pitched_voices.size());
+  const auto number_of_unpitched_voices =
+      static_cast<int>(song.unpitched_voices.size());
+  for (auto chord_number = 0;
+       !maybe_warning.has_value() && chord_number < song.chords.size();
+       chord_number = chord_number + 1) {
+    const auto& chord = song.chords.at(chord_number);
+    maybe_warning = get_note_voices_warning(
+        chord.pitched_notes, number_of_pitched_voices, chord_number);
+    if (!maybe_warning.has_value()) {
+      maybe_warning = get_note_voices_warning(
+          chord.unpitched_notes, number_of_unpitched_voices, chord_number);
+    }
+  }
+  if (!maybe_warning.has_value()) {
+    maybe_warning = get_repeats_warning(
+        song.repeats, static_cast<int>(song.chords.size()));
+  }
+  if (maybe_warning.has_value()) {
+    warning = std::move(*maybe_warning);
+    return std::nullopt;
+  }
+  return song_file;
+}
+
+}  // namespace
+
+auto read_song_file(const QString& filename, UserWarning& warning)
+    -> std::optional<SongFile> {
+  Q_ASSERT(filename.isValidUtf16());
+  auto document = read_xml_file(filename);
+  return read_song_document(document, warning);
+}
+
+auto read_song_bytes(const QByteArray& bytes, UserWarning& warning)
+    -> std::optional<SongFile> {
+  auto document = read_xml_document(bytes);
+  return read_song_document(document, warning);
+}
+
+auto is_musicxml_file(const QString& filename) -> bool {
+  return filename.endsWith(".musicxml", Qt::CaseInsensitive) ||
+         filename.endsWith(".mxl", Qt::CaseInsensitive);
+}
+
+auto read_any_song_file(const QString& filename, UserWarning& warning)
+    -> std::optional<SongFile> {
+  if (!is_musicxml_file(filename)) {
+    return read_song_file(filename, warning);
+  }
+  auto maybe_song = read_musicxml_file(filename, warning);
+  if (!maybe_song.has_value()) {
+    return std::nullopt;
+  }
+  return SongFile{.song = std::move(*maybe_song)};
+}
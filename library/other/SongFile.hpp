@@ -0,0 +1,33 @@
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <optional>
+
+#include "other/Song.hpp"
+#include "other/UserWarning.hpp"
+#include "rows/Chord.hpp"
+
+// everything save_as_file writes: the song, and the gain it was played at
+struct SongFile {
+  Song song;
+  double gain = DEFAULT_GAIN;
+};
+
+// reads and checks a song file without touching any widgets, so it's safe to
+// call from any thread; open_file then loads the result into the editor
+[[nodiscard]] auto read_song_file(const QString& filename,
+                                  UserWarning& warning)
+    -> std::optional<SongFile>;
+
+// the same, for a song file's contents, e.g. sent over a socket
+[[nodiscard]] auto read_song_bytes(const QByteArray& bytes,
+                                   UserWarning& warning)
+    -> std::optional<SongFile>;
+
+[[nodiscard]] auto is_musicxml_file(const QString& filename) -> bool;
+
+// a song file or a MusicXML file (see read_musicxml_file), by its extension
+[[nodiscard]] auto read_any_song_file(const QString& filename,
+                                      UserWarning& warning)
+    -> std::optional<SongFile>;
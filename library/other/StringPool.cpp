@@ -0,0 +1,16 @@
+#include "other/StringPool.hpp"
+
+auto get_pooled_string(StringPool& string_pool, const QString& text)
+    -> QString {
+  // empty strings never allocate anyway
+  if (text.isEmpty()) {
+    return {};
+  }
+  auto& strings = string_pool.strings;
+  const auto string_iterator = strings.constFind(text);
+  if (string_iterator != strings.cend()) {
+    return *string_iterator;
+  }
+  strings.insert(text);
+  return text;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QtCore/QSet>
+#include <QtCore/QString>
+
+// one copy of each distinct string. QString is implicitly shared, so every
+// string that comes out of the pool shares a single buffer with the others
+// that read the same, rather than, e.g., each of a big import's notes
+// holding its own copy of the same part name
+struct StringPool {
+  QSet<QString> strings;
+};
+
+// text, sharing the buffer of an equal string already in the pool, if any
+[[nodiscard]] auto get_pooled_string(StringPool& string_pool,
+                                     const QString& text) -> QString;
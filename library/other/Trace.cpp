@@ -0,0 +1,109 @@
+#include "other/Trace.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+namespace {
+
+// how often the trace file's buffer gets flushed as spans come in
+const auto FLUSH_INTERVAL = std::chrono::seconds(1);
+
+// each span goes straight into the trace file, in Chrome's JSON array
+// format, which doesn't need the closing ] -- so the file stays readable
+// however the app ends, and nothing builds up in memory
+struct Tracer {
+  const std::string filename =
+      qEnvironmentVariable(TRACE_FILE_VARIABLE).toStdString();
+  const std::chrono::steady_clock::time_point start_time =
+      std::chrono::steady_clock::now();
+  std::atomic<int> next_thread_number = 0;
+  std::mutex mutex;
+  // guarded by mutex
+  std::ofstream trace_file;
+  // guarded by mutex
+  bool has_events = false;
+  // guarded by mutex
+  std::chrono::steady_clock::time_point flush_time = start_time;
+
+  Tracer() {
+    if (!filename.empty()) {
+      trace_file.open(filename, std::ios::trunc);
+      trace_file << "[";
+      trace_file.flush();
+    }
+  }
+
+  ~Tracer() {
+    if (filename.empty()) {
+      return;
+    }
+    const std::lock_guard lock(mutex);
+    trace_file << "\n]\n";
+  }
+
+  NO_MOVE_COPY(Tracer)
+};
+
+auto get_tracer() -> Tracer& {
+  static Tracer tracer;
+  return tracer;
+}
+
+auto get_trace_microseconds(const Tracer& tracer) -> qint64 {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - tracer.start_time)
+      .count();
+}
+
+}  // namespace
+
+auto is_tracing() -> bool {
+  static const auto tracing = !get_tracer().filename.empty();
+  return tracing;
+}
+
+void flush_trace() {
+  if (!is_tracing()) {
+    return;
+  }
+  auto& tracer = get_tracer();
+  const std::lock_guard lock(tracer.mutex);
+  tracer.trace_file.flush();
+  tracer.flush_time = std::chrono::steady_clock::now();
+}
+
+TraceSpan::TraceSpan(const char* const name_input)
+    : name(name_input),
+      start_microseconds(is_tracing() ? get_trace_microseconds(get_tracer())
+                                      : -1) {}
+
+TraceSpan::~TraceSpan() {
+  if (start_microseconds < 0) {
+    return;
+  }
+  auto& tracer = get_tracer();
+  // numbered in the order they first trace anything
+  thread_local const auto thread_number =
+      tracer.next_thread_number.fetch_add(1) + 1;
+  const auto end_microseconds = get_trace_microseconds(tracer);
+  const std::lock_guard lock(tracer.mutex);
+  auto& trace_file = tracer.trace_file;
+  if (tracer.has_events) {
+    trace_file << ",";
+  }
+  tracer.has_events = true;
+  // names are literals in the source, so need no escaping
+  trace_file << "\n{\"name\":\"" << name
+             << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread_number
+             << ",\"ts\":" << start_microseconds
+             << ",\"dur\":" << end_microseconds - start_microseconds << "}";
+  // so a crash loses at most the last FLUSH_INTERVAL of spans
+  const auto now = std::chrono::steady_clock::now();
+  if (now - tracer.flush_time >= FLUSH_INTERVAL) {
+    trace_file.flush();
+    tracer.flush_time = now;
+  }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QtCore/QtGlobal>
+
+#include "other/helpers.hpp"
+
+// set to a file name to record how long the app's slow spots take, e.g.
+// opening a file, into that file as they happen, flushed every second or
+// so, so a crash loses at most the last second. It's Chrome trace event
+// JSON, in the array format, which chrome://tracing or
+// https://ui.perfetto.dev can show even without its closing ]
+static const auto TRACE_FILE_VARIABLE = "JUSTLY_TRACE_FILE";
+
+[[nodiscard]] auto is_tracing() -> bool;
+
+// writes out every span traced so far, right away
+void flush_trace();
+
+// records the time from its construction to its destruction as one span,
+// on whichever thread it's on, if tracing is on; if not, it costs a branch.
+// name has to outlive the app, so should be a literal
+struct TraceSpan {
+  const char* const name;
+  // -1 if tracing is off
+  const qint64 start_microseconds;
+
+  explicit TraceSpan(const char* name_input);
+
+  ~TraceSpan();
+
+  NO_MOVE_COPY(TraceSpan)
+};
@@ -0,0 +1,7 @@
+#include "other/UserWarning.hpp"
+
+#include <QtWidgets/QMessageBox>
+
+void show_warning(QWidget& parent, const UserWarning& warning) {
+  QMessageBox::warning(&parent, warning.title, warning.message);
+}
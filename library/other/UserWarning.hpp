@@ -0,0 +1,15 @@
+#pragma once
+
+#include <QtCore/QString>
+
+class QWidget;
+
+// a problem to tell the user about, from code that doesn't know how it'll be
+// told: the editor shows it in a message box (see show_warning), while
+// justly-cli prints it
+struct UserWarning {
+  QString title;
+  QString message;
+};
+
+void show_warning(QWidget& parent, const UserWarning& warning);
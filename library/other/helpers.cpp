@@ -2,6 +2,7 @@
 
 #include <QtCore/QItemSelectionModel>
 #include <QtGui/QGuiApplication>
+#include <QtWidgets/QApplication>
 #include <QtWidgets/QMessageBox>
 
 XMLString::~XMLString() { xmlFree(internal_pointer); }
@@ -122,9 +123,15 @@ auto get_share_file(const char* file_name) -> std::string {
     // soundfont) would otherwise silently hand the caller a nonexistent
     // path instead of failing here; there's no valid path to hand back,
     // so report it to the user and exit rather than throwing
-    QMessageBox::critical(
-        nullptr, QObject::tr("Missing resource file"),
-        QObject::tr("Missing bundled resource file: %1").arg(result_file));
+    const auto message =
+        QObject::tr("Missing bundled resource file: %1").arg(result_file);
+    // justly-cli has no QApplication to show a message box with
+    if (qobject_cast<QApplication*>(QCoreApplication::instance()) == nullptr) {
+      qCritical().noquote() << message;
+    } else {
+      QMessageBox::critical(nullptr, QObject::tr("Missing resource file"),
+                            message);
+    }
     std::exit(EXIT_FAILURE);  // NOLINT(concurrency-mt-unsafe)
   }
   return result_file.toStdString();
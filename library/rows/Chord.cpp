@@ -189,8 +189,14 @@ void Chord::to_xml(xmlNode& chord_node) const {
 }
 
 void modulate(PlayState& play_state, const Chord& chord) {
-  play_state.current_key =
-      play_state.current_key * interval_to_double(chord.interval);
+  const auto& interval = chord.interval;
+  // most chords stay in the same key
+  if (interval.log2_value != 0) {
+    auto& key_monzo = play_state.key_monzo;
+    add_monzo(key_monzo, interval_to_monzo(interval));
+    play_state.current_key =
+        play_state.starting_key * std::exp2(monzo_to_log2(key_monzo));
+  }
   play_state.current_velocity =
       play_state.current_velocity * rational_to_double(chord.velocity_ratio);
   play_state.current_tempo =
@@ -1,10 +1,12 @@
 #pragma once
 
+#include <optional>
+
 #include "cell_types/Rational.hpp"
+#include "other/UserWarning.hpp"
 #include "rows/Row.hpp"
 
 struct PitchedVoice;
-struct Player;
 struct Program;
 struct UnpitchedVoice;
 
@@ -16,14 +18,6 @@ struct Note : Row {
   Rational velocity_ratio;
   QString words;
 
-  // nullopt means the note is unplayable as-is (e.g. a pitched note whose
-  // frequency is out of MIDI range) and the caller should abort rather than
-  // play a bogus note
-  [[nodiscard]] virtual auto get_closest_midi(
-      QWidget& parent, Player& player,
-      const QList<UnpitchedVoice>& unpitched_voices, int channel_number,
-      int chord_number, int note_number) const -> std::optional<short> = 0;
-
   [[nodiscard]] virtual auto get_program(
       const QList<PitchedVoice>& pitched_voices,
       const QList<UnpitchedVoice>& unpitched_voices) const
@@ -47,3 +41,25 @@ static void add_note_location(QTextStream& stream, const int chord_number,
          << QObject::tr(SubNote::get_pitched()) << QObject::tr(" note ")
          << note_number + 1;
 }
+
+// what's wrong with the voice numbers of one chord's notes, if anything
+template <NoteInterface SubNote>
+[[nodiscard]] auto get_note_voices_warning(const QList<SubNote>& notes,
+                                           const int number_of_voices,
+                                           const int chord_number)
+    -> std::optional<UserWarning> {
+  for (auto note_number = 0; note_number < notes.size();
+       note_number = note_number + 1) {
+    const auto voice_number = notes.at(note_number).voice_number;
+    if (voice_number < 0 || voice_number >= number_of_voices) {
+      QString message;
+      QTextStream stream(&message);
+      stream << QObject::tr("Voice ") << voice_number;
+      add_note_location<SubNote>(stream, chord_number, note_number);
+      stream << QObject::tr(" has no corresponding voice");
+      return UserWarning{.title = QObject::tr("Voice number error"),
+                         .message = message};
+    }
+  }
+  return std::nullopt;
+}
@@ -95,53 +95,10 @@ auto PitchedNote::get_pitched() -> const char* { return "pitched"; }
 
 auto PitchedNote::is_pitched() -> bool { return true; }
 
-auto PitchedNote::get_closest_midi(
-    QWidget& parent, Player& player,
-    const QList<UnpitchedVoice>& /*unpitched_voices*/, const int channel_number,
-    const int chord_number, const int note_number) const
-    -> std::optional<short> {
-  const auto& play_state = player.play_state;
-  auto& event = player.event;
-  const auto frequency = play_state.current_key * interval_to_double(interval);
-  static const auto minimum_frequency =
-      midi_number_to_frequency(0 - QUARTER_STEP);
-  if (frequency < minimum_frequency) {
-    QString message;
-    QTextStream stream(&message);
-    stream << QObject::tr("Frequency ") << QString::number(frequency, 'g', 3);
-    add_note_location<PitchedNote>(stream, chord_number, note_number);
-    stream << QObject::tr(" less than minimum frequency ")
-           << QString::number(minimum_frequency, 'g', 3);
-    QMessageBox::warning(&parent, QObject::tr("Frequency error"), message);
-    return {};
-  }
-
-  if (frequency >= MAX_FREQUENCY) {
-    QString message;
-    QTextStream stream(&message);
-    stream << QObject::tr("Frequency ") << QString::number(frequency, 'g', 3);
-    add_note_location<PitchedNote>(stream, chord_number, note_number);
-    stream << QObject::tr(" greater than or equal to maximum frequency ")
-           << QString::number(MAX_FREQUENCY, 'g', 3);
-    QMessageBox::warning(&parent, QObject::tr("Frequency error"), message);
-    return {};
-  }
-
-  const auto midi_float = frequency_to_midi_number(frequency);
-  const auto closest_midi = static_cast<short>(round(midi_float));
-  fluid_event_pitch_bend(
-      event.internal_pointer, channel_number,
-      to_int((midi_float - closest_midi + ZERO_BEND_HALFSTEPS) *
-             BEND_PER_HALFSTEP));
-  send_event_at(player.sequencer, event, play_state.current_time);
-  return closest_midi;
-}
-
 auto PitchedNote::get_program(
     const QList<PitchedVoice>& pitched_voices,
     const QList<UnpitchedVoice>& /*unpitched_voices*/) const -> const Program& {
-  return get_voice_program(get_some_programs(true), pitched_voices,
-                           voice_number);
+  return get_voice_program(pitched_voices, voice_number);
 }
 
 auto PitchedNote::get_voice_velocity_ratio(
@@ -2,7 +2,9 @@
 
 #include "column_numbers/PitchedVoiceColumn.hpp"
 
-PitchedVoice::PitchedVoice() : Voice() { program = "Grand Piano"; }
+PitchedVoice::PitchedVoice() : Voice() {
+  set_voice_program(*this, "Grand Piano");
+}
 
 auto PitchedVoice::get_pitched() -> const char* { return "pitched"; }
 
@@ -18,7 +20,7 @@ void PitchedVoice::from_xml(xmlNode& node) {
     if (field_name == "name") {
       name = get_qstring_content(field_node);
     } else if (field_name == "instrument") {
-      program = get_qstring_content(field_node);
+      set_voice_program(*this, get_qstring_content(field_node));
     } else if (field_name == "velocity_ratio") {
       set_rational_from_xml(velocity_ratio, field_node);
     } else {
@@ -85,7 +87,7 @@ void PitchedVoice::set_data(const int column_number,
       name = variant_to<QString>(new_value);
       break;
     case PitchedVoiceColumn::pitched_voice_instrument_column:
-      program = variant_to<QString>(new_value);
+      set_voice_program(*this, variant_to<QString>(new_value));
       break;
     case PitchedVoiceColumn::pitched_voice_velocity_ratio_column:
       velocity_ratio = variant_to<Rational>(new_value);
@@ -103,6 +105,7 @@ void PitchedVoice::copy_column_from(const PitchedVoice& template_row,
       break;
     case PitchedVoiceColumn::pitched_voice_instrument_column:
       program = template_row.program;
+      program_pointer = template_row.program_pointer;
       break;
     case PitchedVoiceColumn::pitched_voice_velocity_ratio_column:
       velocity_ratio = template_row.velocity_ratio;
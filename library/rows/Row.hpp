@@ -31,6 +31,9 @@ concept RowInterface =
 
 template <RowInterface SubRow>
 static void xml_to_rows(QList<SubRow>& new_rows, xmlNode& node) {
+  // so a big song's rows land in one allocation, rather than regrowing
+  new_rows.reserve(new_rows.size() +
+                   static_cast<qsizetype>(xmlChildElementCount(&node)));
   auto* xml_row_pointer = xmlFirstElementChild(&node);
   while (xml_row_pointer != nullptr) {
     SubRow child_row;
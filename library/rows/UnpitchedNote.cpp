@@ -64,18 +64,10 @@ auto UnpitchedNote::is_column_editable(int /*column_number*/) -> bool {
 
 auto UnpitchedNote::is_pitched() -> bool { return false; }
 
-auto UnpitchedNote::get_closest_midi(
-    QWidget& /*parent*/, Player& /*player*/,
-    const QList<UnpitchedVoice>& unpitched_voices, const int /*channel_number*/,
-    int /*chord_number*/, int /*note_number*/) const -> std::optional<short> {
-  return unpitched_voices.at(voice_number).midi_number;
-}
-
 auto UnpitchedNote::get_program(
     const QList<PitchedVoice>& /*pitched_voices*/,
     const QList<UnpitchedVoice>& unpitched_voices) const -> const Program& {
-  return get_voice_program(get_some_programs(false), unpitched_voices,
-                           voice_number);
+  return get_voice_program(unpitched_voices, voice_number);
 }
 
 auto UnpitchedNote::get_voice_velocity_ratio(
@@ -21,12 +21,6 @@ struct UnpitchedNote : Note {
 
   [[nodiscard]] static auto is_pitched() -> bool;
 
-  [[nodiscard]] auto get_closest_midi(
-      QWidget& /*parent*/, Player& /*player*/,
-      const QList<UnpitchedVoice>& unpitched_voices, int /*channel_number*/,
-      int /*chord_number*/, int /*note_number*/) const
-      -> std::optional<short> override;
-
   [[nodiscard]] auto get_program(const QList<PitchedVoice>& /*pitched_voices*/,
                                  const QList<UnpitchedVoice>& unpitched_voices)
       const -> const Program& override;
@@ -2,7 +2,9 @@
 
 #include "column_numbers/UnpitchedVoiceColumn.hpp"
 
-UnpitchedVoice::UnpitchedVoice() : Voice() { program = "Standard"; }
+UnpitchedVoice::UnpitchedVoice() : Voice() {
+  set_voice_program(*this, "Standard");
+}
 
 auto UnpitchedVoice::get_pitched() -> const char* { return "unpitched"; }
 
@@ -20,7 +22,7 @@ void UnpitchedVoice::from_xml(xmlNode& node) {
     if (field_name == "name") {
       name = get_qstring_content(field_node);
     } else if (field_name == "percussion_set_pointer") {
-      program = get_qstring_content(field_node);
+      set_voice_program(*this, get_qstring_content(field_node));
     } else if (field_name == "midi_number") {
       midi_number = static_cast<short>(xml_to_int(field_node));
     } else if (field_name == "velocity_ratio") {
@@ -94,7 +96,7 @@ void UnpitchedVoice::set_data(const int column_number,
       name = variant_to<QString>(new_value);
       break;
     case UnpitchedVoiceColumn::unpitched_voice_percussion_set_column:
-      program = variant_to<QString>(new_value);
+      set_voice_program(*this, variant_to<QString>(new_value));
       break;
     case UnpitchedVoiceColumn::unpitched_voice_midi_number_column:
       midi_number = variant_to<short>(new_value);
@@ -115,6 +117,7 @@ void UnpitchedVoice::copy_column_from(const UnpitchedVoice& template_row,
       break;
     case UnpitchedVoiceColumn::unpitched_voice_percussion_set_column:
       program = template_row.program;
+      program_pointer = template_row.program_pointer;
       break;
     case UnpitchedVoiceColumn::unpitched_voice_midi_number_column:
       midi_number = template_row.midi_number;
@@ -1,16 +1,22 @@
 #pragma once
 
+#include <QtCore/QSet>
 #include <QtWidgets/QMessageBox>
+#include <optional>
 
 #include "cell_types/Program.hpp"
 #include "cell_types/Rational.hpp"
+#include "other/UserWarning.hpp"
 #include "rows/Row.hpp"
 
 class QWidget;
 
 struct Voice : Row {
   QString name;
+  // change with set_voice_program, which keeps program_pointer pointing at
+  // the Program it names, so playing a note never looks one up by name
   QString program;
+  const Program* program_pointer = nullptr;
   Rational velocity_ratio;
 };
 
@@ -21,13 +27,18 @@ concept VoiceInterface = std::derived_from<SubVoice, Voice> && requires() {
 };
 
 template <VoiceInterface SubVoice>
-[[nodiscard]] auto get_voice_program(const QList<Program>& programs,
-                                     const QList<SubVoice>& voices,
-                                     int voice_number) -> const auto& {
-  const auto result_index =
-      get_named_index(programs, voices.at(voice_number).program);
+void set_voice_program(SubVoice& voice, const QString& new_program) {
+  const auto& programs = get_some_programs(SubVoice::is_pitched());
+  const auto result_index = get_named_index(programs, new_program);
   Q_ASSERT(result_index != programs.cend());
-  return *result_index;
+  voice.program = new_program;
+  voice.program_pointer = &*result_index;
+}
+
+template <VoiceInterface SubVoice>
+[[nodiscard]] auto get_voice_program(const QList<SubVoice>& voices,
+                                     int voice_number) -> const Program& {
+  return get_reference(voices.at(voice_number).program_pointer);
 }
 
 template <VoiceInterface SubVoice>
@@ -56,3 +67,28 @@ template <VoiceInterface SubVoice>
   }
   return true;
 }
+
+// what's wrong with a whole list of voices' names, if anything
+template <VoiceInterface SubVoice>
+[[nodiscard]] auto get_voice_names_warning(const QList<SubVoice>& voices)
+    -> std::optional<UserWarning> {
+  if (std::ranges::any_of(voices, [](const SubVoice& voice) -> auto {
+        return voice.name.isEmpty();
+      })) {
+    return UserWarning{.title = QObject::tr("Voice name error"),
+                       .message = QObject::tr("Voice name is empty!")};
+  }
+  QSet<QString> seen_names;
+  for (const auto& voice : voices) {
+    if (seen_names.contains(voice.name)) {
+      QString message;
+      QTextStream stream(&message);
+      stream << QObject::tr("Duplicate voice name \"") << voice.name
+             << QObject::tr("\"!");
+      return UserWarning{.title = QObject::tr("Voice name error"),
+                         .message = message};
+    }
+    seen_names.insert(voice.name);
+  }
+  return std::nullopt;
+}
@@ -0,0 +1,108 @@
+#include "sound/Auditioner.hpp"
+
+#include <fluidsynth.h>
+
+#include "sound/FluidSynth.hpp"
+
+namespace {
+
+const auto BREATH_ID = 2;
+
+void start_note(const Auditioner& auditioner,
+                const AuditionNote& audition_note) {
+  auto* const synth_pointer = auditioner.synth_pointer;
+  const auto channel_number = audition_note.channel_number;
+  fluid_synth_program_select(synth_pointer, channel_number,
+                             auditioner.soundfont_id,
+                             audition_note.bank_number,
+                             audition_note.preset_number);
+  fluid_synth_pitch_bend(synth_pointer, channel_number, audition_note.bend);
+  fluid_synth_cc(synth_pointer, channel_number, BREATH_ID,
+                 audition_note.velocity);
+  fluid_synth_noteon(synth_pointer, channel_number, audition_note.key,
+                     audition_note.velocity);
+}
+
+void run_auditions(Auditioner& auditioner) {
+  auto& note_offs = auditioner.note_offs;
+  auto& pending_notes = auditioner.pending_notes;
+  std::unique_lock lock(auditioner.mutex);
+  while (true) {
+    // wakes up for a new note, for the soonest note-off, or to stop
+    const auto has_work = [&auditioner]() -> auto {
+      return auditioner.stopping || !auditioner.pending_notes.empty();
+    };
+    if (note_offs.empty()) {
+      auditioner.condition.wait(lock, has_work);
+    } else {
+      auditioner.condition.wait_until(lock, note_offs.top().time, has_work);
+    }
+    if (auditioner.stopping) {
+      return;
+    }
+
+    while (!pending_notes.empty()) {
+      const auto audition_note = pending_notes.front();
+      pending_notes.pop();
+      start_note(auditioner, audition_note);
+      const auto started_time = std::chrono::steady_clock::now();
+      auditioner.dispatch_milliseconds.store(
+          std::chrono::duration<double, std::milli>(
+              started_time - audition_note.requested_time)
+              .count());
+      if (auditioner.on_dispatch) {
+        auditioner.on_dispatch();
+      }
+      note_offs.push(
+          AuditionNoteOff{.time = started_time + audition_note.duration,
+                          .channel_number = audition_note.channel_number,
+                          .key = audition_note.key});
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    while (!note_offs.empty() && note_offs.top().time <= now) {
+      const auto& note_off = note_offs.top();
+      fluid_synth_noteoff(auditioner.synth_pointer, note_off.channel_number,
+                          note_off.key);
+      note_offs.pop();
+    }
+  }
+}
+
+}  // namespace
+
+Auditioner::Auditioner(FluidSynth& synth, const int soundfont_id_input)
+    : synth_pointer(synth.internal_pointer), soundfont_id(soundfont_id_input),
+      thread(std::thread(run_auditions, std::ref(*this))) {}
+
+Auditioner::~Auditioner() {
+  {
+    const std::lock_guard lock(mutex);
+    stopping = true;
+  }
+  condition.notify_one();
+  thread.join();
+}
+
+void queue_audition(Auditioner& auditioner,
+                    const AuditionNote& audition_note) {
+  {
+    const std::lock_guard lock(auditioner.mutex);
+    auditioner.pending_notes.push(audition_note);
+  }
+  auditioner.condition.notify_one();
+}
+
+void set_dispatch_callback(Auditioner& auditioner,
+                           std::function<void()> on_dispatch) {
+  const std::lock_guard lock(auditioner.mutex);
+  auditioner.on_dispatch = std::move(on_dispatch);
+}
+
+void cancel_auditions(Auditioner& auditioner) {
+  const std::lock_guard lock(auditioner.mutex);
+  auditioner.pending_notes = {};
+  // a stale note-off could otherwise cut short the next preview to land on
+  // the same channel and key
+  auditioner.note_offs = {};
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <fluidsynth/types.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+#include "other/helpers.hpp"
+
+struct FluidSynth;
+
+// everything a preview note needs, already worked out on the GUI thread, so
+// the audition thread only ever has to talk to the synth
+struct AuditionNote {
+  int channel_number = 0;  // a channel of the primary synth
+  int bank_number = 0;
+  int preset_number = 0;
+  int bend = 0;
+  short key = 0;
+  short velocity = 0;
+  std::chrono::milliseconds duration{};
+  std::chrono::steady_clock::time_point requested_time;
+};
+
+struct AuditionNoteOff {
+  std::chrono::steady_clock::time_point time;
+  int channel_number = 0;
+  short key = 0;
+
+  [[nodiscard]] auto operator>(const AuditionNoteOff& other) const -> bool {
+    return time > other.time;
+  }
+};
+
+// plays previews (a voice, or a single note) by calling straight into the
+// primary synth from a thread of its own, instead of scheduling them on the
+// sequencer -- a sequencer event waits for the sequencer's next dispatch,
+// which only happens once per audio period, on top of the driver's own
+// buffering. Here, the driver's buffer (see get_output_latency) is all that's
+// left between a click and the sound
+struct Auditioner {
+  fluid_synth_t* const synth_pointer;
+  const int soundfont_id;
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  // guarded by mutex
+  std::queue<AuditionNote> pending_notes;
+  // guarded by mutex, soonest first
+  std::priority_queue<AuditionNoteOff, std::vector<AuditionNoteOff>,
+                      std::greater<>>
+      note_offs;
+  // guarded by mutex
+  bool stopping = false;
+
+  // how long the most recent note took to go from queue_audition to the
+  // synth
+  std::atomic<double> dispatch_milliseconds = 0;
+  // guarded by mutex; see set_dispatch_callback
+  std::function<void()> on_dispatch;
+
+  // declared last, so everything the thread touches exists before it starts
+  std::thread thread;
+
+  Auditioner(FluidSynth& synth, int soundfont_id_input);
+
+  NO_MOVE_COPY(Auditioner)
+
+  ~Auditioner();
+};
+
+void queue_audition(Auditioner& auditioner, const AuditionNote& audition_note);
+
+// on_dispatch gets called each time a note reaches the synth, once
+// dispatch_milliseconds has been stored. It's called on the audition thread,
+// so it should only post back to the GUI thread
+void set_dispatch_callback(Auditioner& auditioner,
+                           std::function<void()> on_dispatch);
+
+// drops every preview that hasn't started yet, along with the note-offs of
+// ones already sounding, which are left to stop_playing's all-sounds-off
+void cancel_auditions(Auditioner& auditioner);
@@ -0,0 +1,372 @@
+#include "sound/OfflineSynth.hpp"
+
+#include <QtCore/QObject>
+#include <fluidsynth.h>
+
+#include <algorithm>
+#include <map>
+#include <queue>
+
+#include "cell_types/Program.hpp"
+#include "other/Song.hpp"
+#include "other/helpers.hpp"
+#include "rows/PitchedNote.hpp"
+#include "sound/PlaybackPlan.hpp"
+#include "sound/Player.hpp"
+
+namespace {
+
+const auto BREATH_ID = 2;
+// fluidsynth's own ceiling on synth.midi-channels
+const auto NUMBER_OF_OFFLINE_CHANNELS = 256;
+
+struct OfflineEvent {
+  double time = 0;
+  int note_index = 0;
+  bool is_note_on = true;
+};
+
+// synth.sample-rate has to be set before the synth is made from the
+// settings
+auto with_sample_rate(FluidSettings& settings, const double sample_rate)
+    -> FluidSettings& {
+  check_fluid_ok(fluid_settings_setnum(settings.internal_pointer,
+                                       "synth.sample-rate", sample_rate));
+  return settings;
+}
+
+void start_note(const OfflineSynth& offline_synth, const OfflineNote& note,
+                const int channel_number) {
+  auto* const synth_pointer = offline_synth.synth.internal_pointer;
+  fluid_synth_program_select(synth_pointer, channel_number,
+                             offline_synth.soundfont_id, note.bank_number,
+                             note.preset_number);
+  if (note.is_pitched) {
+    fluid_synth_pitch_bend(synth_pointer, channel_number, note.bend);
+  }
+  fluid_synth_cc(synth_pointer, channel_number, BREATH_ID, note.velocity);
+  fluid_synth_noteon(synth_pointer, channel_number, note.key, note.velocity);
+}
+
+// everything a render needs to know about a song, with the offline synth
+// reset for it
+struct SongRender {
+  std::vector<OfflineNote> notes;
+  std::vector<int> note_channels;
+  size_t number_of_frames = 0;
+};
+
+auto get_song_render(OfflineSynth& offline_synth, const Song& song,
+                     const double gain, UserWarning& warning)
+    -> std::optional<SongRender> {
+  const auto playback_plan = compile_playback_plan(song);
+  for (const auto& planned_note : playback_plan.notes) {
+    auto maybe_warning = get_planned_note_warning(planned_note);
+    if (maybe_warning.has_value()) {
+      warning = std::move(*maybe_warning);
+      return std::nullopt;
+    }
+  }
+  // every note plays at least once, so they've all been checked, but a
+  // repeated note gets an offline note for each pass
+  std::vector<OfflineNote> notes;
+  for (const auto& pass : playback_plan.passes) {
+    const auto pass_notes = get_offline_notes(
+        get_planned_chords(playback_plan, pass.first_chord_number,
+                           pass.number_of_chords),
+        -RENDER_MARGIN_MILLISECONDS - pass.time_offset);
+    notes.insert(notes.end(), pass_notes.begin(), pass_notes.end());
+  }
+  auto maybe_note_channels = get_offline_channels(notes);
+  if (!maybe_note_channels.has_value()) {
+    warning = {.title = QObject::tr("MIDI channel exhausted"),
+               .message = QObject::tr("More notes are sounding at once than "
+                                      "there are available MIDI channels")};
+    return std::nullopt;
+  }
+
+  auto* const synth_pointer = offline_synth.synth.internal_pointer;
+  check_fluid_ok(fluid_synth_system_reset(synth_pointer));
+  fluid_synth_set_gain(synth_pointer, static_cast<float>(gain));
+  return SongRender{
+      .notes = std::move(notes),
+      .note_channels = std::move(*maybe_note_channels),
+      .number_of_frames =
+          to_frame(get_render_milliseconds(playback_plan.played_end_time),
+                   offline_synth.sample_rate)};
+}
+
+auto get_render_cancelled_warning() -> UserWarning {
+  return {.title = QObject::tr("Export cancelled"),
+          .message = QObject::tr("The render was cancelled")};
+}
+
+}  // namespace
+
+auto get_audio_file_types() -> const QStringList& {
+  static const QStringList file_types({"wav", "flac", "oga"});
+  return file_types;
+}
+
+auto get_audio_sample_formats() -> const QStringList& {
+  static const QStringList sample_formats({"s16", "s24", "s32", "float"});
+  return sample_formats;
+}
+
+auto get_audio_file_type(const QString& filename) -> QString {
+  if (filename.endsWith(".flac", Qt::CaseInsensitive)) {
+    return "flac";
+  }
+  if (filename.endsWith(".ogg", Qt::CaseInsensitive) ||
+      filename.endsWith(".oga", Qt::CaseInsensitive)) {
+    return "oga";
+  }
+  return "wav";
+}
+
+auto get_audio_file_format_warning(const AudioFileFormat& file_format)
+    -> std::optional<UserWarning> {
+  const auto& file_type = file_format.file_type;
+  const auto& sample_format = file_format.sample_format;
+  if (!get_audio_file_types().contains(file_type)) {
+    return UserWarning{.title = QObject::tr("Export error"),
+                       .message = QObject::tr("Unknown file type ") +
+                                  file_type};
+  }
+  if (!get_audio_sample_formats().contains(sample_format)) {
+    return UserWarning{.title = QObject::tr("Export error"),
+                       .message = QObject::tr("Unknown sample format ") +
+                                  sample_format};
+  }
+  // libsndfile's FLAC encoder only takes up to 24 bit integers
+  if (file_type == "flac" &&
+      (sample_format == "s32" || sample_format == "float")) {
+    return UserWarning{
+        .title = QObject::tr("Export error"),
+        .message = QObject::tr("FLAC files can't hold ") + sample_format +
+                   QObject::tr(" samples")};
+  }
+  return std::nullopt;
+}
+
+OfflineSynth::OfflineSynth(const double sample_rate_input)
+    : sample_rate(sample_rate_input),
+      settings(NUMBER_OF_OFFLINE_CHANNELS),
+      synth(with_sample_rate(settings, sample_rate_input)),
+      soundfont_id(get_soundfont_id(synth)) {}
+
+auto get_render_milliseconds(const double played_end_time) -> double {
+  return played_end_time + 2 * RENDER_MARGIN_MILLISECONDS;
+}
+
+auto to_frame(const double milliseconds, const double sample_rate)
+    -> size_t {
+  static const auto MILLISECONDS_PER_SECOND = 1000.0;
+  return static_cast<size_t>(
+      std::max(0.0, milliseconds * sample_rate / MILLISECONDS_PER_SECOND));
+}
+
+auto get_offline_notes(const std::span<const PlannedNote> planned_notes,
+                       const double start_time) -> std::vector<OfflineNote> {
+  std::vector<OfflineNote> notes;
+  notes.reserve(planned_notes.size());
+  for (const auto& planned_note : planned_notes) {
+    const auto& program = get_reference(planned_note.program_pointer);
+    const auto midi_number = planned_note.midi_number;
+    const auto key = to_int(midi_number);
+    notes.push_back(OfflineNote{
+        .start_time = planned_note.start_time - start_time,
+        .end_time = planned_note.end_time - start_time,
+        .bank_number = program.bank_number,
+        .preset_number = program.preset_number,
+        .release_milliseconds = program.release_milliseconds,
+        .bend = to_int((midi_number - key + ZERO_BEND_HALFSTEPS) *
+                       BEND_PER_HALFSTEP),
+        .key = static_cast<short>(key),
+        .velocity = static_cast<short>(planned_note.velocity),
+        .is_pitched = is_pitched_bank_number(program.bank_number)});
+  }
+  return notes;
+}
+
+// a channel of its own for each pitched note, so each can be bent
+// separately, and one per percussion program, like live playback in
+// pitch-bend mode -- or nothing, if there are too many notes at once for the
+// offline synth, which live playback (with its pooled synths) can still
+// manage
+auto get_offline_channels(const std::vector<OfflineNote>& notes)
+    -> std::optional<std::vector<int>> {
+  std::priority_queue<std::pair<double, int>,
+                      std::vector<std::pair<double, int>>, std::greater<>>
+      channel_releases;
+  for (auto channel_number = 0; channel_number < NUMBER_OF_OFFLINE_CHANNELS;
+       channel_number = channel_number + 1) {
+    channel_releases.emplace(0, channel_number);
+  }
+  std::map<std::pair<int, int>, int> percussion_channels;
+
+  std::vector<int> note_channels;
+  note_channels.reserve(notes.size());
+  for (const auto& note : notes) {
+    if (!note.is_pitched) {
+      const auto program_key =
+          std::make_pair(note.bank_number, note.preset_number);
+      const auto existing = percussion_channels.find(program_key);
+      if (existing != percussion_channels.end()) {
+        note_channels.push_back(existing->second);
+        continue;
+      }
+    }
+    if (channel_releases.empty() ||
+        channel_releases.top().first > note.start_time) {
+      return std::nullopt;
+    }
+    const auto channel_number = channel_releases.top().second;
+    channel_releases.pop();
+    if (note.is_pitched) {
+      channel_releases.emplace(note.end_time + note.release_milliseconds,
+                               channel_number);
+    } else {
+      percussion_channels[std::make_pair(note.bank_number,
+                                         note.preset_number)] = channel_number;
+    }
+    note_channels.push_back(channel_number);
+  }
+  return note_channels;
+}
+
+auto play_offline_notes(OfflineSynth& offline_synth,
+                        const std::vector<OfflineNote>& notes,
+                        const std::vector<int>& note_channels,
+                        const size_t number_of_frames,
+                        const std::function<bool(size_t)>& render_until)
+    -> bool {
+  Q_ASSERT(notes.size() == note_channels.size());
+  const auto sample_rate = offline_synth.sample_rate;
+
+  std::vector<OfflineEvent> events;
+  events.reserve(notes.size() * 2);
+  for (auto note_index = 0; note_index < static_cast<int>(notes.size());
+       note_index = note_index + 1) {
+    const auto& note = notes.at(note_index);
+    events.push_back({.time = note.start_time,
+                      .note_index = note_index,
+                      .is_note_on = true});
+    events.push_back({.time = note.end_time,
+                      .note_index = note_index,
+                      .is_note_on = false});
+  }
+  // note-offs first, so a percussion note ending right as the next one on
+  // its channel starts doesn't cut that one off
+  std::ranges::stable_sort(
+      events, [](const OfflineEvent& first_event,
+                 const OfflineEvent& second_event) -> auto {
+        return std::make_pair(first_event.time, first_event.is_note_on) <
+               std::make_pair(second_event.time, second_event.is_note_on);
+      });
+
+  for (const auto& event : events) {
+    if (!render_until(
+            std::min(to_frame(event.time, sample_rate), number_of_frames))) {
+      return false;
+    }
+    const auto& note = notes.at(event.note_index);
+    const auto channel_number = note_channels.at(event.note_index);
+    if (event.is_note_on) {
+      start_note(offline_synth, note, channel_number);
+    } else {
+      fluid_synth_noteoff(offline_synth.synth.internal_pointer, channel_number,
+                          note.key);
+    }
+  }
+  return render_until(number_of_frames);
+}
+
+auto render_song_to_file(OfflineSynth& offline_synth, const Song& song,
+                         const double gain, const QString& output_file,
+                         const AudioFileFormat& file_format,
+                         UserWarning& warning, bool& created_file,
+                         const std::function<bool(double)>& keep_rendering)
+    -> bool {
+  static const auto NUMBER_OF_PROGRESS_REPORTS = 100;
+  Q_ASSERT(output_file.isValidUtf16());
+  created_file = false;
+
+  auto maybe_format_warning = get_audio_file_format_warning(file_format);
+  if (maybe_format_warning.has_value()) {
+    warning = std::move(*maybe_format_warning);
+    return false;
+  }
+
+  auto& settings = offline_synth.settings;
+  auto* const synth_pointer = offline_synth.synth.internal_pointer;
+  const auto maybe_song_render =
+      get_song_render(offline_synth, song, gain, warning);
+  if (!maybe_song_render.has_value()) {
+    return false;
+  }
+  const auto& song_render = *maybe_song_render;
+  const auto number_of_frames = song_render.number_of_frames;
+  // a render cancelled before it starts doesn't even create the file
+  if (keep_rendering && !keep_rendering(0)) {
+    warning = get_render_cancelled_warning();
+    return false;
+  }
+  set_fluid_string(settings, "audio.file.name",
+                   output_file.toStdString().c_str());
+  set_fluid_string(settings, "audio.file.type",
+                   file_format.file_type.toStdString().c_str());
+  set_fluid_string(settings, "audio.file.format",
+                   file_format.sample_format.toStdString().c_str());
+
+  auto* const renderer_pointer = new_fluid_file_renderer(synth_pointer);
+  if (renderer_pointer == nullptr) {
+    warning = {.title = QObject::tr("Export error"),
+               .message = QObject::tr("Cannot write to file")};
+    return false;
+  }
+  created_file = true;
+  // the file renderer renders a period at a time, so notes land on period
+  // boundaries, like they do with the sequencer in live playback
+  auto period_size = 0;
+  check_fluid_ok(fluid_settings_getint(settings.internal_pointer,
+                                       "audio.period-size", &period_size));
+  const auto frames_per_report =
+      std::max(size_t{1}, number_of_frames / NUMBER_OF_PROGRESS_REPORTS);
+  auto rendered_frames = size_t{0};
+  auto next_report_frame = frames_per_report;
+  auto cancelled = false;
+  const auto written = play_offline_notes(
+      offline_synth, song_render.notes, song_render.note_channels,
+      number_of_frames,
+      [&](const size_t frame) -> bool {
+        while (rendered_frames < frame) {
+          if (fluid_file_renderer_process_block(renderer_pointer) !=
+              FLUID_OK) {
+            return false;
+          }
+          rendered_frames = rendered_frames + period_size;
+          if (keep_rendering && rendered_frames >= next_report_frame) {
+            next_report_frame = rendered_frames + frames_per_report;
+            if (!keep_rendering(
+                    std::min(1.0, static_cast<double>(rendered_frames) /
+                                      static_cast<double>(number_of_frames)))) {
+              cancelled = true;
+              return false;
+            }
+          }
+        }
+        return true;
+      });
+  delete_fluid_file_renderer(renderer_pointer);
+  if (cancelled) {
+    warning = get_render_cancelled_warning();
+    return false;
+  }
+  if (!written) {
+    warning = {.title = QObject::tr("Export error"),
+               .message = QObject::tr("Error writing file")};
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <functional>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "other/UserWarning.hpp"
+#include "sound/FluidSettings.hpp"
+#include "sound/FluidSynth.hpp"
+
+struct PlannedNote;
+struct Song;
+
+// everything an offline synth needs to play a note, already worked out, so
+// rendering never touches the song
+struct OfflineNote {
+  double start_time = 0;  // milliseconds from the start of the render
+  double end_time = 0;
+  int bank_number = 0;
+  int preset_number = 0;
+  double release_milliseconds = 0;
+  int bend = 0;
+  short key = 0;
+  short velocity = 0;
+  bool is_pitched = true;
+};
+
+// fluidsynth's default synth.sample-rate, which the player uses too
+static const auto DEFAULT_SAMPLE_RATE = 44100.0;
+// fluidsynth's own limits on synth.sample-rate
+static const auto MIN_SAMPLE_RATE = 8000.0;
+static const auto MAX_SAMPLE_RATE = 96000.0;
+
+// what render_song_to_file writes. The file renderer hands each block to
+// libsndfile as soon as it's rendered, so compressed files get encoded
+// along the way, rather than all at the end
+struct AudioFileFormat {
+  // one of get_audio_file_types
+  QString file_type = "wav";
+  // one of get_audio_sample_formats; Ogg files are always Vorbis, whatever
+  // this says
+  QString sample_format = "s16";
+};
+
+// fluidsynth's audio.file.type names for WAV, FLAC and Ogg Vorbis
+[[nodiscard]] auto get_audio_file_types() -> const QStringList&;
+
+// fluidsynth's audio.file.format names for 16, 24 and 32 bit integer and
+// 32 bit float samples
+[[nodiscard]] auto get_audio_sample_formats() -> const QStringList&;
+
+// by filename's extension: flac for .flac, oga for .ogg or .oga, and wav
+// for anything else
+[[nodiscard]] auto get_audio_file_type(const QString& filename) -> QString;
+
+// why file_format can't be written, if it can't
+[[nodiscard]] auto get_audio_file_format_warning(
+    const AudioFileFormat& file_format) -> std::optional<UserWarning>;
+
+// a synth for rendering faster than real time, apart from the Player, so it
+// can run on a thread of its own. It loads its own copy of the soundfont
+// (fluidsynth can't share one between synths), so it's worth keeping one
+// around for as many renders as possible
+struct OfflineSynth {
+  const double sample_rate;
+  FluidSettings settings;
+  FluidSynth synth;
+  const int soundfont_id;
+
+  explicit OfflineSynth(double sample_rate_input);
+
+  NO_MOVE_COPY(OfflineSynth)
+};
+
+[[nodiscard]] auto to_frame(double milliseconds, double sample_rate)
+    -> size_t;
+
+// a lead-in and tail around every render, so the song's edges don't get cut
+// off
+static const auto RENDER_MARGIN_MILLISECONDS = 500.0;
+
+// how long a render of a song whose last pass finishes at played_end_time
+// lasts, margins included
+[[nodiscard]] auto get_render_milliseconds(double played_end_time) -> double;
+
+// timed from start_time in the plan; none of the notes get checked, so
+// callers should check them with get_planned_note_warning first
+[[nodiscard]] auto get_offline_notes(
+    std::span<const PlannedNote> planned_notes, double start_time)
+    -> std::vector<OfflineNote>;
+
+// a channel for each note, or nothing if too many sound at once
+[[nodiscard]] auto get_offline_channels(const std::vector<OfflineNote>& notes)
+    -> std::optional<std::vector<int>>;
+
+// plays notes (sorted by start time) on the offline synth, on the channels
+// get_offline_channels picked. Before each note starts or stops, and once
+// more at the end, render_until gets the frame the synth has to have
+// rendered up to by then; the notes stop early, returning false, as soon as
+// render_until returns false
+[[nodiscard]] auto play_offline_notes(
+    OfflineSynth& offline_synth, const std::vector<OfflineNote>& notes,
+    const std::vector<int>& note_channels, size_t number_of_frames,
+    const std::function<bool(size_t)>& render_until) -> bool;
+
+// renders a whole song into output_file, at the offline synth's sample
+// rate, so it's safe to call from any thread. Before anything's rendered,
+// then every percent or so, keep_rendering (if given) gets the fraction
+// rendered so far; the render stops, with a warning, as soon as it returns
+// false. created_file says whether output_file got opened for writing, so
+// callers know whether a failed render left part of a file behind
+[[nodiscard]] auto render_song_to_file(
+    OfflineSynth& offline_synth, const Song& song, double gain,
+    const QString& output_file, const AudioFileFormat& file_format,
+    UserWarning& warning, bool& created_file,
+    const std::function<bool(double)>& keep_rendering = {}) -> bool;
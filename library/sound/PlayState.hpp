@@ -1,8 +1,14 @@
 #pragma once
 
+#include "cell_types/Monzo.hpp"
+
 struct PlayState {
   double current_time = 0;
 
+  // current_key is always starting_key times key_monzo, which is kept
+  // exactly, so rounding can't pile up chord after chord
+  double starting_key = 0;
+  Monzo key_monzo;
   double current_key = 0;
   double current_velocity = 0;
   double current_tempo = 0;
@@ -0,0 +1,217 @@
+#include "sound/PlaybackPlan.hpp"
+
+#include <QtCore/QTextStream>
+
+#include "other/Song.hpp"
+#include "rows/Chord.hpp"
+
+namespace {
+
+template <NoteInterface SubNote>
+void append_planned_notes(QList<PlannedNote>& planned_notes,
+                          const PlayState& play_state,
+                          const QList<PitchedVoice>& pitched_voices,
+                          const QList<UnpitchedVoice>& unpitched_voices,
+                          const int chord_number,
+                          const QList<SubNote>& sub_notes) {
+  for (auto note_number = 0; note_number < sub_notes.size();
+       note_number = note_number + 1) {
+    const auto& sub_note = sub_notes.at(note_number);
+    const auto& voice_velocity_ratio =
+        sub_note.get_voice_velocity_ratio(pitched_voices, unpitched_voices);
+
+    PlannedNote planned_note;
+    planned_note.start_time = play_state.current_time;
+    planned_note.end_time =
+        play_state.current_time +
+        get_duration_in_milliseconds(play_state.current_tempo,
+                                     rational_to_double(sub_note.beats));
+    planned_note.program_pointer =
+        &sub_note.get_program(pitched_voices, unpitched_voices);
+    planned_note.velocity =
+        to_int(play_state.current_velocity *
+               rational_to_double(sub_note.velocity_ratio) *
+               rational_to_double(voice_velocity_ratio));
+    planned_note.voice_number = sub_note.voice_number;
+    planned_note.chord_number = chord_number;
+    planned_note.note_number = note_number;
+    if constexpr (std::is_same_v<SubNote, PitchedNote>) {
+      planned_note.is_pitched = true;
+      planned_note.frequency =
+          play_state.current_key * interval_to_double(sub_note.interval);
+      planned_note.midi_number =
+          frequency_to_midi_number(planned_note.frequency);
+    } else {
+      planned_note.is_pitched = false;
+      planned_note.midi_number =
+          unpitched_voices.at(sub_note.voice_number).midi_number;
+    }
+    planned_notes.push_back(planned_note);
+  }
+}
+
+// matches the order PlaybackPlan::notes is sorted in
+auto get_note_order(const PlannedNote& planned_note)
+    -> std::tuple<int, bool, int> {
+  return {planned_note.chord_number, !planned_note.is_pitched,
+          planned_note.note_number};
+}
+
+auto find_planned_note(const PlaybackPlan& playback_plan,
+                       const int chord_number, const bool is_pitched,
+                       const int note_number) -> qsizetype {
+  const auto& notes = playback_plan.notes;
+  return std::distance(
+      notes.cbegin(),
+      std::ranges::lower_bound(
+          notes, std::tuple<int, bool, int>{chord_number, !is_pitched,
+                                            note_number},
+          std::less<>(), get_note_order));
+}
+
+auto get_planned_slice(const PlaybackPlan& playback_plan,
+                       const qsizetype first_index, const qsizetype last_index)
+    -> std::span<const PlannedNote> {
+  Q_ASSERT(first_index <= last_index);
+  return {playback_plan.notes.constData() + first_index,
+          static_cast<size_t>(last_index - first_index)};
+}
+
+}  // namespace
+
+auto compile_playback_plan(const Song& song) -> PlaybackPlan {
+  PlaybackPlan playback_plan;
+  auto& chord_states = playback_plan.chord_states;
+  auto& notes = playback_plan.notes;
+
+  const auto& pitched_voices = song.pitched_voices;
+  const auto& unpitched_voices = song.unpitched_voices;
+  const auto& chords = song.chords;
+  chord_states.reserve(chords.size());
+
+  PlayState play_state;
+  initialize_playstate(song, play_state, 0);
+  for (auto chord_number = 0; chord_number < chords.size();
+       chord_number = chord_number + 1) {
+    const auto& chord = chords.at(chord_number);
+    modulate(play_state, chord);
+    chord_states.push_back(play_state);
+    append_planned_notes(notes, play_state, pitched_voices, unpitched_voices,
+                         chord_number, chord.pitched_notes);
+    append_planned_notes(notes, play_state, pitched_voices, unpitched_voices,
+                         chord_number, chord.unpitched_notes);
+    move_time(play_state, chord);
+  }
+  playback_plan.end_time = play_state.current_time;
+
+  auto& passes = playback_plan.passes;
+  auto played_time = 0.0;
+  for (const auto& played_run : get_played_runs(song)) {
+    const auto first_chord_number = played_run.first_chord_number;
+    const auto number_of_chords = played_run.number_of_chords;
+    const auto start_time =
+        get_chord_start_time(playback_plan, first_chord_number);
+    passes.push_back(PlannedPass{
+        .first_chord_number = first_chord_number,
+        .number_of_chords = number_of_chords,
+        .time_offset = played_time - start_time});
+    played_time =
+        played_time +
+        get_chord_start_time(playback_plan,
+                             first_chord_number + number_of_chords) -
+        start_time;
+  }
+  playback_plan.played_end_time = played_time;
+  return playback_plan;
+}
+
+auto get_chord_start_time(const PlaybackPlan& playback_plan,
+                          const int chord_number) -> double {
+  const auto& chord_states = playback_plan.chord_states;
+  Q_ASSERT(chord_number >= 0);
+  Q_ASSERT(chord_number <= chord_states.size());
+  return chord_number == chord_states.size()
+             ? playback_plan.end_time
+             : chord_states.at(chord_number).current_time;
+}
+
+auto get_planned_chords(const PlaybackPlan& playback_plan,
+                        const int first_chord_number,
+                        const int number_of_chords)
+    -> std::span<const PlannedNote> {
+  return get_planned_slice(
+      playback_plan,
+      find_planned_note(playback_plan, first_chord_number, true, 0),
+      find_planned_note(playback_plan, first_chord_number + number_of_chords,
+                        true, 0));
+}
+
+auto get_planned_notes(const PlaybackPlan& playback_plan,
+                       const int chord_number, const bool is_pitched,
+                       const int first_note_number, const int number_of_notes)
+    -> std::span<const PlannedNote> {
+  return get_planned_slice(
+      playback_plan,
+      find_planned_note(playback_plan, chord_number, is_pitched,
+                        first_note_number),
+      find_planned_note(playback_plan, chord_number, is_pitched,
+                        first_note_number + number_of_notes));
+}
+
+auto get_planned_note_warning(const PlannedNote& planned_note)
+    -> std::optional<UserWarning> {
+  const auto chord_number = planned_note.chord_number;
+  const auto note_number = planned_note.note_number;
+  if (planned_note.is_pitched) {
+    const auto frequency = planned_note.frequency;
+    static const auto minimum_frequency =
+        midi_number_to_frequency(0 - QUARTER_STEP);
+    if (frequency < minimum_frequency) {
+      QString message;
+      QTextStream stream(&message);
+      stream << QObject::tr("Frequency ") << QString::number(frequency, 'g', 3);
+      add_note_location<PitchedNote>(stream, chord_number, note_number);
+      stream << QObject::tr(" less than minimum frequency ")
+             << QString::number(minimum_frequency, 'g', 3);
+      return UserWarning{.title = QObject::tr("Frequency error"),
+                         .message = message};
+    }
+
+    if (frequency >= MAX_FREQUENCY) {
+      QString message;
+      QTextStream stream(&message);
+      stream << QObject::tr("Frequency ") << QString::number(frequency, 'g', 3);
+      add_note_location<PitchedNote>(stream, chord_number, note_number);
+      stream << QObject::tr(" greater than or equal to maximum frequency ")
+             << QString::number(MAX_FREQUENCY, 'g', 3);
+      return UserWarning{.title = QObject::tr("Frequency error"),
+                         .message = message};
+    }
+  }
+
+  const auto velocity = planned_note.velocity;
+  if (velocity > MAX_VELOCITY) {
+    QString message;
+    QTextStream stream(&message);
+    stream << QObject::tr("Velocity ") << velocity << QObject::tr(" exceeds ")
+           << MAX_VELOCITY;
+    if (planned_note.is_pitched) {
+      add_note_location<PitchedNote>(stream, chord_number, note_number);
+    } else {
+      add_note_location<UnpitchedNote>(stream, chord_number, note_number);
+    }
+    return UserWarning{.title = QObject::tr("Velocity error"),
+                       .message = message};
+  }
+  return std::nullopt;
+}
+
+auto check_planned_note(QWidget& parent, const PlannedNote& planned_note)
+    -> bool {
+  const auto maybe_warning = get_planned_note_warning(planned_note);
+  if (maybe_warning.has_value()) {
+    show_warning(parent, *maybe_warning);
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <QtCore/QList>
+#include <optional>
+#include <span>
+
+#include "other/UserWarning.hpp"
+#include "sound/PlayState.hpp"
+
+class QWidget;
+struct Program;
+struct Song;
+
+// a note with everything that depends on the song already worked out, but
+// nothing that depends on which channel it ends up on, so the same plan
+// serves live playback, WAV export and MIDI export alike
+struct PlannedNote {
+  double start_time = 0;  // milliseconds from the start of the song
+  double end_time = 0;
+  const Program* program_pointer = nullptr;
+  double frequency = 0;  // only meaningful when is_pitched
+  double midi_number = 0;
+  // unclamped, so check_planned_note can still complain about it
+  int velocity = 0;
+  int voice_number = 0;
+  int chord_number = 0;
+  int note_number = 0;  // index within chord.pitched_notes / .unpitched_notes
+  bool is_pitched = true;
+};
+
+// a run of chords playing straight through (see get_played_runs), with how
+// much later than written its notes sound
+struct PlannedPass {
+  int first_chord_number = 0;
+  int number_of_chords = 0;
+  double time_offset = 0;
+};
+
+struct PlaybackPlan {
+  // which SongWidget::song_revision this was compiled from
+  int song_revision = -1;
+  // the play state each chord's notes sound with, i.e. after modulating into
+  // it, with the chord's own start time
+  QList<PlayState> chord_states;
+  // sorted by chord, then pitched before unpitched, then note number, so any
+  // selection is a contiguous slice (see get_planned_chords and
+  // get_planned_notes). Since every note in a chord starts with it, this is
+  // start time order too
+  QList<PlannedNote> notes;
+  double end_time = 0;  // when the last chord finishes
+  // the whole song as it plays, with its repeats expanded: each pass's slice
+  // of notes (see get_planned_chords), in order, shifted by its time_offset.
+  // Notes are only planned once, however many times they play
+  QList<PlannedPass> passes;
+  double played_end_time = 0;  // when the last pass finishes
+};
+
+// nothing gets validated here: a note that can't be played only matters if
+// it's actually in what's being played, so check_planned_note is left to
+// whoever consumes the plan
+[[nodiscard]] auto compile_playback_plan(const Song& song) -> PlaybackPlan;
+
+// chord_number may be one past the last chord, for the end of the song
+[[nodiscard]] auto get_chord_start_time(const PlaybackPlan& playback_plan,
+                                        int chord_number) -> double;
+
+[[nodiscard]] auto get_planned_chords(const PlaybackPlan& playback_plan,
+                                      int first_chord_number,
+                                      int number_of_chords)
+    -> std::span<const PlannedNote>;
+
+[[nodiscard]] auto get_planned_notes(const PlaybackPlan& playback_plan,
+                                     int chord_number, bool is_pitched,
+                                     int first_note_number, int number_of_notes)
+    -> std::span<const PlannedNote>;
+
+// the first problem, if any, that would make the note unplayable as-is (e.g.
+// a pitched note whose frequency is out of MIDI range); callers should abort
+// rather than play a bogus note
+[[nodiscard]] auto get_planned_note_warning(const PlannedNote& planned_note)
+    -> std::optional<UserWarning>;
+
+// shows get_planned_note_warning's warning, if there is one
+[[nodiscard]] auto check_planned_note(QWidget& parent,
+                                      const PlannedNote& planned_note) -> bool;
@@ -1,17 +1,105 @@
 #include "sound/Player.hpp"
 
+#include <QtCore/QSettings>
 #include <QtWidgets/QMessageBox>
+#include <chrono>
 #include <thread>
 
 #include "cell_types/Program.hpp"
 
-auto make_audio_driver(QWidget& parent, FluidSettings& settings,
-                       FluidSynth& synth) -> FluidDriver {
+namespace {
+
+// the primary synth goes first: its sample timer is what advances the
+// sequencer, which is in turn what dispatches events to the pooled synths
+auto mix_all_synths(Player& player, const int length,
+                    const int number_of_effects, float** const effects,
+                    const int number_of_outputs, float** const outputs)
+    -> int {
+  const auto primary_result = fluid_synth_process(
+      player.synth.internal_pointer, length, number_of_effects, effects,
+      number_of_outputs, outputs);
+  if (primary_result != FLUID_OK) {
+    return primary_result;
+  }
+  const auto number_of_pooled_synths = player.number_of_pooled_synths.load();
+  for (auto synth_number = 0; synth_number < number_of_pooled_synths;
+       synth_number = synth_number + 1) {
+    // fluid_synth_process() adds to outputs rather than overwriting them,
+    // so this mixes each pooled synth in on top of the primary one
+    const auto pooled_result = fluid_synth_process(
+        get_reference(player.pooled_synths.at(synth_number).get())
+            .synth.internal_pointer,
+        length, number_of_effects, effects, number_of_outputs, outputs);
+    if (pooled_result != FLUID_OK) {
+      return pooled_result;
+    }
+  }
+  // the first stereo pair, which is all the synths themselves write to
+  // unless audio.channels is raised
+  if (number_of_outputs >= 2) {
+    mix_pre_rendered_playback(player.pre_rendered_playback, length,
+                              outputs[0], outputs[1]);
+  }
+  return FLUID_OK;
+}
+
+// a period that takes longer to mix than it lasts has most likely left the
+// driver with nothing to play
+auto mix_synths(void* const data_pointer, const int length,
+                const int number_of_effects, float** const effects,
+                const int number_of_outputs, float** const outputs) -> int {
+  auto& player = get_reference(static_cast<Player*>(data_pointer));
+  const auto start_time = std::chrono::steady_clock::now();
+  const auto result = mix_all_synths(player, length, number_of_effects,
+                                     effects, number_of_outputs, outputs);
+  const auto mix_seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                    start_time)
+          .count();
+  if (mix_seconds > length / player.sample_rate) {
+    player.number_of_late_periods.fetch_add(1);
+  }
+  return result;
+}
+
+auto get_sample_rate(const FluidSettings& settings) -> double {
+  auto sample_rate = 0.0;
+  check_fluid_ok(fluid_settings_getnum(settings.internal_pointer,
+                                       "synth.sample-rate", &sample_rate));
+  Q_ASSERT(sample_rate > 0);
+  return sample_rate;
+}
+
+// copies an app setting over to fluidsynth, within fluidsynth's limits for
+// it -- left unset (or 0), fluidsynth's own default stands
+void apply_buffer_setting(FluidSettings& settings, const char* const key,
+                          const char* const field, const int minimum,
+                          const int maximum) {
+  const auto value = QSettings().value(key, 0).toInt();
+  if (value > 0) {
+    set_fluid_int(settings, field, std::clamp(value, minimum, maximum));
+  }
+}
+
+}  // namespace
+
+auto make_audio_driver(Player& player) -> FluidDriver {
+  // fluidsynth's own limits for these settings
+  static const auto MIN_PERIOD_SIZE = 64;
+  static const auto MAX_PERIOD_SIZE = 8192;
+  static const auto MIN_PERIODS = 2;
+  static const auto MAX_PERIODS = 64;
+
+  auto& settings = player.settings;
+  apply_buffer_setting(settings, "audio/period_size", "audio.period-size",
+                       MIN_PERIOD_SIZE, MAX_PERIOD_SIZE);
+  apply_buffer_setting(settings, "audio/periods", "audio.periods",
+                       MIN_PERIODS, MAX_PERIODS);
 #ifndef NO_REALTIME_AUDIO
-  auto* const audio_driver_pointer =
-      new_fluid_audio_driver(settings.internal_pointer, synth.internal_pointer);
+  auto* const audio_driver_pointer = new_fluid_audio_driver2(
+      settings.internal_pointer, mix_synths, &player);
   if (audio_driver_pointer == nullptr) {
-    QMessageBox::warning(&parent, QObject::tr("Audio driver error"),
+    QMessageBox::warning(&player.parent, QObject::tr("Audio driver error"),
                          QObject::tr("Cannot start audio driver"));
   }
   return FluidDriver(audio_driver_pointer);
@@ -20,15 +108,43 @@ auto make_audio_driver(QWidget& parent, FluidSettings& settings,
 #endif
 }
 
-void stop_playing(const FluidSequencer& sequencer, const FluidEvent& event) {
+void stop_playing(Player& player) {
+  auto& sequencer = player.sequencer;
+  auto& event = player.event;
   fluid_sequencer_remove_events(sequencer.internal_pointer, -1, -1, -1);
+  cancel_auditions(player.auditioner);
+  stop_pre_rendered_playback(player.pre_rendered_playback);
 
-  for (auto channel_number = 0; channel_number < NUMBER_OF_MIDI_CHANNELS;
+  const auto number_of_channels =
+      static_cast<int>(player.channel_schedules.size());
+  for (auto channel_number = 0; channel_number < number_of_channels;
        channel_number = channel_number + 1) {
-    fluid_event_all_sounds_off(event.internal_pointer, channel_number);
+    fluid_event_all_sounds_off(event.internal_pointer,
+                               route_to_channel(player, channel_number));
     fluid_sequencer_send_now(sequencer.internal_pointer,
                              event.internal_pointer);
   }
+  set_destination(event, sequencer.sequencer_id);
+}
+
+auto get_period_duration(const Player& player) -> double {
+  static const auto MILLISECONDS_PER_SECOND = 1000.0;
+  auto period_size = 0;
+  check_fluid_ok(fluid_settings_getint(player.settings.internal_pointer,
+                                       "audio.period-size", &period_size));
+  return period_size * MILLISECONDS_PER_SECOND / player.sample_rate;
+}
+
+auto get_output_latency(const Player& player) -> double {
+  auto periods = 0;
+  check_fluid_ok(fluid_settings_getint(player.settings.internal_pointer,
+                                       "audio.periods", &periods));
+  return get_period_duration(player) * periods;
+}
+
+auto get_audition_latency(const Player& player) -> double {
+  return get_output_latency(player) +
+         player.auditioner.dispatch_milliseconds.load();
 }
 
 void check_fluid_ok(const int fluid_result) {
@@ -54,9 +170,75 @@ void set_destination(FluidEvent& event, const fluid_seq_id_t sequencer_id) {
   fluid_event_set_dest(event.internal_pointer, sequencer_id);
 }
 
+auto route_to_channel(Player& player, const int channel_number) -> int {
+  Q_ASSERT(channel_number >= 0);
+  Q_ASSERT(channel_number < player.channel_schedules.size());
+  const auto synth_number = channel_number / NUMBER_OF_MIDI_CHANNELS;
+  set_destination(
+      player.event,
+      synth_number == 0
+          ? player.sequencer.sequencer_id
+          : get_reference(player.pooled_synths.at(synth_number - 1).get())
+                .sequencer_id);
+  return get_synth_channel_number(channel_number);
+}
+
+auto get_synth_channel_number(const int channel_number) -> int {
+  return channel_number % NUMBER_OF_MIDI_CHANNELS;
+}
+
+auto get_channel_synth(Player& player, const int channel_number)
+    -> FluidSynth& {
+  Q_ASSERT(channel_number >= 0);
+  Q_ASSERT(channel_number < player.channel_schedules.size());
+  const auto synth_number = channel_number / NUMBER_OF_MIDI_CHANNELS;
+  return synth_number == 0
+             ? player.synth
+             : get_reference(player.pooled_synths.at(synth_number - 1).get())
+                   .synth;
+}
+
+auto add_pooled_channels(Player& player) -> bool {
+  const auto number_of_pooled_synths = player.number_of_pooled_synths.load();
+  if (number_of_pooled_synths >= MAX_NUMBER_OF_POOLED_SYNTHS) {
+    return false;
+  }
+  auto& pooled_synth_pointer =
+      player.pooled_synths.at(number_of_pooled_synths);
+  pooled_synth_pointer =
+      std::make_unique<PooledSynth>(player.settings, player.sequencer);
+  fluid_synth_set_gain(pooled_synth_pointer->synth.internal_pointer,
+                       fluid_synth_get_gain(player.synth.internal_pointer));
+  player.number_of_pooled_synths.store(number_of_pooled_synths + 1);
+
+  auto& channel_schedules = player.channel_schedules;
+  const auto first_channel_number = static_cast<int>(channel_schedules.size());
+  for (auto channel_number = first_channel_number;
+       channel_number < first_channel_number + NUMBER_OF_MIDI_CHANNELS;
+       channel_number = channel_number + 1) {
+    channel_schedules.push_back(0);
+    player.tuned_channels.push_back(TunedChannel());
+    player.channel_releases.emplace(0, channel_number);
+  }
+  return true;
+}
+
+void set_gain(Player& player, const double gain) {
+  fluid_synth_set_gain(player.synth.internal_pointer, static_cast<float>(gain));
+  const auto number_of_pooled_synths = player.number_of_pooled_synths.load();
+  for (auto synth_number = 0; synth_number < number_of_pooled_synths;
+       synth_number = synth_number + 1) {
+    fluid_synth_set_gain(
+        get_reference(player.pooled_synths.at(synth_number).get())
+            .synth.internal_pointer,
+        static_cast<float>(gain));
+  }
+}
+
 Player::Player(QWidget& parent_input)
     : parent(parent_input),
       channel_schedules(QList<double>(NUMBER_OF_MIDI_CHANNELS, 0)),
+      tuned_channels(QList<TunedChannel>(NUMBER_OF_MIDI_CHANNELS)),
       settings(FluidSettings(
           NUMBER_OF_MIDI_CHANNELS,
           static_cast<int>(std::thread::hardware_concurrency()),
@@ -66,11 +248,14 @@ Player::Player(QWidget& parent_input)
           nullptr
 #endif
           )),
+      sample_rate(get_sample_rate(settings)),
       synth(FluidSynth(settings)),
       sequencer(FluidSequencer(synth)),
       soundfont_id(get_soundfont_id(synth)),
-      driver(make_audio_driver(parent, settings, synth)) {
+      auditioner(synth, static_cast<int>(soundfont_id)),
+      pre_renderer(sample_rate),
+      driver(make_audio_driver(*this)) {
   set_destination(event, sequencer.sequencer_id);
 }
 
-Player::~Player() { stop_playing(sequencer, event); }
+Player::~Player() { stop_playing(*this); }
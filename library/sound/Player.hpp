@@ -1,21 +1,50 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <memory>
+#include <queue>
+
+#include "sound/Auditioner.hpp"
 #include "sound/FluidDriver.hpp"
 #include "sound/FluidEvent.hpp"
 #include "sound/FluidSequencer.hpp"
 #include "sound/FluidSettings.hpp"
 #include "sound/FluidSynth.hpp"
 #include "sound/PlayState.hpp"
+#include "sound/PooledSynth.hpp"
+#include "sound/PreRenderer.hpp"
+#include "sound/TunedChannel.hpp"
 
 class QWidget;
+struct Player;
 struct Program;
 
 static const auto NUMBER_OF_MIDI_CHANNELS = 64;
+// on top of the primary synth -- each pooled synth adds another
+// NUMBER_OF_MIDI_CHANNELS channels, but also loads its own copy of the
+// soundfont, so they're only created once a dense passage actually has
+// every existing channel still ringing (see add_pooled_channels)
+static const auto MAX_NUMBER_OF_POOLED_SYNTHS = 7;
+
+// mixes the primary synth and every pooled synth into one driver
+[[nodiscard]] auto make_audio_driver(Player& player) -> FluidDriver;
+
+void stop_playing(Player& player);
 
-[[nodiscard]] auto make_audio_driver(QWidget& parent, FluidSettings& settings,
-                                     FluidSynth& synth) -> FluidDriver;
+// how much audio the driver buffers ahead, in milliseconds -- the floor on
+// how quickly anything can be heard. Comes from audio.period-size and
+// audio.periods, which can be lowered (at the risk of dropouts on a busy
+// machine) through the audio/period_size and audio/periods settings
+[[nodiscard]] auto get_output_latency(const Player& player) -> double;
 
-void stop_playing(const FluidSequencer& sequencer, const FluidEvent& event);
+// how much audio the driver asks the synth for at a time, in milliseconds --
+// the sequencer's clock only advances once per period, in steps this size
+[[nodiscard]] auto get_period_duration(const Player& player) -> double;
+
+// the output latency plus how long the most recent preview took to reach the
+// synth (see Auditioner)
+[[nodiscard]] auto get_audition_latency(const Player& player) -> double;
 
 void check_fluid_ok(int fluid_result);
 
@@ -26,12 +55,40 @@ void set_fluid_string(FluidSettings& settings, const char* field,
 
 void set_destination(FluidEvent& event, fluid_seq_id_t sequencer_id);
 
+// channel numbers count up through the primary synth's channels, then each
+// pooled synth's in turn -- points player.event at whichever synth owns
+// channel_number, and returns that synth's own channel for it
+[[nodiscard]] auto route_to_channel(Player& player, int channel_number) -> int;
+
+// the channel within its own synth that channel_number stands for, without
+// pointing player.event anywhere
+[[nodiscard]] auto get_synth_channel_number(int channel_number) -> int;
+
+// the synth that owns channel_number (see route_to_channel)
+[[nodiscard]] auto get_channel_synth(Player& player, int channel_number)
+    -> FluidSynth&;
+
+// creates the next pooled synth and makes its channels available, or
+// returns false if the pool is full
+[[nodiscard]] auto add_pooled_channels(Player& player) -> bool;
+
+void set_gain(Player& player, double gain);
+
 struct Player {
   // data
   QWidget& parent;
 
   // play state fields
+  // when each channel (across the primary and pooled synths) finishes its
+  // release tail
   QList<double> channel_schedules;
+  // every channel not currently claimed by get_note_slot, keyed by its
+  // schedule -- the top is the channel that frees up soonest, so allocation
+  // only ever has to look there. play_note pushes a pitched note's channel
+  // back once it knows the note's release time
+  std::priority_queue<std::pair<double, int>,
+                      std::vector<std::pair<double, int>>, std::greater<>>
+      channel_releases;
   // percussion programs don't send pitch bend and (per MS_Basic.sf3)
   // have no breath-controller modulators, so unlike pitched notes, a channel
   // can safely be shared by overlapping notes of the same percussion program
@@ -40,16 +97,44 @@ struct Player {
   // switching a channel's program mid-decay (the actual source of glitches)
   // can't happen for percussion at all
   QHash<const Program*, int> percussion_channels;
+  // parallel to channel_schedules, only used with use_key_tuning
+  QList<TunedChannel> tuned_channels;
   PlayState play_state;
 
   double final_time = 0;
 
+  // instead of giving every pitched note a channel of its own to pitch bend,
+  // retune individual keys (via each channel's own fluidsynth tuning
+  // program) so overlapping notes of one program can share a channel
+  bool use_key_tuning = false;
+
+  // render selections ahead of time (see PreRenderer), and play those
+  // renders instead of scheduling the notes live, once they're ready
+  bool use_pre_rendering = false;
+  // the number of the newest pre-render request
+  int pre_render_request_number = 0;
+
   FluidSettings settings;
+  const double sample_rate;
 
   FluidSynth synth;
   FluidEvent event;
   FluidSequencer sequencer;
   const unsigned int soundfont_id;
+  Auditioner auditioner;
+  PreRenderer pre_renderer;
+  PreRenderedPlayback pre_rendered_playback;
+  // declared after the sequencer, so each unregisters itself before the
+  // sequencer goes away, and before the driver, so the driver's callback
+  // has stopped mixing them before they do
+  std::array<std::unique_ptr<PooledSynth>, MAX_NUMBER_OF_POOLED_SYNTHS>
+      pooled_synths;
+  // also read from the audio thread, so only bumped once the new synth is
+  // fully constructed
+  std::atomic<int> number_of_pooled_synths = 0;
+  // how many audio periods took longer to mix than they last, which is when
+  // the driver runs dry and playback glitches. Bumped by the audio thread
+  std::atomic<int> number_of_late_periods = 0;
   FluidDriver driver;
 
   explicit Player(QWidget& parent_input);
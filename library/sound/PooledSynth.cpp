@@ -0,0 +1,67 @@
+#include "sound/PooledSynth.hpp"
+
+#include <fluidsynth.h>
+
+#include "cell_types/Program.hpp"
+#include "sound/FluidSequencer.hpp"
+
+namespace {
+
+// mirrors the subset of fluidsynth's own sequencer-to-synth binding that
+// play_note and stop_playing actually send
+void forward_to_synth(unsigned int /*time*/, fluid_event_t* const event_pointer,
+                      fluid_sequencer_t* /*sequencer_pointer*/,
+                      void* const data_pointer) {
+  const auto& pooled_synth =
+      get_reference(static_cast<PooledSynth*>(data_pointer));
+  auto* const synth_pointer = pooled_synth.synth.internal_pointer;
+  const auto channel_number = fluid_event_get_channel(event_pointer);
+  switch (fluid_event_get_type(event_pointer)) {
+    case FLUID_SEQ_NOTEON:
+      fluid_synth_noteon(synth_pointer, channel_number,
+                         fluid_event_get_key(event_pointer),
+                         fluid_event_get_velocity(event_pointer));
+      break;
+    case FLUID_SEQ_NOTEOFF:
+      fluid_synth_noteoff(synth_pointer, channel_number,
+                          fluid_event_get_key(event_pointer));
+      break;
+    case FLUID_SEQ_PROGRAMSELECT:
+      // each synth numbers its own soundfonts, so the primary synth's id
+      // that the event carries isn't necessarily this synth's
+      fluid_synth_program_select(synth_pointer, channel_number,
+                                 pooled_synth.soundfont_id,
+                                 fluid_event_get_bank(event_pointer),
+                                 fluid_event_get_program(event_pointer));
+      break;
+    case FLUID_SEQ_CONTROLCHANGE:
+      fluid_synth_cc(synth_pointer, channel_number,
+                     fluid_event_get_control(event_pointer),
+                     fluid_event_get_value(event_pointer));
+      break;
+    case FLUID_SEQ_PITCHBEND:
+      fluid_synth_pitch_bend(synth_pointer, channel_number,
+                             fluid_event_get_pitch(event_pointer));
+      break;
+    case FLUID_SEQ_ALLSOUNDSOFF:
+      fluid_synth_all_sounds_off(synth_pointer, channel_number);
+      break;
+    default:
+      break;
+  }
+}
+
+}  // namespace
+
+PooledSynth::PooledSynth(FluidSettings& settings, FluidSequencer& sequencer)
+    : sequencer_pointer(sequencer.internal_pointer),
+      synth(FluidSynth(settings)),
+      soundfont_id(get_soundfont_id(synth)),
+      sequencer_id(fluid_sequencer_register_client(
+          sequencer_pointer, "pooled synth", forward_to_synth, this)) {
+  Q_ASSERT(sequencer_id >= 0);
+}
+
+PooledSynth::~PooledSynth() {
+  fluid_sequencer_unregister_client(sequencer_pointer, sequencer_id);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <fluidsynth/types.h>
+
+#include "other/helpers.hpp"
+#include "sound/FluidSynth.hpp"
+
+struct FluidSequencer;
+struct FluidSettings;
+
+// an extra synth that adds NUMBER_OF_MIDI_CHANNELS more channels to a
+// Player's channel pool. Unlike the primary synth it's registered with the
+// shared sequencer as a plain client rather than via
+// fluid_sequencer_register_fluidsynth(), which would also hook the
+// sequencer's clock to this synth's own sample count -- a synth created
+// partway through a session would then keep dragging the clock back to its
+// own, much smaller, count. Its audio is mixed in by make_audio_driver's
+// callback instead of getting a driver of its own
+struct PooledSynth {
+  fluid_sequencer_t* const sequencer_pointer;
+  FluidSynth synth;
+  const int soundfont_id;
+  const fluid_seq_id_t sequencer_id;
+
+  PooledSynth(FluidSettings& settings, FluidSequencer& sequencer);
+
+  NO_MOVE_COPY(PooledSynth)
+
+  ~PooledSynth();
+};
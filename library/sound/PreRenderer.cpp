@@ -0,0 +1,167 @@
+#include "sound/PreRenderer.hpp"
+
+#include <fluidsynth.h>
+
+#include <algorithm>
+
+#include "sound/Player.hpp"
+
+namespace {
+
+// how often a render checks whether it's been superseded
+const auto PRE_RENDER_BLOCK_FRAMES = 4096;
+
+auto render_request(PreRenderer& pre_renderer, OfflineSynth& offline_synth,
+                    const PreRenderRequest& request)
+    -> std::shared_ptr<const PreRenderedAudio> {
+  const auto& notes = request.notes;
+  const auto maybe_note_channels = get_offline_channels(notes);
+  if (!maybe_note_channels.has_value()) {
+    return nullptr;
+  }
+
+  auto end_time = 0.0;
+  for (const auto& note : notes) {
+    end_time = std::max(end_time, note.end_time + note.release_milliseconds);
+  }
+
+  auto* const synth_pointer = offline_synth.synth.internal_pointer;
+  check_fluid_ok(fluid_synth_system_reset(synth_pointer));
+  fluid_synth_set_gain(synth_pointer, request.gain);
+
+  const auto number_of_frames = to_frame(end_time, offline_synth.sample_rate);
+  auto audio_pointer = std::make_shared<PreRenderedAudio>();
+  audio_pointer->request_number = request.request_number;
+  auto& left_samples = audio_pointer->left_samples;
+  auto& right_samples = audio_pointer->right_samples;
+  left_samples.resize(number_of_frames);
+  right_samples.resize(number_of_frames);
+
+  auto rendered_frames = size_t{0};
+  if (!play_offline_notes(
+          offline_synth, notes, *maybe_note_channels, number_of_frames,
+          [&](const size_t frame) -> bool {
+            while (rendered_frames < frame) {
+              if (pre_renderer.wanted_request_number.load() !=
+                  request.request_number) {
+                return false;
+              }
+              const auto block_frames =
+                  std::min(frame - rendered_frames,
+                           static_cast<size_t>(PRE_RENDER_BLOCK_FRAMES));
+              check_fluid_ok(fluid_synth_write_float(
+                  synth_pointer, static_cast<int>(block_frames),
+                  left_samples.data(), static_cast<int>(rendered_frames), 1,
+                  right_samples.data(), static_cast<int>(rendered_frames),
+                  1));
+              rendered_frames = rendered_frames + block_frames;
+            }
+            return true;
+          })) {
+    return nullptr;
+  }
+  return audio_pointer;
+}
+
+void run_pre_renders(PreRenderer& pre_renderer, const double sample_rate) {
+  // loaded on the thread, so the GUI thread never waits on a second copy of
+  // the soundfont, and only for the first request, so it isn't loaded at
+  // all unless pre-rendering gets turned on
+  std::optional<OfflineSynth> maybe_offline_synth;
+
+  auto& pending_request = pre_renderer.pending_request;
+  std::unique_lock lock(pre_renderer.mutex);
+  while (true) {
+    pre_renderer.condition.wait(lock, [&pre_renderer]() -> auto {
+      return pre_renderer.stopping ||
+             pre_renderer.pending_request.has_value();
+    });
+    if (pre_renderer.stopping) {
+      return;
+    }
+    const auto request = std::move(*pending_request);
+    pending_request.reset();
+
+    lock.unlock();
+    if (!maybe_offline_synth.has_value()) {
+      maybe_offline_synth.emplace(sample_rate);
+      pre_renderer.synth_loaded.store(true);
+    }
+    auto audio_pointer =
+        render_request(pre_renderer, *maybe_offline_synth, request);
+    lock.lock();
+
+    if (audio_pointer != nullptr) {
+      pre_renderer.rendered_audio_pointer = std::move(audio_pointer);
+    }
+  }
+}
+
+}  // namespace
+
+PreRenderer::PreRenderer(const double sample_rate)
+    : thread(std::thread(run_pre_renders, std::ref(*this), sample_rate)) {}
+
+PreRenderer::~PreRenderer() {
+  {
+    const std::lock_guard lock(mutex);
+    stopping = true;
+    // abandons a render in progress too
+    wanted_request_number.store(-1);
+  }
+  condition.notify_one();
+  thread.join();
+}
+
+void queue_pre_render(PreRenderer& pre_renderer, PreRenderRequest request) {
+  {
+    const std::lock_guard lock(pre_renderer.mutex);
+    pre_renderer.wanted_request_number.store(request.request_number);
+    pre_renderer.pending_request = std::move(request);
+  }
+  pre_renderer.condition.notify_one();
+}
+
+auto get_pre_rendered_audio(PreRenderer& pre_renderer,
+                            const int request_number)
+    -> std::shared_ptr<const PreRenderedAudio> {
+  const std::lock_guard lock(pre_renderer.mutex);
+  const auto& audio_pointer = pre_renderer.rendered_audio_pointer;
+  if (audio_pointer == nullptr ||
+      audio_pointer->request_number != request_number) {
+    return nullptr;
+  }
+  return audio_pointer;
+}
+
+void start_pre_rendered_playback(
+    PreRenderedPlayback& playback,
+    std::shared_ptr<const PreRenderedAudio> audio_pointer) {
+  const std::lock_guard lock(playback.mutex);
+  playback.audio_pointer = std::move(audio_pointer);
+  playback.next_frame = 0;
+}
+
+void stop_pre_rendered_playback(PreRenderedPlayback& playback) {
+  const std::lock_guard lock(playback.mutex);
+  playback.audio_pointer = nullptr;
+}
+
+void mix_pre_rendered_playback(PreRenderedPlayback& playback, const int length,
+                               float* const left, float* const right) {
+  const std::unique_lock lock(playback.mutex, std::try_to_lock);
+  if (!lock.owns_lock() || playback.audio_pointer == nullptr) {
+    return;
+  }
+  const auto& audio = *playback.audio_pointer;
+  const auto first_frame = playback.next_frame;
+  const auto number_of_frames =
+      std::min(static_cast<size_t>(length),
+               audio.left_samples.size() - std::min(first_frame,
+                                                    audio.left_samples.size()));
+  for (auto frame = size_t{0}; frame < number_of_frames; frame = frame + 1) {
+    left[frame] = left[frame] + audio.left_samples.at(first_frame + frame);
+    right[frame] = right[frame] + audio.right_samples.at(first_frame + frame);
+  }
+  playback.next_frame = first_frame + number_of_frames;
+}
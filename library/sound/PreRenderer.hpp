@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "other/helpers.hpp"
+#include "sound/OfflineSynth.hpp"
+
+struct PreRenderRequest {
+  int request_number = 0;
+  float gain = 0;
+  // sorted by start time
+  std::vector<OfflineNote> notes;
+};
+
+struct PreRenderedAudio {
+  int request_number = 0;
+  std::vector<float> left_samples;
+  std::vector<float> right_samples;
+};
+
+// renders the current selection ahead of time, on a thread and synth of its
+// own, so playing it back is only a matter of copying samples into the
+// driver's buffer -- dense passages can't make the live synth fall behind
+// and drop out. Only the newest request matters: a new one abandons
+// whatever render is still in progress
+struct PreRenderer {
+  std::mutex mutex;
+  std::condition_variable condition;
+  // guarded by mutex
+  std::optional<PreRenderRequest> pending_request;
+  // guarded by mutex
+  std::shared_ptr<const PreRenderedAudio> rendered_audio_pointer;
+  // guarded by mutex
+  bool stopping = false;
+
+  // the request the render thread should be working on; checked between
+  // blocks, so a render superseded partway through stops early
+  std::atomic<int> wanted_request_number = 0;
+
+  // the render thread only loads its synth for the first request
+  std::atomic<bool> synth_loaded = false;
+
+  // declared last, so everything the thread touches exists before it starts
+  std::thread thread;
+
+  // sample_rate should match the driver's, so the render plays back at
+  // the right speed
+  explicit PreRenderer(double sample_rate);
+
+  NO_MOVE_COPY(PreRenderer)
+
+  ~PreRenderer();
+};
+
+void queue_pre_render(PreRenderer& pre_renderer, PreRenderRequest request);
+
+// the finished render for request_number, or nullptr if it's still going
+// (or was superseded)
+[[nodiscard]] auto get_pre_rendered_audio(PreRenderer& pre_renderer,
+                                          int request_number)
+    -> std::shared_ptr<const PreRenderedAudio>;
+
+// the pre-rendered audio the driver is mixing in, if any
+struct PreRenderedPlayback {
+  // the audio thread only ever try-locks this, and skips a period rather
+  // than wait
+  std::mutex mutex;
+  // guarded by mutex
+  std::shared_ptr<const PreRenderedAudio> audio_pointer;
+  // guarded by mutex
+  size_t next_frame = 0;
+};
+
+void start_pre_rendered_playback(
+    PreRenderedPlayback& playback,
+    std::shared_ptr<const PreRenderedAudio> audio_pointer);
+
+void stop_pre_rendered_playback(PreRenderedPlayback& playback);
+
+// adds the next length frames on top of what's already in left and right
+void mix_pre_rendered_playback(PreRenderedPlayback& playback, int length,
+                               float* left, float* right);
@@ -0,0 +1,50 @@
+#include "sound/RecordingExport.hpp"
+
+#include <QtCore/QFile>
+
+#include "other/Trace.hpp"
+
+namespace {
+
+void run_recording_export(RecordingExport& recording_export) {
+  const TraceSpan trace_span("render_recording");
+  // loaded here rather than in the constructor, so the GUI thread never
+  // waits on a second copy of the soundfont
+  OfflineSynth offline_synth(recording_export.sample_rate);
+  recording_export.succeeded = render_song_to_file(
+      offline_synth, get_reference(recording_export.song_pointer.get()),
+      recording_export.gain, recording_export.output_file,
+      recording_export.file_format, recording_export.warning,
+      recording_export.created_file,
+      [&recording_export](const double progress) -> auto {
+        recording_export.progress.store(progress);
+        return !recording_export.cancelled.load();
+      });
+  recording_export.finished.store(true);
+}
+
+}  // namespace
+
+RecordingExport::RecordingExport(
+    std::shared_ptr<const Song> song_pointer_input, const double gain_input,
+    QString output_file_input, AudioFileFormat file_format_input,
+    const double sample_rate_input)
+    : song_pointer(std::move(song_pointer_input)), gain(gain_input),
+      output_file(std::move(output_file_input)),
+      file_format(std::move(file_format_input)),
+      sample_rate(sample_rate_input),
+      thread(std::thread(run_recording_export, std::ref(*this))) {}
+
+RecordingExport::~RecordingExport() {
+  if (thread.joinable()) {
+    cancelled.store(true);
+    thread.join();
+    remove_partial_file(*this);
+  }
+}
+
+void remove_partial_file(const RecordingExport& recording_export) {
+  if (recording_export.created_file && !recording_export.succeeded) {
+    QFile::remove(recording_export.output_file);
+  }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QtCore/QString>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "other/Song.hpp"
+#include "other/UserWarning.hpp"
+#include "other/helpers.hpp"
+#include "sound/OfflineSynth.hpp"
+
+// a recording being rendered (see render_song_to_file) on a thread and
+// synth of its own, from a snapshot of the song (see make_song_snapshot), so
+// the song can go on being edited -- and played -- in the meantime
+struct RecordingExport {
+  const std::shared_ptr<const Song> song_pointer;
+  const double gain;
+  const QString output_file;
+  const AudioFileFormat file_format;
+  const double sample_rate;
+
+  // the fraction rendered so far
+  std::atomic<double> progress = 0;
+  // checked every percent or so
+  std::atomic<bool> cancelled = false;
+  std::atomic<bool> finished = false;
+  // only written by the thread, and only read once finished is set
+  bool succeeded = false;
+  bool created_file = false;
+  UserWarning warning;
+
+  // declared last, so everything the thread touches exists before it starts
+  std::thread thread;
+
+  RecordingExport(std::shared_ptr<const Song> song_pointer_input,
+                  double gain_input,
+                  QString output_file_input,
+                  AudioFileFormat file_format_input, double sample_rate_input);
+
+  NO_MOVE_COPY(RecordingExport)
+
+  // cancels the render, and removes what it wrote, unless the thread has
+  // already been joined
+  ~RecordingExport();
+};
+
+// once the thread has been joined, removes whatever part of output_file a
+// failed or cancelled render wrote. Files the render never opened, like one
+// the user already had there, are left alone
+void remove_partial_file(const RecordingExport& recording_export);
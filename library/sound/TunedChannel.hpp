@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QtCore/QList>
+
+struct Program;
+
+static const auto NUMBER_OF_MIDI_KEYS = 128;
+
+// per-channel bookkeeping for key tuning playback (see
+// Player::use_key_tuning), where overlapping notes of one program share a
+// channel, each on its own key retuned to the note's exact pitch
+struct TunedChannel {
+  // the fields below are reset by initialize_play
+  const Program* program_pointer = nullptr;
+  short breath = -1;
+  // when the last note on this channel finishes its release tail
+  double release_time = 0;
+  // each key's tuning in cents, or negative if the key hasn't been retuned
+  // this play -- fluidsynth applies a retuning as soon as it's made rather
+  // than at a scheduled time, so a key keeps the one tuning it's given for
+  // the rest of the play
+  QList<double> key_cents = QList<double>(NUMBER_OF_MIDI_KEYS, -1);
+  QList<double> key_end_times = QList<double>(NUMBER_OF_MIDI_KEYS, 0);
+
+  // kept across plays: whether this channel's tuning program is still
+  // switched on in its synth, so a channel that goes back to pitch bends (or
+  // to percussion) can switch it off again
+  bool tuning_active = false;
+};
@@ -5,10 +5,10 @@
 #include "widgets/IntervalRow.hpp"
 #include "widgets/SpinBoxes.hpp"
 
-ControlsColumn::ControlsColumn(Song& song, FluidSynth& synth,
+ControlsColumn::ControlsColumn(Song& song, Player& player,
                                QUndoStack& undo_stack,
                                SwitchTable& switch_table)
-    : spin_boxes(*new SpinBoxes(song, synth, undo_stack)),
+    : spin_boxes(*new SpinBoxes(song, player, undo_stack)),
       third_row(*new IntervalRow(undo_stack, switch_table, "Major third",
                                  Interval(Rational(FIVE, 4), 0))),
       fifth_row(*new IntervalRow(undo_stack, switch_table, "Perfect fifth",
@@ -4,7 +4,7 @@
 
 class QBoxLayout;
 class QUndoStack;
-struct FluidSynth;
+struct Player;
 struct Song;
 struct SwitchTable;
 struct IntervalRow;
@@ -21,6 +21,6 @@ struct ControlsColumn : public QWidget {
   IntervalRow& octave_row;
   QBoxLayout& column_layout;
 
-  ControlsColumn(Song& song, FluidSynth& synth, QUndoStack& undo_stack,
+  ControlsColumn(Song& song, Player& player, QUndoStack& undo_stack,
                  SwitchTable& switch_table);
 };
@@ -0,0 +1,114 @@
+#include "widgets/PerformanceWidget.hpp"
+
+#include <fluidsynth.h>
+
+#include <QtCore/QTimer>
+#include <QtWidgets/QFormLayout>
+#include <QtWidgets/QLabel>
+#include <algorithm>
+
+#include "sound/Player.hpp"
+#include "widgets/piano_roll/PianoRollNotesScene.hpp"
+
+namespace {
+
+auto get_milliseconds_text(const double milliseconds) -> QString {
+  return PerformanceWidget::tr("%1 ms").arg(milliseconds, 0, 'f', 1);
+}
+
+}  // namespace
+
+PerformanceWidget::PerformanceWidget(
+    const Player& player_input,
+    const PianoRollNotesScene& piano_roll_scene_input)
+    : player(player_input),
+      piano_roll_scene(piano_roll_scene_input),
+      cpu_load_label(*(new QLabel)),
+      active_voices_label(*(new QLabel)),
+      busy_channels_label(*(new QLabel)),
+      scheduled_ahead_label(*(new QLabel)),
+      late_periods_label(*(new QLabel)),
+      piano_roll_rebuild_label(*(new QLabel)),
+      piano_roll_paint_label(*(new QLabel)),
+      performance_form(*(new QFormLayout(this))),
+      refresh_timer(*(new QTimer(this))) {
+  static const auto REFRESH_MILLISECONDS = 250;
+
+  performance_form.addRow(PerformanceWidget::tr("Synth CPU load:"),
+                          &cpu_load_label);
+  performance_form.addRow(PerformanceWidget::tr("Active voices:"),
+                          &active_voices_label);
+  performance_form.addRow(PerformanceWidget::tr("Busy channels:"),
+                          &busy_channels_label);
+  performance_form.addRow(PerformanceWidget::tr("Scheduled ahead:"),
+                          &scheduled_ahead_label);
+  performance_form.addRow(PerformanceWidget::tr("Late audio periods:"),
+                          &late_periods_label);
+  performance_form.addRow(PerformanceWidget::tr("Piano roll rebuild:"),
+                          &piano_roll_rebuild_label);
+  performance_form.addRow(PerformanceWidget::tr("Piano roll paint:"),
+                          &piano_roll_paint_label);
+
+  refresh_timer.setInterval(REFRESH_MILLISECONDS);
+  QObject::connect(&refresh_timer, &QTimer::timeout, this,
+                   [this]() -> auto { update_performance_widget(*this); });
+}
+
+void PerformanceWidget::showEvent(QShowEvent* const show_event_pointer) {
+  update_performance_widget(*this);
+  refresh_timer.start();
+  QWidget::showEvent(show_event_pointer);
+}
+
+void PerformanceWidget::hideEvent(QHideEvent* const hide_event_pointer) {
+  refresh_timer.stop();
+  QWidget::hideEvent(hide_event_pointer);
+}
+
+void update_performance_widget(PerformanceWidget& performance_widget) {
+  const auto& player = performance_widget.player;
+
+  // each synth's load is a share of real time, so together they add up
+  auto cpu_load = fluid_synth_get_cpu_load(player.synth.internal_pointer);
+  auto active_voices =
+      fluid_synth_get_active_voice_count(player.synth.internal_pointer);
+  const auto number_of_pooled_synths = player.number_of_pooled_synths.load();
+  for (auto synth_number = 0; synth_number < number_of_pooled_synths;
+       synth_number = synth_number + 1) {
+    auto* const synth_pointer =
+        get_reference(player.pooled_synths.at(synth_number).get())
+            .synth.internal_pointer;
+    cpu_load = cpu_load + fluid_synth_get_cpu_load(synth_pointer);
+    active_voices =
+        active_voices + fluid_synth_get_active_voice_count(synth_pointer);
+  }
+
+  // fluidsynth doesn't say how many events its sequencer has queued, so
+  // this shows how far ahead of the sequencer's clock they reach instead
+  const auto current_tick = static_cast<double>(
+      fluid_sequencer_get_tick(player.sequencer.internal_pointer));
+  const auto& channel_schedules = player.channel_schedules;
+  const auto busy_channels = std::ranges::count_if(
+      channel_schedules, [current_tick](const double schedule) -> auto {
+        return schedule > current_tick;
+      });
+
+  const auto& piano_roll_scene = performance_widget.piano_roll_scene;
+
+  performance_widget.cpu_load_label.setText(
+      PerformanceWidget::tr("%1%").arg(cpu_load, 0, 'f', 1));
+  performance_widget.active_voices_label.setText(
+      QString::number(active_voices));
+  performance_widget.busy_channels_label.setText(
+      PerformanceWidget::tr("%1 of %2")
+          .arg(busy_channels)
+          .arg(channel_schedules.size()));
+  performance_widget.scheduled_ahead_label.setText(get_milliseconds_text(
+      std::max(0.0, player.final_time - current_tick)));
+  performance_widget.late_periods_label.setText(
+      QString::number(player.number_of_late_periods.load()));
+  performance_widget.piano_roll_rebuild_label.setText(
+      get_milliseconds_text(piano_roll_scene.rebuild_milliseconds));
+  performance_widget.piano_roll_paint_label.setText(
+      get_milliseconds_text(piano_roll_scene.paint_milliseconds));
+}
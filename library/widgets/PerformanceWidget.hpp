@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QtWidgets/QWidget>
+
+class QFormLayout;
+class QLabel;
+class QTimer;
+struct PianoRollNotesScene;
+struct Player;
+
+// a live readout of how hard the synths and the piano roll are working, to
+// find out why a dense passage glitches on a given machine. Only refreshes
+// while shown
+struct PerformanceWidget : public QWidget {
+  const Player& player;
+  const PianoRollNotesScene& piano_roll_scene;
+
+  QLabel& cpu_load_label;
+  QLabel& active_voices_label;
+  QLabel& busy_channels_label;
+  QLabel& scheduled_ahead_label;
+  QLabel& late_periods_label;
+  QLabel& piano_roll_rebuild_label;
+  QLabel& piano_roll_paint_label;
+  QFormLayout& performance_form;
+
+  QTimer& refresh_timer;
+
+  PerformanceWidget(const Player& player_input,
+                    const PianoRollNotesScene& piano_roll_scene_input);
+
+  void showEvent(QShowEvent* show_event_pointer) override;
+  void hideEvent(QHideEvent* hide_event_pointer) override;
+};
+
+void update_performance_widget(PerformanceWidget& performance_widget);
@@ -1,16 +1,22 @@
 #include "widgets/SongEditor.hpp"
 
+#include <fluidsynth.h>
+
 #include <QtCore/QTimer>
 #include <QtGui/QCloseEvent>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QDockWidget>
 #include <QtWidgets/QGraphicsItem>
 #include <QtWidgets/QGraphicsView>
+#include <QtWidgets/QMessageBox>
 #include <QtWidgets/QStatusBar>
 
+#include "actions/ChangeId.hpp"
 #include "actions/ReplaceTable.hpp"
 #include "column_numbers/ChordColumn.hpp"
 #include "menus/SongMenuBar.hpp"
+#include "other/MemoryUsage.hpp"
+#include "widgets/PerformanceWidget.hpp"
 #include "widgets/SpinBoxes.hpp"
 #include "widgets/piano_roll/PianoRollNotesScene.hpp"
 #include "widgets/piano_roll/PianoRollWidget.hpp"
@@ -56,6 +62,8 @@ void connect_navigate_chord_action(QAction& action, QObject& context,
 }
 
 void rebuild_piano_roll_scene(PianoRollWidget& widget) {
+  // anything still waiting to settle is covered by this
+  widget.rebuild_timer.stop();
   rebuild_scene(
       widget, widget.song_widget, widget.piano_roll_scene, widget.axis_scene,
       widget.legend_scene, widget.row_layout, widget.selection_row_type,
@@ -63,6 +71,88 @@ void rebuild_piano_roll_scene(PianoRollWidget& widget) {
       widget.selection_number_of_rows, widget.selecting_chord_from_playhead);
 }
 
+// the command behind a QUndoStack::indexChanged: one just pushed, merged
+// into or redone sits just below the new index, and one just undone sits at
+// it. nullptr for anything else, e.g. the stack being cleared
+auto get_changed_command(const QUndoStack& undo_stack, const int old_index,
+                         const int new_index) -> const QUndoCommand* {
+  if (new_index == old_index || new_index == old_index + 1) {
+    return new_index > 0 ? undo_stack.command(new_index - 1) : nullptr;
+  }
+  if (new_index == old_index - 1) {
+    return undo_stack.command(new_index);
+  }
+  return nullptr;
+}
+
+// a starting tempo or key change moves every note the same way, so the
+// piano roll can preview it without a full rebuild (see
+// preview_starting_change)
+auto is_starting_change(const QUndoCommand* const command_pointer) -> bool {
+  if (command_pointer == nullptr) {
+    return false;
+  }
+  const auto command_id = command_pointer->id();
+  return command_id == static_cast<int>(ChangeId::starting_tempo_id) ||
+         command_id == static_cast<int>(ChangeId::starting_key_id);
+}
+
+void refresh_piano_roll_scene(PianoRollWidget& widget, const int new_index) {
+  const auto* const command_pointer = get_changed_command(
+      widget.song_widget.undo_stack, widget.undo_index, new_index);
+  widget.undo_index = new_index;
+  if (is_starting_change(command_pointer)) {
+    preview_starting_change(widget.piano_roll_scene, widget.song_widget.song);
+    widget.rebuild_timer.start();
+    return;
+  }
+  rebuild_piano_roll_scene(widget);
+}
+
+// counts the song first, so undo commands only count what they don't share
+// with it. Each command gets a line of the details
+void show_memory_report(SongEditor& song_editor) {
+  const auto& song_widget = song_editor.song_widget;
+  MemoryCounter counter;
+  auto entries = get_song_memory_entries(counter, song_widget.song);
+
+  const auto undo_entries =
+      get_undo_memory_entries(counter, song_widget.undo_stack);
+  auto undo_bytes = qsizetype{0};
+  for (const auto& undo_entry : undo_entries) {
+    undo_bytes = undo_bytes + undo_entry.bytes;
+  }
+  entries.push_back(
+      {.name = SongEditor::tr("Undo stack (%1 commands)")
+                   .arg(undo_entries.size()),
+       .bytes = undo_bytes});
+
+  entries.push_back(
+      {.name = SongEditor::tr("Piano roll"),
+       .bytes = count_piano_roll_scene_bytes(
+           counter, song_editor.piano_roll_widget.piano_roll_scene)});
+
+  // the primary synth, each pooled synth and the pre-renderer, once it's
+  // been used, load their own
+  const auto& player = song_widget.player;
+  const auto number_of_soundfonts =
+      player.number_of_pooled_synths.load() + 1 +
+      (player.pre_renderer.synth_loaded.load() ? 1 : 0);
+  entries.push_back(
+      {.name = SongEditor::tr("Soundfont (%1 copies, at least)")
+                   .arg(number_of_soundfonts),
+       .bytes = number_of_soundfonts * get_soundfont_file_bytes()});
+
+  QMessageBox message_box(QMessageBox::Information,
+                          SongEditor::tr("Memory report"),
+                          get_memory_report_text(entries), QMessageBox::Ok,
+                          &song_editor);
+  if (!undo_entries.empty()) {
+    message_box.setDetailedText(get_memory_report_text(undo_entries));
+  }
+  message_box.exec();
+}
+
 }  // namespace
 
 void song_reloaded(SongMenuBar& song_menu_bar, SongWidget& song_widget,
@@ -80,11 +170,10 @@ void open_file_and_reload(SongMenuBar& song_menu_bar, SongWidget& song_widget,
   }
 }
 
-void import_musicxml_and_reload(SongMenuBar& song_menu_bar,
-                                SongWidget& song_widget,
-                                PianoRollWidget& piano_roll_widget,
-                                const QString& filename) {
-  if (import_musicxml(song_widget, filename)) {
+void finish_import_and_reload(SongMenuBar& song_menu_bar,
+                              SongWidget& song_widget,
+                              PianoRollWidget& piano_roll_widget) {
+  if (finish_import(song_widget)) {
     song_reloaded(song_menu_bar, song_widget, piano_roll_widget);
   }
 }
@@ -107,7 +196,10 @@ void stop_piano_roll_playhead(PianoRollWidget& widget) {
 
 void start_piano_roll_playhead(PianoRollWidget& widget,
                                const double baseline_ms, const double end_ms) {
-  static const auto PIANO_ROLL_TIMER_INTERVAL_MS = 33;
+  // about one frame on a 60 Hz display -- a tick where the playhead
+  // wouldn't move a whole pixel costs next to nothing (see
+  // update_playhead_position())
+  static const auto PIANO_ROLL_TIMER_INTERVAL_MS = 16;
 
   set_manual_scrolling_enabled(widget.piano_roll_scene, widget.axis_scene,
                                false);
@@ -117,6 +209,17 @@ void start_piano_roll_playhead(PianoRollWidget& widget,
   piano_roll_scene.playhead_end_ms = end_ms;
   piano_roll_scene.playhead_elapsed_timer.restart();
   piano_roll_scene.playhead_active = true;
+
+  // the Play action has just scheduled the selection to start at the
+  // sequencer's current tick (see initialize_play())
+  const auto& player = widget.song_widget.player;
+  const auto current_tick =
+      fluid_sequencer_get_tick(player.sequencer.internal_pointer);
+  piano_roll_scene.playhead_start_tick = current_tick;
+  piano_roll_scene.playhead_last_tick = current_tick;
+  piano_roll_scene.playhead_tick_timer.restart();
+  piano_roll_scene.playhead_latency_ms = get_output_latency(player);
+  piano_roll_scene.playhead_period_ms = get_period_duration(player);
   piano_roll_scene.playhead_item.show();
 
   // decides which transition position_playhead() should run, based on
@@ -145,7 +248,11 @@ SongEditor::SongEditor()
     : song_widget(*(new SongWidget)),
       song_menu_bar(*(new SongMenuBar(song_widget))),
       piano_roll_widget(*(new PianoRollWidget(song_widget))),
-      piano_roll_dock(*(new QDockWidget(SongEditor::tr("Piano Roll"), this))) {
+      piano_roll_dock(*(new QDockWidget(SongEditor::tr("Piano Roll"), this))),
+      performance_widget(*(new PerformanceWidget(
+          song_widget.player, piano_roll_widget.piano_roll_scene))),
+      performance_dock(
+          *(new QDockWidget(SongEditor::tr("Performance"), this))) {
   setWindowIcon(QIcon(QString::fromStdString(get_share_file("Justly.svg"))));
 
   auto& song_menu_bar_ref = this->song_menu_bar;
@@ -214,6 +321,21 @@ SongEditor::SongEditor()
   QObject::connect(&piano_roll_dock, &QDockWidget::visibilityChanged,
                    &show_piano_roll_action, &QAction::setChecked);
 
+  performance_dock.setWidget(&performance_widget);
+  addDockWidget(Qt::RightDockWidgetArea, &performance_dock);
+  performance_dock.setVisible(false);
+
+  auto& show_performance_action =
+      song_menu_bar.view_menu.show_performance_action;
+  QObject::connect(&show_performance_action, &QAction::toggled,
+                   &performance_dock, &QDockWidget::setVisible);
+  QObject::connect(&performance_dock, &QDockWidget::visibilityChanged,
+                   &show_performance_action, &QAction::setChecked);
+
+  QObject::connect(&song_menu_bar.view_menu.memory_report_action,
+                   &QAction::triggered, this,
+                   [this]() -> auto { show_memory_report(*this); });
+
   QObject::connect(&song_menu_bar.view_menu.zoom_in_action, &QAction::triggered,
                    &piano_roll_widget_ref, [&piano_roll_widget_ref]() -> auto {
                      zoom_in_piano_roll(piano_roll_widget_ref);
@@ -225,8 +347,9 @@ SongEditor::SongEditor()
                    });
 
   QObject::connect(&undo_stack, &QUndoStack::indexChanged, this,
-                   [&piano_roll_widget_ref]() -> auto {
-                     rebuild_piano_roll_scene(piano_roll_widget_ref);
+                   [&piano_roll_widget_ref](const int new_index) -> auto {
+                     refresh_piano_roll_scene(piano_roll_widget_ref,
+                                              new_index);
                    });
 
   connect_recovery_timer(song_widget);
@@ -255,13 +378,23 @@ SongEditor::SongEditor()
               "MusicXML file (*.musicxml *.mxl)", QFileDialog::AcceptOpen,
               ".musicxml", QFileDialog::ExistingFile);
           if (dialog.exec() != 0) {
-            import_musicxml_and_reload(
-                song_menu_bar_ref, song_widget_ref, piano_roll_widget_ref,
-                get_selected_file(song_widget_ref, dialog));
+            import_musicxml(song_widget_ref,
+                            get_selected_file(song_widget_ref, dialog));
           }
           dialog.deleteLater();
         }
       });
+  QObject::connect(
+      &song_widget.import_timer, &QTimer::timeout, this,
+      [&song_menu_bar_ref, &song_widget_ref, &piano_roll_widget_ref]() -> auto {
+        if (get_reference(song_widget_ref.musicxml_importer_pointer.get())
+                .finished.load()) {
+          finish_import_and_reload(song_menu_bar_ref, song_widget_ref,
+                                   piano_roll_widget_ref);
+          return;
+        }
+        update_import_progress(song_widget_ref);
+      });
 
   // double-clicking a note in the piano roll opens the pitched/unpitched
   // notes table for its chord, scrolled to and highlighting that note --
@@ -280,7 +413,7 @@ SongEditor::SongEditor()
   // wires the piano roll's playhead animation to the existing Play/Stop
   // actions, since playback itself remains fire-and-forget (no
   // pause/resume, no "now playing" callback from FluidSynth) — the
-  // playhead is driven purely by wall-clock elapsed time against the same
+  // playhead follows the sequencer's own clock against the same
   // precomputed schedule bounds.
   auto& play_menu = song_menu_bar.play_menu;
   QObject::connect(
@@ -308,6 +441,27 @@ SongEditor::SongEditor()
                                      RowType::pitched_note_type));
         start_piano_roll_playhead(piano_roll_widget_ref, baseline_ms, end_ms);
       });
+  // a preview only reaches the synth a moment after it's played, on the
+  // audition thread, so its latency shows once that thread has measured it.
+  // Queued on song_widget, which outlives the thread, since song_widget's
+  // player stops the thread as it's destroyed
+  set_dispatch_callback(
+      song_widget.player.auditioner, [this, &song_widget_ref]() -> auto {
+        QMetaObject::invokeMethod(
+            &song_widget_ref,
+            [this, &song_widget_ref]() -> auto {
+              static const auto LATENCY_MESSAGE_MILLISECONDS = 3000;
+              get_reference(statusBar())
+                  .showMessage(
+                      SongEditor::tr("Audition latency: ") +
+                          QString::number(
+                              get_audition_latency(song_widget_ref.player),
+                              'f', 1) +
+                          SongEditor::tr(" ms"),
+                      LATENCY_MESSAGE_MILLISECONDS);
+            },
+            Qt::QueuedConnection);
+      });
   QObject::connect(
       &play_menu.play_to_end_action, &QAction::triggered, this,
       [&piano_roll_widget_ref, &song_widget_ref]() -> auto {
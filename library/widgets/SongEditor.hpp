@@ -2,11 +2,12 @@
 
 #include <QtWidgets/QMainWindow>
 
+struct PerformanceWidget;
 struct PianoRollWidget;
 struct SongMenuBar;
 struct SongWidget;
 
-// open_file/import_musicxml replace the song wholesale, bypassing the undo
+// open_file/finish_import replace the song wholesale, bypassing the undo
 // stack, so the usual indexChanged-driven refresh never fires for them --
 // call this afterward. They also always land back on the chords view (see
 // reset_switch_table_to_chords), so reuse replace_table to redo the same
@@ -20,10 +21,11 @@ void open_file_and_reload(SongMenuBar& song_menu_bar, SongWidget& song_widget,
                           PianoRollWidget& piano_roll_widget,
                           const QString& filename);
 
-void import_musicxml_and_reload(SongMenuBar& song_menu_bar,
-                                SongWidget& song_widget,
-                                PianoRollWidget& piano_roll_widget,
-                                const QString& filename);
+// see finish_import; SongEditor's import_timer connection calls this once a
+// background import (see import_musicxml) is done
+void finish_import_and_reload(SongMenuBar& song_menu_bar,
+                              SongWidget& song_widget,
+                              PianoRollWidget& piano_roll_widget);
 
 void zoom_in_piano_roll(PianoRollWidget& widget);
 
@@ -40,6 +42,8 @@ struct SongEditor : public QMainWindow {
   SongMenuBar& song_menu_bar;
   PianoRollWidget& piano_roll_widget;
   QDockWidget& piano_roll_dock;
+  PerformanceWidget& performance_widget;
+  QDockWidget& performance_dock;
 
   explicit SongEditor();
 
@@ -3,22 +3,22 @@
 #include <QtCore/QModelIndex>
 #include <QtGui/QUndoStack>
 
+#include "musicxml/MusicXMLImport.hpp"
+#include "musicxml/MusicXMLImporter.hpp"
 #include "other/Song.hpp"
 #include "rows/Note.hpp"
+#include "sound/OfflineSynth.hpp"
+#include "sound/PlaybackPlan.hpp"
 #include "sound/Player.hpp"
+#include "sound/RecordingExport.hpp"
 
 template <RowInterface SubRow>
 struct RowsModel;
-class XMLDocument;
-struct MeasureRepeatInfo;
-struct TimeIterator;
-struct XMLValidator;
 class QBoxLayout;
+class QProgressDialog;
 struct ControlsColumn;
 struct SwitchColumn;
 
-[[nodiscard]] auto get_property(xmlNode& node, const char* name) -> std::string;
-
 struct SongWidget : public QWidget {
   Song song;
   Player player;
@@ -26,11 +26,33 @@ struct SongWidget : public QWidget {
   QString current_file;
   QString current_folder;
 
+  // bumped on every change to song, so playback_plan knows when it's stale
+  int song_revision = 0;
+  // compiled on demand; see get_playback_plan
+  PlaybackPlan playback_plan;
+  // likewise, see get_song_snapshot
+  std::shared_ptr<const Song> song_snapshot_pointer;
+  int song_snapshot_revision = -1;
+
   // debounced autosave for crash recovery -- restarted on every undo_stack
   // change and wired up by connect_recovery_timer once save_as_file and
   // friends are defined later in this header (see comment there)
   QTimer& recovery_timer;
 
+  // the recording being exported in the background, if any (see
+  // export_to_file), and the dialog showing how far along it is
+  std::unique_ptr<RecordingExport> recording_export_pointer;
+  QProgressDialog* export_dialog_pointer = nullptr;
+  // polls recording_export_pointer while it renders
+  QTimer& export_timer;
+
+  // likewise for the MusicXML file being read in the background, if any (see
+  // import_musicxml); SongEditor connects import_timer, since loading the
+  // result means reloading the whole editor
+  std::unique_ptr<MusicXMLImporter> musicxml_importer_pointer;
+  QProgressDialog* import_dialog_pointer = nullptr;
+  QTimer& import_timer;
+
   SwitchColumn& switch_column;
   ControlsColumn& controls_column;
   QBoxLayout& row_layout;
@@ -44,22 +66,56 @@ struct SongWidget : public QWidget {
 
 [[nodiscard]] auto get_next_row(const SongWidget& song_widget) -> int;
 
+// every undo_stack change already counts; this is for the few changes to
+// song that bypass it (e.g. opening a file), which would otherwise leave
+// playback_plan stale
+void mark_song_changed(SongWidget& song_widget);
+
+// recompiles song_widget.playback_plan first if the song has changed since
+// it was last compiled
+[[nodiscard]] auto get_playback_plan(SongWidget& song_widget)
+    -> const PlaybackPlan&;
+
+// song as of the latest revision (see make_song_snapshot), for work on
+// another thread. Taken at most once per revision, so every reader of a
+// revision shares the one copy
+[[nodiscard]] auto get_song_snapshot(SongWidget& song_widget)
+    -> std::shared_ptr<const Song>;
+
 void initialize_play(SongWidget& song_widget);
 
-// pitched notes always pick from the shared least-recently-free pool, since
-// each one may need its own pitch bend and must wait out the previous
-// occupant's release before reusing its channel. Percussion programs instead
-// get a single channel permanently reserved on first use (see
-// Player::percussion_channels) -- nullopt means every channel is claimed and
-// the caller should warn and abort, matching channel_is_free's contract
-[[nodiscard]] auto get_channel_number(QWidget& parent, Player& player,
-                                      const Program& program,
-                                      double current_time)
-    -> std::optional<int>;
-
-void play_note(Player& player, int channel_number, const Program& program,
-               short midi_number, short velocity, double current_time,
-               double end_time);
+// where a note sounds: a channel, and the key on it that gets the note-on
+struct NoteSlot {
+  int channel_number = 0;
+  short key = 0;
+};
+
+// pitched notes normally pick from the shared least-recently-free pool,
+// since each one may need its own pitch bend and must wait out the previous
+// occupant's release before reusing its channel; with
+// Player::use_key_tuning, they instead share a channel with other notes of
+// their program, each on its own retuned key. Percussion programs get a
+// single channel permanently reserved on first use (see
+// Player::percussion_channels). When every channel is taken, another pooled
+// synth is brought in (see add_pooled_channels) -- nullopt means even the
+// pool is exhausted; the user has already been warned, so the caller should
+// just abort
+[[nodiscard]] auto get_note_slot(QWidget& parent, Player& player,
+                                 const Program& program, double midi_number,
+                                 short velocity, double current_time)
+    -> std::optional<NoteSlot>;
+
+void play_note(Player& player, const NoteSlot& note_slot,
+               const Program& program, double midi_number, short velocity,
+               double current_time, double end_time);
+
+// previews a note straight on the primary synth (see Auditioner), rather than
+// scheduling it on the sequencer like play_note. Previews always pitch bend,
+// whatever Player::use_key_tuning says, since they're over before a shared
+// channel would save anything
+void audition_note(Player& player, int channel_number, const Program& program,
+                   double midi_number, short velocity,
+                   double duration_milliseconds);
 
 template <VoiceInterface SubVoice>
 [[nodiscard]] static auto play_voices(Player& player,
@@ -70,24 +126,14 @@ template <VoiceInterface SubVoice>
 
   auto& parent = player.parent;
 
-  const auto current_time = player.play_state.current_time;
   const auto current_velocity = player.play_state.current_velocity;
 
-  const auto& programs = get_some_programs(SubVoice::is_pitched());
-
   for (auto voice_number = first_voice_number;
        voice_number < first_voice_number + number_of_voices;
        voice_number = voice_number + 1) {
     const auto& voice = voices.at(voice_number);
 
-    const auto& program = get_voice_program(programs, voices, voice_number);
-
-    const auto maybe_channel_number =
-        get_channel_number(parent, player, program, current_time);
-    if (!maybe_channel_number.has_value()) {
-      return false;
-    }
-    const auto channel_number = *maybe_channel_number;
+    const auto& program = get_voice_program(voices, voice_number);
 
     const auto midi_number = voice.get_preview_midi_number();
 
@@ -104,93 +150,87 @@ template <VoiceInterface SubVoice>
       return false;
     }
 
-    play_note(player, channel_number, program, midi_number, velocity,
-              current_time, current_time + VOICE_PREVIEW_MILLISECONDS);
+    audition_note(player,
+                  (voice_number - first_voice_number) % NUMBER_OF_MIDI_CHANNELS,
+                  program, midi_number, velocity, VOICE_PREVIEW_MILLISECONDS);
   }
   return true;
 }
 
-template <NoteInterface SubNote>
-[[nodiscard]] static auto play_notes(
-    Player& player, const QList<PitchedVoice>& pitched_voices,
-    const QList<UnpitchedVoice>& unpitched_voices, const int chord_number,
-    const QList<SubNote>& sub_notes, const int first_note_number,
-    const int number_of_notes) {
-  auto& parent = player.parent;
-
-  const auto current_time = player.play_state.current_time;
-  const auto current_velocity = player.play_state.current_velocity;
-  const auto current_tempo = player.play_state.current_tempo;
-
-  for (auto note_number = first_note_number;
-       note_number < first_note_number + number_of_notes;
-       note_number = note_number + 1) {
-    const auto& sub_note = sub_notes.at(note_number);
+// plays the given notes from a playback plan, with time_offset added to
+// their start and end times to land them on the sequencer's clock
+[[nodiscard]] auto play_planned_notes(
+    Player& player, std::span<const PlannedNote> planned_notes,
+    double time_offset) -> bool;
 
-    const auto& program =
-        sub_note.get_program(pitched_voices, unpitched_voices);
-
-    const auto maybe_channel_number =
-        get_channel_number(parent, player, program, current_time);
-    if (!maybe_channel_number.has_value()) {
-      return false;
-    }
-    const auto channel_number = *maybe_channel_number;
-
-    const auto maybe_midi_number =
-        sub_note.get_closest_midi(parent, player, unpitched_voices,
-                                  channel_number, chord_number, note_number);
-    if (!maybe_midi_number.has_value()) {
-      return false;
-    }
-    const auto midi_number = *maybe_midi_number;
-
-    const auto& voice_velocity_ratio =
-        sub_note.get_voice_velocity_ratio(pitched_voices, unpitched_voices);
-    const auto velocity = static_cast<short>(std::round(
-        current_velocity * rational_to_double(sub_note.velocity_ratio) *
-        rational_to_double(voice_velocity_ratio)));
-    if (velocity > MAX_VELOCITY) {
-      QString message;
-      QTextStream stream(&message);
-      stream << QObject::tr("Velocity ") << velocity << QObject::tr(" exceeds ")
-             << MAX_VELOCITY;
-      add_note_location<SubNote>(stream, chord_number, note_number);
-      QMessageBox::warning(&parent, QObject::tr("Velocity error"), message);
-      return false;
-    }
+void update_final_time(Player& player, double new_final_time);
 
-    const auto end_time =
-        current_time + get_duration_in_milliseconds(
-                           current_tempo, rational_to_double(sub_note.beats));
+// plays the chords as written, once each, whatever repeats they're in.
+// Returns false, having already warned the user, if one of them can't be
+// played
+[[nodiscard]] auto play_chords(SongWidget& song_widget, int first_chord_number,
+                               int number_of_chords, int wait_frames = 0)
+    -> bool;
 
-    play_note(player, channel_number, program, midi_number, velocity,
-              current_time, end_time);
-  }
-  return true;
-}
+// plays from the first time first_chord_number plays to the end of the
+// song, through any repeats along the way (see PlaybackPlan::passes)
+void play_chords_to_end(SongWidget& song_widget, int first_chord_number);
+
+// previews one of a chord's notes (see audition_note)
+[[nodiscard]] auto audition_chord_note(SongWidget& song_widget,
+                                       int chord_number, bool is_pitched,
+                                       int note_number) -> bool;
+
+// plays some of one chord's pitched or unpitched notes, starting at the
+// player's current time, then moves the current time on to the next chord,
+// like play_chords does
+[[nodiscard]] auto play_chord_notes(SongWidget& song_widget, int chord_number,
+                                    bool is_pitched, int first_note_number,
+                                    int number_of_notes) -> bool;
+
+// asks for some of a playback plan's notes to be rendered ahead of time (see
+// PreRenderer), starting from start_time in the plan, and returns the number
+// to claim the render with -- or 0 if one of the notes can't be played,
+// which is left for live playback to complain about
+[[nodiscard]] auto request_pre_render(
+    Player& player, std::span<const PlannedNote> planned_notes,
+    double start_time) -> int;
+
+// starts playing a finished pre-render, or returns false if it isn't ready
+// yet. Like play_chords, moves the player's current time on by duration,
+// how long the selection takes to play live
+[[nodiscard]] auto play_pre_rendered(Player& player, int request_number,
+                                     double duration) -> bool;
 
-template <NoteInterface SubNote>
-[[nodiscard]] static auto play_all_notes(
-    Player& player, const QList<PitchedVoice>& pitched_voices,
-    const QList<UnpitchedVoice>& unpitched_voices, const int chord_number,
-    const QList<SubNote>& sub_notes) -> bool {
-  return play_notes(player, pitched_voices, unpitched_voices, chord_number,
-                    sub_notes, 0, static_cast<int>(sub_notes.size()));
-}
+[[nodiscard]] auto can_discard_changes(SongWidget& song_widget) -> bool;
 
-void update_final_time(Player& player, double new_final_time);
+[[nodiscard]] auto get_gain(const SongWidget& song_widget) -> double;
 
-void play_chords(SongWidget& song_widget, int first_chord_number,
-                 int number_of_chords, int wait_frames = 0);
+// app settings for recordings; see FileMenu
+static const auto EXPORT_SAMPLE_FORMAT_KEY = "export/sample_format";
+static const auto EXPORT_SAMPLE_RATE_KEY = "export/sample_rate";
 
-[[nodiscard]] auto can_discard_changes(SongWidget& song_widget) -> bool;
+// the file type comes from output_file's extension, and the sample format
+// from the export/sample_format setting
+[[nodiscard]] auto get_export_file_format(const QString& output_file)
+    -> AudioFileFormat;
 
-[[nodiscard]] auto get_gain(const SongWidget& song_widget) -> double;
+// the export/sample_rate setting, within fluidsynth's limits
+[[nodiscard]] auto get_export_sample_rate() -> double;
 
+// starts rendering the song to output_file, in the format the settings above
+// ask for, on a thread of its own (see RecordingExport), with a dialog to
+// follow or cancel it. Only one recording exports at a time
 void export_to_file(SongWidget& song_widget, const QString& output_file);
 
-void export_midi_to_file(SongWidget& song_widget, const QString& output_file);
+// waits for the current export, if any, to finish, then closes its dialog
+// and warns about anything that went wrong. export_timer calls this as soon
+// as an export is finished; cancelled exports leave no file behind
+void finish_export(SongWidget& song_widget);
+
+// see get_song_midi_bytes
+void export_midi_to_file(SongWidget& song_widget, const QString& output_file,
+                         bool use_tuning_messages = false);
 
 // recovery.xml's presence means the app didn't reach a clean shutdown last
 // time (see connect_recovery_timer and SongEditor::closeEvent); its content
@@ -203,11 +243,6 @@ void write_recovery_file(SongWidget& song_widget);
 
 void save_as_file(SongWidget& song_widget, const QString& filename);
 
-// some musicxml fields (e.g. fifths, octave-change, repeat times) are
-// unbounded xs:integer with no schema-enforced range, so a malformed or
-// hostile file can contain a magnitude that overflows int; used by
-// import_musicxml to reject such a file with a warning instead of letting
-// string_to_int assert
 template <RowInterface SubRow>
 static void clear_rows(RowsModel<SubRow>& rows_model) {
   const auto number_of_rows = rows_model.rowCount(QModelIndex());
@@ -216,51 +251,16 @@ static void clear_rows(RowsModel<SubRow>& rows_model) {
   }
 }
 
-[[nodiscard]] auto validate_against_schema(XMLValidator& validator,
-                                           XMLDocument& document) -> int;
-
-template <VoiceInterface SubVoice>
-[[nodiscard]] static auto check_duplicate_or_empty_voice_names(
-    QWidget& parent, const QList<SubVoice>& voices) -> bool {
-  if (std::ranges::any_of(voices, [](const SubVoice& voice) -> auto {
-        return voice.name.isEmpty();
-      })) {
-    QMessageBox::warning(&parent, QObject::tr("Voice name error"),
-                         QObject::tr("Voice name is empty!"));
-    return false;
-  }
-  QSet<QString> seen_names;
-  for (const auto& voice : voices) {
-    if (seen_names.contains(voice.name)) {
-      QString message;
-      QTextStream stream(&message);
-      stream << QObject::tr("Duplicate voice name \"") << voice.name
-             << QObject::tr("\"!");
-      QMessageBox::warning(&parent, QObject::tr("Voice name error"), message);
-      return false;
-    }
-    seen_names.insert(voice.name);
-  }
-  return true;
-}
-
 template <NoteInterface SubNote>
 [[nodiscard]] static auto check_note_voices(QWidget& parent,
                                             const QList<SubNote>& notes,
                                             const int number_of_voices,
                                             const int chord_number) -> bool {
-  for (auto note_number = 0; note_number < notes.size();
-       note_number = note_number + 1) {
-    const auto voice_number = notes.at(note_number).voice_number;
-    if (voice_number < 0 || voice_number >= number_of_voices) {
-      QString message;
-      QTextStream stream(&message);
-      stream << QObject::tr("Voice ") << voice_number;
-      add_note_location<SubNote>(stream, chord_number, note_number);
-      stream << QObject::tr(" has no corresponding voice");
-      QMessageBox::warning(&parent, QObject::tr("Voice number error"), message);
-      return false;
-    }
+  const auto maybe_warning =
+      get_note_voices_warning(notes, number_of_voices, chord_number);
+  if (maybe_warning.has_value()) {
+    show_warning(parent, *maybe_warning);
+    return false;
   }
   return true;
 }
@@ -276,55 +276,17 @@ template <NoteInterface SubNote>
 
 void connect_recovery_timer(SongWidget& song_widget);
 
-void reset(TimeIterator& iterator);
-
-// turns a linear list of measures (each optionally tagged with a
-// forward/backward repeat and/or first-/second-ending numbers) into an
-// ordered list of (start_time, end_time) spans describing the actual
-// playback order, unrolling repeated sections and picking the ending that
-// belongs to each pass
-[[nodiscard]] auto compute_measure_expansion(
-    const QList<MeasureRepeatInfo>& measure_infos)
-    -> QList<std::pair<int, int>>;
-
-// replays a raw per-part dict (keyed by the original, un-repeated division
-// time) onto the unrolled timeline described by an expansion computed by
-// compute_measure_expansion
-template <typename Value>
-[[nodiscard]] static auto remap_by_expansion(
-    const QMap<int, Value>& raw_dict,
-    const QList<std::pair<int, int>>& expansion) {
-  QMap<int, Value> expanded_dict;
-  auto new_cursor = 0;
-  for (const auto& [raw_start, raw_end] : expansion) {
-    for (auto iterator = raw_dict.lowerBound(raw_start);
-         iterator != raw_dict.end() && iterator.key() < raw_end; ++iterator) {
-      expanded_dict[new_cursor + (iterator.key() - raw_start)] =
-          iterator.value();
-    }
-    new_cursor = new_cursor + (raw_end - raw_start);
-  }
-  return expanded_dict;
-}
+// starts reading filename on a thread of its own (see MusicXMLImporter),
+// with a dialog to follow or cancel it. Only one file imports at a time
+void import_musicxml(SongWidget& song_widget, const QString& filename);
 
-template <VoiceInterface SubVoice>
-static void add_imported_voices(RowsModel<SubVoice>& voices_model,
-                                const QList<QString>& voice_names) {
-  const auto& programs = get_some_programs(SubVoice::is_pitched());
-  for (const auto& voice_name : voice_names) {
-    SubVoice new_voice;
-    new_voice.name = voice_name;
-    const auto matching_program = get_named_index(programs, voice_name);
-    if (matching_program != programs.cend()) {
-      new_voice.program = matching_program->name;
-    }
-    voices_model.insert_row(voices_model.rowCount(QModelIndex()),
-                            std::move(new_voice));
-  }
-}
+// waits for the current import, if any, to finish, then closes its dialog
+// and replaces the song with the imported one all at once, or warns about
+// anything that went wrong. Returns whether the song was replaced
+[[nodiscard]] auto finish_import(SongWidget& song_widget) -> bool;
 
-[[nodiscard]] auto import_musicxml(SongWidget& song_widget,
-                                   const QString& filename) -> bool;
+// the current import's progress, for its dialog
+void update_import_progress(SongWidget& song_widget);
 
 void add_menu_action(
     QMenu& menu, QAction& action,
@@ -9,15 +9,15 @@
 #include "actions/SetDouble.hpp"
 #include "other/Song.hpp"
 #include "rows/Note.hpp"
-#include "sound/FluidSynth.hpp"
+#include "sound/Player.hpp"
 
 namespace {
 
-void add_set_double(QUndoStack& undo_stack, Song& song, FluidSynth& synth,
+void add_set_double(QUndoStack& undo_stack, Song& song, Player& player,
                     QDoubleSpinBox& spin_box, const ChangeId control_id,
                     const double old_value, const double new_value) {
   undo_stack.push(new SetDouble(  // NOLINT(cppcoreguidelines-owning-memory)
-      song, synth, spin_box, control_id, old_value, new_value));
+      song, player, spin_box, control_id, old_value, new_value));
 }
 
 void add_control(QFormLayout& spin_boxes_form, const QString& label,
@@ -41,13 +41,12 @@ void clear_and_clean(QUndoStack& undo_stack) {
   undo_stack.setClean();
 }
 
-SpinBoxes::SpinBoxes(Song& song, FluidSynth& synth, QUndoStack& undo_stack)
+SpinBoxes::SpinBoxes(Song& song, Player& player, QUndoStack& undo_stack)
     : gain_editor(*(new QDoubleSpinBox)),
       starting_key_editor(*(new QDoubleSpinBox)),
       starting_velocity_editor(*(new QDoubleSpinBox)),
       starting_tempo_editor(*(new QDoubleSpinBox)),
       spin_boxes_form(*(new QFormLayout(this))) {
-  static const auto DEFAULT_GAIN = 5;
   static const auto GAIN_STEP = 0.1;
   static const auto MAX_GAIN = 10;
   static const auto MAX_KEY = 999;
@@ -70,30 +69,32 @@ SpinBoxes::SpinBoxes(Song& song, FluidSynth& synth, QUndoStack& undo_stack)
 
   QObject::connect(
       &gain_editor, &QDoubleSpinBox::valueChanged, this,
-      [&undo_stack, &song, &synth, &gain_editor_ref](double new_value) -> auto {
-        add_set_double(undo_stack, song, synth, gain_editor_ref,
+      [&undo_stack, &song, &player,
+       &gain_editor_ref](double new_value) -> auto {
+        add_set_double(undo_stack, song, player, gain_editor_ref,
                        ChangeId::gain_id,
-                       fluid_synth_get_gain(synth.internal_pointer), new_value);
+                       fluid_synth_get_gain(player.synth.internal_pointer),
+                       new_value);
       });
   QObject::connect(
       &starting_key_editor, &QDoubleSpinBox::valueChanged, this,
-      [&undo_stack, &song, &synth,
+      [&undo_stack, &song, &player,
        &starting_key_editor_ref](double new_value) -> auto {
-        add_set_double(undo_stack, song, synth, starting_key_editor_ref,
+        add_set_double(undo_stack, song, player, starting_key_editor_ref,
                        ChangeId::starting_key_id, song.starting_key, new_value);
       });
   QObject::connect(
       &starting_velocity_editor, &QDoubleSpinBox::valueChanged, this,
-      [&undo_stack, &song, &synth,
+      [&undo_stack, &song, &player,
        &starting_velocity_editor_ref](double new_value) -> auto {
-        add_set_double(undo_stack, song, synth, starting_velocity_editor_ref,
+        add_set_double(undo_stack, song, player, starting_velocity_editor_ref,
                        ChangeId::starting_velocity_id, song.starting_velocity,
                        new_value);
       });
   QObject::connect(&starting_tempo_editor, &QDoubleSpinBox::valueChanged, this,
-                   [&undo_stack, &song, &synth,
+                   [&undo_stack, &song, &player,
                     &starting_tempo_editor_ref](double new_value) -> auto {
-                     add_set_double(undo_stack, song, synth,
+                     add_set_double(undo_stack, song, player,
                                     starting_tempo_editor_ref,
                                     ChangeId::starting_tempo_id,
                                     song.starting_tempo, new_value);
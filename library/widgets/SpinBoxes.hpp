@@ -5,7 +5,7 @@
 class QDoubleSpinBox;
 class QFormLayout;
 class QUndoStack;
-struct FluidSynth;
+struct Player;
 struct Song;
 
 void clear_and_clean(QUndoStack& undo_stack);
@@ -17,5 +17,5 @@ struct SpinBoxes : public QWidget {
   QDoubleSpinBox& starting_tempo_editor;
   QFormLayout& spin_boxes_form;
 
-  explicit SpinBoxes(Song& song, FluidSynth& synth, QUndoStack& undo_stack);
+  explicit SpinBoxes(Song& song, Player& player, QUndoStack& undo_stack);
 };
@@ -40,6 +40,10 @@ PianoRollNotesScene::PianoRollNotesScene(QWidget& parent_widget)
   // where the scene has nothing to leak through.
   view.setAlignment(Qt::AlignLeft | Qt::AlignTop);
 
+  // a coarse timer's ticks can land up to 5% late, which shows up as the
+  // playhead stuttering against the sequencer's steady clock
+  playhead_timer.setTimerType(Qt::PreciseTimer);
+
   // cosmetic pens keep their stroke width in device pixels regardless of
   // the view's horizontal zoom transform (see set_notes_view_time_zoom),
   // rather than stretching along with it
@@ -62,3 +66,27 @@ PianoRollNotesScene::PianoRollNotesScene(QWidget& parent_widget)
   selection_rect_item.hide();
   addItem(&selection_rect_item);
 }
+
+void PianoRollNotesScene::drawBackground(QPainter* const painter_pointer,
+                                         const QRectF& rect) {
+  paint_timer.start();
+  QGraphicsScene::drawBackground(painter_pointer, rect);
+}
+
+void PianoRollNotesScene::drawForeground(QPainter* const painter_pointer,
+                                         const QRectF& rect) {
+  QGraphicsScene::drawForeground(painter_pointer, rect);
+  paint_milliseconds = static_cast<double>(paint_timer.nsecsElapsed()) /
+                       NANOSECONDS_PER_MILLISECOND;
+}
+
+auto count_piano_roll_scene_bytes(MemoryCounter& counter,
+                                  const PianoRollNotesScene& piano_roll_scene)
+    -> qsizetype {
+  static const auto GRAPHICS_ITEM_BYTES = 256;
+  return (piano_roll_scene.items().size() * GRAPHICS_ITEM_BYTES) +
+         count_list_bytes(counter, piano_roll_scene.events) +
+         count_list_bytes(counter, piano_roll_scene.note_items) +
+         count_list_bytes(counter, piano_roll_scene.chord_start_times) +
+         count_list_bytes(counter, piano_roll_scene.time_axis_items);
+}
@@ -3,13 +3,16 @@
 #include <QtCore/QElapsedTimer>
 #include <QtWidgets/QGraphicsScene>
 
+#include "other/MemoryUsage.hpp"
 #include "other/PianoRollNoteEvent.hpp"
 #include "widgets/piano_roll/PlayheadTransition.hpp"
 
 static const auto PIANO_ROLL_PIXELS_PER_MS = 0.1;
+static const auto PIANO_ROLL_PIXELS_PER_SEMITONE = 6;
 static const auto PIANO_ROLL_DEFAULT_AXIS_Y = 0.0;
 static const auto PIANO_ROLL_MIN_TIME_ZOOM = 0.25;
 static const auto PIANO_ROLL_MAX_TIME_ZOOM = 8.0;
+static const auto NANOSECONDS_PER_MILLISECOND = 1e6;
 
 // the main scrollable graphics view: the note bars, the pitch/time axes,
 // and the playhead cursor + its playback animation all live here
@@ -28,10 +31,23 @@ struct PianoRollNotesScene : public QGraphicsScene {
   QGraphicsRectItem& selection_rect_item;
 
   QTimer& playhead_timer;
+  // wall-clock time since playback started -- only paces the catching_up
+  // scroll; where the playhead actually is comes from the sequencer's clock
   QElapsedTimer playhead_elapsed_timer;
   double playhead_baseline_ms = 0;
   double playhead_end_ms = 0;
   bool playhead_active = false;
+  // the sequencer's tick when playback started, and how far behind that
+  // clock the speakers are (see get_output_latency)
+  unsigned int playhead_start_tick = 0;
+  double playhead_latency_ms = 0;
+  // the sequencer's tick only moves once per audio period, so between two
+  // steps the playhead coasts on playhead_tick_timer (started whenever
+  // playhead_last_tick changes), for at most one period -- if the audio
+  // stalls, the playhead stalls with it rather than running ahead
+  unsigned int playhead_last_tick = 0;
+  QElapsedTimer playhead_tick_timer;
+  double playhead_period_ms = 0;
 
   PlayheadTransition playhead_transition = PlayheadTransition::none;
   // the view's horizontal center, in scene coordinates, at the moment a
@@ -50,6 +66,20 @@ struct PianoRollNotesScene : public QGraphicsScene {
   // expands/contracts
   double time_zoom_factor = 1.0;
 
+  // the starting tempo and key the note bars were last laid out for (see
+  // PianoRollWidget::rebuild_scene()); scrubbing either one previews the
+  // change by transforming the bars already drawn (see
+  // preview_starting_change()) rather than laying every one out again
+  double built_starting_tempo = 0.0;
+  double built_starting_key = 0.0;
+  // how far a starting tempo change since the last rebuild has stretched the
+  // time axis -- applied on top of time_zoom_factor
+  double tempo_scale = 1.0;
+  // the parent of every pitched note bar (unpitched lanes don't depend on
+  // the key), so a starting key change moves them all with one setY();
+  // recreated, along with the rest of the scene, by every rebuild
+  QGraphicsRectItem* pitched_notes_item_pointer = nullptr;
+
   // the inputs redraw_time_axis_ticks() needs to redraw just the time
   // axis' ticks and labels whenever the zoom changes, without re-running
   // the full PianoRollWidget::rebuild_scene()
@@ -79,9 +109,26 @@ struct PianoRollNotesScene : public QGraphicsScene {
   // song on every playback tick
   QList<double> chord_start_times;
 
+  // how long the last PianoRollWidget::rebuild_scene() and the last paint
+  // took, for the performance dock (see PerformanceWidget). A paint runs
+  // from drawBackground() to drawForeground(), with every item in between
+  double rebuild_milliseconds = 0.0;
+  QElapsedTimer paint_timer;
+  double paint_milliseconds = 0.0;
+
   explicit PianoRollNotesScene(QWidget& parent_widget);
 
   ~PianoRollNotesScene() override = default;
 
+  void drawBackground(QPainter* painter_pointer, const QRectF& rect) override;
+  void drawForeground(QPainter* painter_pointer, const QRectF& rect) override;
+
   NO_MOVE_COPY(PianoRollNotesScene)
 };
+
+// the scene's items and its bookkeeping for them. Qt keeps each item's
+// state in a private object of a size it doesn't give, so that part is a
+// rough allowance per item
+[[nodiscard]] auto count_piano_roll_scene_bytes(
+    MemoryCounter& counter, const PianoRollNotesScene& piano_roll_scene)
+    -> qsizetype;
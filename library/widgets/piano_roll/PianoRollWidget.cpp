@@ -1,5 +1,7 @@
 #include "widgets/piano_roll/PianoRollWidget.hpp"
 
+#include <fluidsynth.h>
+
 #include <QtCore/QEasingCurve>
 #include <QtCore/QTimer>
 #include <QtGui/QWheelEvent>
@@ -8,6 +10,7 @@
 #include <QtWidgets/QGraphicsView>
 #include <QtWidgets/QScrollBar>
 
+#include "other/Trace.hpp"
 #include "widgets/SongWidget.hpp"
 #include "widgets/SwitchColumn.hpp"
 #include "widgets/SwitchTable.hpp"
@@ -21,6 +24,11 @@ const auto PIANO_ROLL_AXIS_X = 0.0;
 const auto PIANO_ROLL_AXIS_LABEL_GAP = 4.0;
 const auto PIANO_ROLL_SCENE_MARGIN = 10.0;
 const auto PIANO_ROLL_MIN_HEIGHT = 300;
+
+void apply_time_scale(PianoRollNotesScene& notes_scene) {
+  notes_scene.view.setTransform(QTransform::fromScale(
+      notes_scene.time_zoom_factor * notes_scene.tempo_scale, 1.0));
+}
 }  // namespace
 
 auto to_scene_x(const PianoRollNotesScene& notes_scene, const double time_ms)
@@ -159,8 +167,7 @@ void set_notes_view_time_zoom(PianoRollNotesScene& notes_scene,
                               const double new_zoom_factor) {
   notes_scene.time_zoom_factor = std::clamp(
       new_zoom_factor, PIANO_ROLL_MIN_TIME_ZOOM, PIANO_ROLL_MAX_TIME_ZOOM);
-  notes_scene.view.setTransform(
-      QTransform::fromScale(notes_scene.time_zoom_factor, 1.0));
+  apply_time_scale(notes_scene);
   // the tick spacing (in ms) that keeps ticks ~evenly spaced on screen
   // depends on the zoom factor, so every zoom change needs a fresh set of
   // ticks/labels -- just the time axis, not a full
@@ -477,6 +484,19 @@ void select_chord_range_at_playhead(SwitchTable& switch_table,
 
 }  // namespace
 
+void preview_starting_change(PianoRollNotesScene& notes_scene,
+                             const Song& song) {
+  // times are in beats at the starting tempo, so they shrink as it grows
+  notes_scene.tempo_scale =
+      notes_scene.built_starting_tempo / song.starting_tempo;
+  apply_time_scale(notes_scene);
+  // higher pitches sit further up, at lower y
+  get_reference(notes_scene.pitched_notes_item_pointer)
+      .setY((frequency_to_midi_number(notes_scene.built_starting_key) -
+             frequency_to_midi_number(song.starting_key)) *
+            PIANO_ROLL_PIXELS_PER_SEMITONE);
+}
+
 void zoom_in(PianoRollNotesScene& piano_roll_scene) {
   set_notes_view_time_zoom(piano_roll_scene, piano_roll_scene.time_zoom_factor *
                                                  PIANO_ROLL_TIME_ZOOM_STEP);
@@ -630,7 +650,9 @@ void rebuild_scene(QWidget& widget, const SongWidget& song_widget,
                    const int selection_first_row_number,
                    const int selection_number_of_rows,
                    const bool selecting_chord_from_playhead) {
-  static const auto PIANO_ROLL_PIXELS_PER_SEMITONE = 6;
+  const TraceSpan trace_span("rebuild_scene");
+  QElapsedTimer rebuild_elapsed_timer;
+  rebuild_elapsed_timer.start();
   // how far below the lowest note the horizontal axis sits -- enough that
   // the lowest note's bar never reads as glued to (or nearly touching) the
   // axis line, without wasting a full octave of empty space underneath it
@@ -666,6 +688,15 @@ void rebuild_scene(QWidget& widget, const SongWidget& song_widget,
     // them again below
     notes_scene.time_axis_items.clear();
 
+    // laid out exactly for the song as it is now, so any preview transform
+    // from preview_starting_change() comes off
+    notes_scene.pitched_notes_item_pointer =
+        scene.addRect(QRectF(), QPen(Qt::NoPen));
+    notes_scene.built_starting_tempo = song.starting_tempo;
+    notes_scene.built_starting_key = song.starting_key;
+    notes_scene.tempo_scale = 1.0;
+    apply_time_scale(notes_scene);
+
     axis_scene.clear();
 
     const auto& pitched_voices = song.pitched_voices;
@@ -854,6 +885,9 @@ void rebuild_scene(QWidget& widget, const SongWidget& song_widget,
       // lets the double-click event filter trace a clicked rect back to the
       // PianoRollNoteEvent (and thus chord/note) it represents
       note_item.setData(0, event_index);
+      if (is_pitched) {
+        note_item.setParentItem(notes_scene.pitched_notes_item_pointer);
+      }
       note_items.push_back(&note_item);
     }
 
@@ -957,6 +991,10 @@ void rebuild_scene(QWidget& widget, const SongWidget& song_widget,
                             selection_chord_number, selection_first_row_number,
                             selection_number_of_rows,
                             selecting_chord_from_playhead);
+
+  piano_roll_scene.rebuild_milliseconds =
+      static_cast<double>(rebuild_elapsed_timer.nsecsElapsed()) /
+      NANOSECONDS_PER_MILLISECOND;
 }
 
 void stop_playhead(PianoRollNotesScene& piano_roll_scene,
@@ -980,13 +1018,28 @@ void stop_playhead(PianoRollNotesScene& piano_roll_scene,
 void update_playhead_position(PianoRollNotesScene& piano_roll_scene,
                               PianoRollAxisScene& axis_scene,
                               SwitchTable& switch_table,
-                              bool& selecting_chord_from_playhead) {
+                              bool& selecting_chord_from_playhead,
+                              const unsigned int current_tick) {
   if (!piano_roll_scene.playhead_active) {
     return;
   }
-  const auto current_ms =
+  auto& tick_timer = piano_roll_scene.playhead_tick_timer;
+  if (current_tick != piano_roll_scene.playhead_last_tick) {
+    piano_roll_scene.playhead_last_tick = current_tick;
+    tick_timer.restart();
+  }
+  const auto coasted_ms =
+      std::min(static_cast<double>(tick_timer.elapsed()),
+               piano_roll_scene.playhead_period_ms);
+  // what's coming out of the speakers right now, which lags what the
+  // sequencer has already dispatched by the driver's buffer -- held at the
+  // baseline until the first of it is actually audible
+  const auto current_ms = std::max(
+      piano_roll_scene.playhead_baseline_ms,
       piano_roll_scene.playhead_baseline_ms +
-      static_cast<double>(piano_roll_scene.playhead_elapsed_timer.elapsed());
+          static_cast<double>(current_tick -
+                              piano_roll_scene.playhead_start_tick) +
+          coasted_ms - piano_roll_scene.playhead_latency_ms);
   if (current_ms >= piano_roll_scene.playhead_end_ms) {
     piano_roll_scene.playhead_active = false;
     piano_roll_scene.playhead_timer.stop();
@@ -997,7 +1050,17 @@ void update_playhead_position(PianoRollNotesScene& piano_roll_scene,
                              piano_roll_scene.playhead_end_ms);
     return;
   }
-  position_playhead(piano_roll_scene, current_ms);
+  // a move of less than a pixel would repaint the line's old and new
+  // bounding rects (and, while following, scroll the view) for nothing.
+  // catching_up is left alone, since its scroll moves on its own schedule
+  const auto& view = piano_roll_scene.view;
+  const auto& playhead_line = piano_roll_scene.playhead_item.line();
+  if (piano_roll_scene.playhead_transition == PlayheadTransition::catching_up ||
+      view.mapFromScene(to_scene_x(piano_roll_scene, current_ms),
+                        playhead_line.y1())
+              .x() != view.mapFromScene(playhead_line.p1()).x()) {
+    position_playhead(piano_roll_scene, current_ms);
+  }
   select_chord_at_playhead(switch_table, piano_roll_scene.chord_start_times,
                            selecting_chord_from_playhead, current_ms);
 }
@@ -1007,7 +1070,11 @@ PianoRollWidget::PianoRollWidget(const SongWidget& song_widget_input)
       piano_roll_scene(*(new PianoRollNotesScene(*this))),
       axis_scene(*(new PianoRollAxisScene(*this))),
       legend_scene(*(new PianoRollLegendScene(*this))),
-      row_layout(*(new QHBoxLayout(this))) {
+      row_layout(*(new QHBoxLayout(this))),
+      rebuild_timer(*(new QTimer(this))) {
+  // long enough to span the gap between two steps of a held-down spin box
+  static const auto PIANO_ROLL_SETTLE_MILLISECONDS = 250;
+
   // a bottom dock would otherwise default to a cramped sliver; this keeps
   // it usable out of the box while still letting the user drag it taller
   // (or shorter, down to this floor) via the splitter
@@ -1038,7 +1105,9 @@ PianoRollWidget::PianoRollWidget(const SongWidget& song_widget_input)
                      update_playhead_position(
                          piano_roll_scene, axis_scene,
                          song_widget.switch_column.switch_table,
-                         selecting_chord_from_playhead);
+                         selecting_chord_from_playhead,
+                         fluid_sequencer_get_tick(
+                             song_widget.player.sequencer.internal_pointer));
                    });
 
   // the view has no interactivity of its own (no item selection, no
@@ -1047,6 +1116,15 @@ PianoRollWidget::PianoRollWidget(const SongWidget& song_widget_input)
   // overriding QGraphicsView
   get_reference(piano_roll_scene.view.viewport()).installEventFilter(this);
 
+  rebuild_timer.setSingleShot(true);
+  rebuild_timer.setInterval(PIANO_ROLL_SETTLE_MILLISECONDS);
+  QObject::connect(&rebuild_timer, &QTimer::timeout, this, [this]() -> auto {
+    rebuild_scene(*this, song_widget, piano_roll_scene, axis_scene,
+                  legend_scene, row_layout, selection_row_type,
+                  selection_chord_number, selection_first_row_number,
+                  selection_number_of_rows, selecting_chord_from_playhead);
+  });
+
   rebuild_scene(*this, song_widget, piano_roll_scene, axis_scene, legend_scene,
                 row_layout, selection_row_type, selection_chord_number,
                 selection_first_row_number, selection_number_of_rows,
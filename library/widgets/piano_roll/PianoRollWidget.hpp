@@ -8,6 +8,7 @@ struct PianoRollAxisScene;
 struct PianoRollLegendScene;
 struct PianoRollNotesScene;
 class QBoxLayout;
+class QTimer;
 struct Song;
 struct SongWidget;
 struct SwitchTable;
@@ -56,13 +57,22 @@ void position_playhead(PianoRollNotesScene& notes_scene, double time_ms,
     std::optional<bool> pitched_filter = std::nullopt)
     -> std::pair<double, double>;
 
+// a stand-in for rebuild_scene() while the starting tempo or key is being
+// scrubbed: a starting tempo change scales every time uniformly, so it only
+// needs the view's horizontal scale, and a starting key change shifts every
+// pitch uniformly, so it only needs the pitched bars moved as one. The axes,
+// selection box and playhead aren't updated, so an exact rebuild should
+// follow once the change settles (see PianoRollWidget::rebuild_timer)
+void preview_starting_change(PianoRollNotesScene& notes_scene,
+                             const Song& song);
+
 void zoom_in(PianoRollNotesScene& piano_roll_scene);
 
 void zoom_out(PianoRollNotesScene& piano_roll_scene);
 
 // position_playhead() recenters the view every tick while playing, fighting
 // any manual scroll (drag on the scrollbar, or wheel) the user does at the
-// same time -- the two writes to the same scroll position within one 33ms
+// same time -- the two writes to the same scroll position within one timer
 // tick used to leave rendering artifacts behind that read as extra, stuck
 // red cursor lines. Disabling manual scrolling during playback removes the
 // conflicting writer entirely.
@@ -96,10 +106,14 @@ void stop_playhead(PianoRollNotesScene& piano_roll_scene,
                    int selection_first_row_number, int selection_number_of_rows,
                    bool selecting_chord_from_playhead);
 
+// current_tick is the sequencer's (see fluid_sequencer_get_tick), so the
+// playhead tracks what the synth has actually rendered rather than a
+// wall clock that drifts away from it
 void update_playhead_position(PianoRollNotesScene& piano_roll_scene,
                               PianoRollAxisScene& axis_scene,
                               SwitchTable& switch_table,
-                              bool& selecting_chord_from_playhead);
+                              bool& selecting_chord_from_playhead,
+                              unsigned int current_tick);
 
 struct PianoRollWidget : public QWidget {
   Q_OBJECT
@@ -117,6 +131,13 @@ struct PianoRollWidget : public QWidget {
 
   QBoxLayout& row_layout;
 
+  // runs the exact rebuild_scene() a short while after the last
+  // preview_starting_change(), once scrubbing has settled
+  QTimer& rebuild_timer;
+  // the undo stack's index as of the last refresh, so SongEditor can tell
+  // which command a QUndoStack::indexChanged is about
+  int undo_index = 0;
+
   // true for the duration of select_chord_at_playhead()'s own call to
   // QItemSelectionModel::select() -- that select() re-enters this widget
   // synchronously via ReplaceTable's selectionChanged connection
@@ -35,6 +35,10 @@ auto read_xml_document(const QByteArray& bytes) -> XMLDocument {
       bytes.constData(), static_cast<int>(bytes.size()), nullptr, nullptr, 0));
 }
 
+auto read_xml_file(const QString& filename) -> XMLDocument {
+  return XMLDocument(xmlReadFile(filename.toStdString().c_str(), nullptr, 0));
+}
+
 void find_and_process_voice_number(xmlNode& note_node,
                                    const int first_row_number,
                                    const int last_removed_row,
@@ -31,6 +31,9 @@ class XMLDocument {
 
 [[nodiscard]] auto read_xml_document(const QByteArray& bytes) -> XMLDocument;
 
+// the document's internal_pointer is null if the file isn't valid XML
+[[nodiscard]] auto read_xml_file(const QString& filename) -> XMLDocument;
+
 // looks for a direct voice_number child of note_node and renumbers it (or,
 // for a removal that swallows it, zeroes it) the same way
 // InsertVoiceRow/RemoveVoiceRows renumber notes still in song.chords; used
@@ -0,0 +1,11 @@
+#include "xml/XMLValidator.hpp"
+
+#include "other/Trace.hpp"
+#include "xml/XMLDocument.hpp"
+
+auto validate_against_schema(XMLValidator& validator, XMLDocument& document)
+    -> int {
+  const TraceSpan trace_span("validate_against_schema");
+  return xmlSchemaValidateDoc(validator.context.internal_pointer,
+                              document.internal_pointer);
+}
@@ -2,6 +2,10 @@
 
 #include "xml/XMLValidationContext.hpp"
 
+class XMLDocument;
+
+// a validation context can only check one document at a time, so code that
+// might run on more than one thread should keep a thread_local validator
 struct XMLValidator {
   XMLSchema xml_schema;
   XMLValidationContext context;
@@ -9,3 +13,6 @@ struct XMLValidator {
       : xml_schema(XMLParserContext(get_share_file(filename).c_str())),
         context(XMLValidationContext(xml_schema)) {}
 };
+
+[[nodiscard]] auto validate_against_schema(XMLValidator& validator,
+                                           XMLDocument& document) -> int;
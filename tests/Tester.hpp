@@ -1,12 +1,19 @@
 #pragma once
 
 #include <QtCore/QStandardPaths>
+#include <QtCore/QTemporaryDir>
 
+#include "other/Trace.hpp"
 #include "test_helpers.hpp"
 
 struct Tester : public QObject {
   Q_OBJECT
  public:
+  // the trace file is only looked up the first time anything is traced, so
+  // it's set before song_editor traces anything (see test_trace_span)
+  QTemporaryDir trace_dir;
+  const bool trace_file_set =
+      qputenv(TRACE_FILE_VARIABLE, trace_dir.filePath("trace.json").toUtf8());
   SongEditor song_editor;
   QDir test_dir = get_share_folder();
   bool waiting_for_message = false;
@@ -64,7 +71,15 @@ struct Tester : public QObject {
   void test_cut();
   static void test_delete_data();
   void test_delete();
+  static void test_display_follows_removed_row_data();
+  void test_display_follows_removed_row();
+  void test_undo_memory_counts_unshared_rows();
+  void test_undo_restores_repeats();
   void test_export();
+  void test_cancel_export();
+  static void test_song_snapshot_is_unaffected_by_edits();
+  void test_render_song_to_file() const;
+  void test_render_song_to_flac() const;
   void test_export_midi();
   void test_export_via_dialog();
   void test_export_midi_via_dialog();
@@ -74,6 +89,9 @@ struct Tester : public QObject {
   static void test_midi_append_variable_length();
   static void test_midi_byte_encoding();
   static void test_midi_track_event_write_dispatch();
+  static void test_midi_file_bytes();
+  static void test_midi_note_tuning();
+  static void test_midi_tuning_slots();
   static void test_flag_data();
   void test_flag();
   void test_frequency_bound_data();
@@ -82,6 +100,7 @@ struct Tester : public QObject {
   void test_frequency_in_status();
   void test_gain();
   static void test_fluid_driver_move_assign();
+  static void test_trace_span();
   static void test_insert_after_data();
   void test_insert_after();
   static void test_insert_into_data();
@@ -97,14 +116,18 @@ struct Tester : public QObject {
   void test_remove_voice_row_consistent_during_warning();
   static void test_remove_last_voice_disables_action_data();
   void test_remove_last_voice_disables_action();
+  static void test_voice_program_pointer_follows_program();
   static void test_unreduced_ratio_from_xml_data();
   void test_unreduced_ratio_from_xml();
   static void test_interval_zero_numerator_does_not_hang();
+  static void test_modulate_returns_to_starting_key();
   static void test_insert_xml_rows_respects_first_row_number();
   static void test_musicxml_data();
   void test_musicxml();
   static void test_musicxml_error_data();
   void test_musicxml_error();
+  void test_cancel_import();
+  void test_import_musicxml_repeat();
   static void test_compute_measure_expansion_lone_backward_repeat();
   void test_import_musicxml_ties_do_not_cross_voices();
   void test_import_musicxml_orphan_tie_stop();
@@ -113,6 +136,7 @@ struct Tester : public QObject {
   void test_read_zip_entry_null_archive() const;
   static void test_xml_bytes_size_is_safe_data();
   static void test_xml_bytes_size_is_safe();
+  static void test_read_song_pools_words();
   static void test_string_to_maybe_int_data();
   static void test_string_to_maybe_int();
   void test_get_share_file_existing() const;
@@ -143,6 +167,12 @@ struct Tester : public QObject {
   void test_play_to_end_starts_playhead();
   static void test_play_to_end_data();
   void test_play_to_end();
+  void test_performance_dock_shows_busy_channels();
+  void test_channel_pool_grows();
+  void test_key_tuning_shares_channel();
+  void test_playback_plan();
+  void test_audition_voice();
+  void test_pre_render_selection();
   void test_ratio_bound_data();
   void test_ratio_bound();
   static void test_remove_row_data();
@@ -196,4 +226,5 @@ struct Tester : public QObject {
   void test_piano_roll_drag_selects_chord_range();
   void test_piano_roll_playback_selects_chord();
   void test_piano_roll_zoom();
+  void test_piano_roll_previews_starting_changes();
 };
\ No newline at end of file
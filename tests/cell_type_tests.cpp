@@ -334,6 +334,33 @@ void Tester::test_interval_zero_numerator_does_not_hang() {
   QCOMPARE(interval.octave, 3);
 }
 
+// keys used to be multiplied chord after chord as doubles, so going up and
+// back down by the same interval enough times drifted off the starting key
+void Tester::test_modulate_returns_to_starting_key() {
+  static const auto NUMBER_OF_ROUND_TRIPS = 1000;
+
+  Song song;
+  PlayState play_state;
+  initialize_playstate(song, play_state, 0);
+
+  Chord up_chord;
+  up_chord.interval = Interval(Rational(3, 2));
+  Chord down_chord;
+  down_chord.interval = Interval(Rational(4, 3), -1);
+  for (auto round_trip = 0; round_trip < NUMBER_OF_ROUND_TRIPS;
+       round_trip = round_trip + 1) {
+    modulate(play_state, up_chord);
+    modulate(play_state, down_chord);
+  }
+  // QCOMPARE lets doubles be a little off, so these check exactly
+  const auto& key_monzo = play_state.key_monzo;
+  for (const auto exponent : key_monzo.exponents) {
+    QCOMPARE(exponent, 0);
+  }
+  QVERIFY(key_monzo.other_log2 == 0);
+  QVERIFY(play_state.current_key == play_state.starting_key);
+}
+
 // regression test: some musicxml fields (e.g. fifths, octave-change,
 // divisions) are unbounded xs:integer/xs:decimal with no schema-enforced
 // range, so std::stoi can throw std::out_of_range on a magnitude that
@@ -1,5 +1,13 @@
+#include <algorithm>
+#include <cmath>
+
 #include "Tester.hpp"
+#include "other/MidiExport.hpp"
 #include "other/MidiTrackEvent.hpp"
+#include "other/SongFile.hpp"
+#include "rows/Chord.hpp"
+#include "sound/OfflineSynth.hpp"
+#include "sound/PlaybackPlan.hpp"
 
 void Tester::test_export() {
   auto& song_widget = song_editor.song_widget;
@@ -8,6 +16,108 @@ void Tester::test_export() {
   QVERIFY(temp_export_file.open());
   temp_export_file.close();
   export_to_file(song_widget, temp_export_file.fileName());
+  finish_export(song_widget);
+
+  QFile written_file(temp_export_file.fileName());
+  QVERIFY(written_file.open(QIODevice::ReadOnly));
+  QCOMPARE(written_file.read(4), QByteArray("RIFF"));
+}
+
+void Tester::test_cancel_export() {
+  static const auto EXPORT_TIMEOUT = 10000;
+  auto& song_widget = song_editor.song_widget;
+
+  QTemporaryDir temp_export_dir;
+  QVERIFY(temp_export_dir.isValid());
+  const auto export_filename = temp_export_dir.filePath("export.wav");
+  // a file that's already there, which a render cancelled before it starts
+  // never opens, so it should be left alone
+  QFile existing_file(export_filename);
+  QVERIFY(existing_file.open(QIODevice::WriteOnly));
+  existing_file.close();
+  export_to_file(song_widget, export_filename);
+  QVERIFY(song_widget.recording_export_pointer != nullptr);
+  auto& recording_export = *song_widget.recording_export_pointer;
+  // cancelled while the thread is still loading its synth, so the render
+  // stops before it starts
+  recording_export.cancelled.store(true);
+  // so finish_export doesn't get called while the test is still waiting
+  song_widget.export_timer.stop();
+  QTRY_VERIFY_WITH_TIMEOUT(recording_export.finished.load(), EXPORT_TIMEOUT);
+  QVERIFY(!recording_export.succeeded);
+  QVERIFY(!recording_export.created_file);
+  finish_export(song_widget);
+
+  QVERIFY(song_widget.recording_export_pointer == nullptr);
+  QVERIFY(song_widget.export_dialog_pointer == nullptr);
+  QVERIFY(QFile::exists(export_filename));
+}
+
+void Tester::test_song_snapshot_is_unaffected_by_edits() {
+  Song song;
+  song.chords.push_back(Chord());
+  const auto snapshot_pointer = make_song_snapshot(song);
+
+  const auto* const chord_pointer = &song.chords.at(0);
+  auto& chord = song.chords[0];
+  // the notes models point into song's chords, so they mustn't move
+  QCOMPARE(&chord, chord_pointer);
+  chord.beats = Rational(2, 1);
+  chord.pitched_notes.push_back(PitchedNote());
+
+  const auto& snapshot_chord = snapshot_pointer->chords.at(0);
+  QCOMPARE(snapshot_chord.beats, Rational(1, 1));
+  QVERIFY(snapshot_chord.pitched_notes.empty());
+}
+
+void Tester::test_render_song_to_file() const {
+  UserWarning warning;
+  const auto maybe_song_file =
+      read_song_file(test_dir.filePath("test_song.xml"), warning);
+  QVERIFY(maybe_song_file.has_value());
+
+  QTemporaryFile temp_export_file;
+  QVERIFY(temp_export_file.open());
+  temp_export_file.close();
+  OfflineSynth offline_synth(DEFAULT_SAMPLE_RATE);
+  auto created_file = false;
+  QVERIFY(render_song_to_file(offline_synth, maybe_song_file->song,
+                              maybe_song_file->gain,
+                              temp_export_file.fileName(), AudioFileFormat(),
+                              warning, created_file));
+  QVERIFY(created_file);
+
+  QFile written_file(temp_export_file.fileName());
+  QVERIFY(written_file.open(QIODevice::ReadOnly));
+  QCOMPARE(written_file.read(4), QByteArray("RIFF"));
+}
+
+void Tester::test_render_song_to_flac() const {
+  UserWarning warning;
+  const auto maybe_song_file =
+      read_song_file(test_dir.filePath("test_song.xml"), warning);
+  QVERIFY(maybe_song_file.has_value());
+
+  QTemporaryDir temp_export_dir;
+  QVERIFY(temp_export_dir.isValid());
+  const auto export_filename = temp_export_dir.filePath("export.flac");
+  OfflineSynth offline_synth(MAX_SAMPLE_RATE);
+  auto created_file = false;
+  // FLAC can't hold float samples
+  QVERIFY(!render_song_to_file(
+      offline_synth, maybe_song_file->song, maybe_song_file->gain,
+      export_filename, {.file_type = "flac", .sample_format = "float"},
+      warning, created_file));
+  QVERIFY(!created_file);
+  QVERIFY(!QFile::exists(export_filename));
+
+  QVERIFY(render_song_to_file(
+      offline_synth, maybe_song_file->song, maybe_song_file->gain,
+      export_filename, {.file_type = "flac", .sample_format = "s24"},
+      warning, created_file));
+  QFile written_file(export_filename);
+  QVERIFY(written_file.open(QIODevice::ReadOnly));
+  QCOMPARE(written_file.read(4), QByteArray("fLaC"));
 }
 
 void Tester::test_export_midi() {
@@ -50,6 +160,7 @@ void Tester::test_export_via_dialog() {
 
   accept_file_dialog_later(song_editor, export_filename);
   song_menu_bar.file_menu.export_action.trigger();
+  finish_export(song_editor.song_widget);
 
   QFile written_file(export_filename);
   QVERIFY(written_file.open(QIODevice::ReadOnly));
@@ -105,9 +216,8 @@ void Tester::test_export_midi_via_dialog() {
 
 // regression test: an export path whose parent directory doesn't exist
 // makes new_fluid_file_renderer fail to open the file -- export_to_file
-// should warn instead of dereferencing the null renderer pointer, and
-// should still restore playback state (synth.lock-memory, audio driver)
-// afterward rather than leaving the app stuck with realtime audio off
+// should warn instead of dereferencing the null renderer pointer, and a
+// later export should still work
 void Tester::test_export_unwritable_path() {
   auto& song_widget = song_editor.song_widget;
 
@@ -118,15 +228,16 @@ void Tester::test_export_unwritable_path() {
 
   close_message_later(song_editor, waiting_for_message, "Cannot write to file");
   export_to_file(song_widget, unwritable_path);
+  finish_export(song_widget);
 
   QVERIFY(!QFile::exists(unwritable_path));
 
-  // a subsequent export to a valid path should still work, confirming
-  // export_to_file restored playback state rather than leaving it broken
+  // a subsequent export to a valid path should still work
   QTemporaryFile temp_export_file;
   QVERIFY(temp_export_file.open());
   temp_export_file.close();
   export_to_file(song_widget, temp_export_file.fileName());
+  finish_export(song_widget);
 }
 
 // regression test: FileMenu's dialogs (make_file_dialog) must not leak --
@@ -240,7 +351,7 @@ void Tester::test_midi_track_event_write_dispatch() {
 
   bytes.clear();
   MidiTrackEvent{
-      .tick = 0, .tie_break = 0, .info = TrackNameEventInfo{.name = "Hi"}}
+      .tick = 0, .tie_break = 0, .info = TrackNameEventInfo{.name_bytes = "Hi"}}
       .write(bytes);
   QCOMPARE(bytes, QByteArray::fromHex("FF0302") + QByteArray("Hi"));
 
@@ -286,3 +397,180 @@ void Tester::test_midi_track_event_write_dispatch() {
       .write(bytes);
   QCOMPARE(bytes, QByteArray::fromHex("813C00"));
 }
+
+// a long note added first but ending last has to be merged in after the
+// shorter note that follows it, with each same-tick group in tie_break order
+void Tester::test_midi_file_bytes() {
+  MidiTrack track;
+  add_track_event(track, {.tick = 0,
+                          .tie_break = 0,
+                          .info = TrackNameEventInfo{.name_bytes = "Hi"}});
+  add_track_event(track, {.tick = 0,
+                          .tie_break = 5,
+                          .info = NoteOnEventInfo{.channel_number = 0,
+                                                  .midi_number = 60,
+                                                  .velocity = 100}});
+  add_track_event(track, {.tick = 300,
+                          .tie_break = 0,
+                          .info = NoteOffEventInfo{.channel_number = 0,
+                                                   .midi_number = 60}});
+  add_track_event(track, {.tick = 100,
+                          .tie_break = 5,
+                          .info = NoteOnEventInfo{.channel_number = 1,
+                                                  .midi_number = 62,
+                                                  .velocity = 100}});
+  add_track_event(track, {.tick = 100,
+                          .tie_break = 2,
+                          .info = ProgramChangeEventInfo{
+                              .channel_number = 1, .program_number = 5}});
+  add_track_event(track, {.tick = 200,
+                          .tie_break = 0,
+                          .info = NoteOffEventInfo{.channel_number = 1,
+                                                   .midi_number = 62}});
+
+  const auto track_data =
+      QByteArray::fromHex("00FF0302") + QByteArray("Hi") +
+      QByteArray::fromHex("00903C64"
+                          "64C105"
+                          "00913E64"
+                          "64813E00"
+                          "64803C00"
+                          "00FF2F00");
+  QCOMPARE(get_midi_file_bytes({track}, 500),
+           QByteArray("MThd") + QByteArray::fromHex("000000060001000101F4") +
+               QByteArray("MTrk") + QByteArray::fromHex("0000001D") +
+               track_data);
+}
+
+void Tester::test_midi_note_tuning() {
+  const NoteTuningEventInfo quarter_tone{
+      .tuning_program = 1, .key = 60, .midi_number = 60.5};
+  QByteArray bytes;
+  quarter_tone.write(bytes);
+  QCOMPARE(bytes, QByteArray::fromHex("F00B7F7F080201013C3C4000F7"));
+  QCOMPARE(quarter_tone.get_size(), bytes.size());
+
+  // a fraction that rounds up to a whole semitone carries into it
+  bytes.clear();
+  append_note_tuning(bytes, 0, 62, 61.99999);
+  QCOMPARE(bytes.mid(9, 3), QByteArray::fromHex("3E0000"));
+
+  // out-of-range pitches clamp, never writing the reserved "no change" value
+  bytes.clear();
+  append_note_tuning(bytes, 0, 0, -0.25);
+  QCOMPARE(bytes.mid(9, 3), QByteArray::fromHex("000000"));
+  bytes.clear();
+  append_note_tuning(bytes, 0, 127, 128.5);
+  QCOMPARE(bytes.mid(9, 3), QByteArray::fromHex("7F7F7E"));
+}
+
+// overlapping notes with the same program and velocity share a channel, on
+// keys of their own, and a key only gets retuned once the note it last
+// played has finished its release tail
+void Tester::test_midi_tuning_slots() {
+  // at the default tempo of 100 beats per minute
+  static const auto BEAT_TICKS = 600;
+  static const auto SYSEX_STATUS = 0xF0;
+  static const auto META_STATUS = 0xFF;
+  static const auto PROGRAM_CHANGE_STATUS = 0xC0;
+  static const auto STATUS_MASK = 0xF0;
+  static const auto TUNING_PROGRAM_BYTE = 6;
+  static const auto TUNING_KEY_BYTE = 8;
+  static const auto CONTINUATION_BIT = 0x80;
+  static const auto DATA_MASK = 0x7F;
+
+  Song song;
+  song.pitched_voices.push_back(PitchedVoice());
+  const auto& program =
+      get_reference(song.pitched_voices.at(0).program_pointer);
+  // long enough for the first chord's release tails to die away
+  const auto wait_beats =
+      static_cast<int>(std::ceil(program.release_milliseconds / BEAT_TICKS)) +
+      1;
+
+  Chord first_chord;
+  first_chord.pitched_notes.push_back(PitchedNote());
+  PitchedNote major_third;
+  major_third.interval = Interval(Rational(5, 4));
+  first_chord.pitched_notes.push_back(major_third);
+  song.chords.push_back(first_chord);
+
+  // a comma above the first chord's root, so closest to its key
+  PitchedNote comma;
+  comma.interval = Interval(Rational(81, 80));
+  Chord second_chord;
+  second_chord.beats = Rational(wait_beats);
+  second_chord.pitched_notes.push_back(comma);
+  song.chords.push_back(second_chord);
+
+  Chord third_chord;
+  third_chord.pitched_notes.push_back(comma);
+  song.chords.push_back(third_chord);
+
+  UserWarning warning;
+  const auto maybe_bytes =
+      get_song_midi_bytes(song, compile_playback_plan(song), true, warning);
+  QVERIFY(maybe_bytes.has_value());
+  const auto& bytes = *maybe_bytes;
+
+  // the voice's own track comes after the tempo track
+  const auto track_start = bytes.indexOf("MTrk", bytes.indexOf("MTrk") + 4);
+  QVERIFY(track_start >= 0);
+  auto position = track_start + 8;
+  auto tick = 0;
+  // each tick with the bytes of the event there
+  QList<std::pair<int, QByteArray>> events;
+  while (position < bytes.size()) {
+    auto delta = 0;
+    auto delta_byte = 0;
+    do {
+      delta_byte = static_cast<unsigned char>(bytes.at(position));
+      delta = delta * (DATA_MASK + 1) + (delta_byte & DATA_MASK);
+      position = position + 1;
+    } while ((delta_byte & CONTINUATION_BIT) != 0);
+    tick = tick + delta;
+    const auto status = static_cast<unsigned char>(bytes.at(position));
+    auto size = 3;
+    if (status == META_STATUS) {
+      size = 3 + static_cast<unsigned char>(bytes.at(position + 2));
+    } else if (status == SYSEX_STATUS) {
+      size = 2 + static_cast<unsigned char>(bytes.at(position + 1));
+    } else if ((status & STATUS_MASK) == PROGRAM_CHANGE_STATUS) {
+      size = 2;
+    }
+    events.emplace_back(tick, bytes.mid(position, size));
+    position = position + size;
+  }
+
+  const auto has_event = [&events](const int event_tick,
+                                   const QByteArray& event_bytes) -> auto {
+    return std::ranges::any_of(events, [&](const auto& event) -> auto {
+      return event.first == event_tick && event.second.startsWith(event_bytes);
+    });
+  };
+  const auto get_retune_ticks = [&events](const int tuning_program,
+                                          const int key) -> auto {
+    QList<int> ticks;
+    for (const auto& [event_tick, event_bytes] : events) {
+      if (static_cast<unsigned char>(event_bytes.at(0)) == SYSEX_STATUS &&
+          event_bytes.at(TUNING_PROGRAM_BYTE) == tuning_program &&
+          event_bytes.at(TUNING_KEY_BYTE) == key) {
+        ticks.push_back(event_tick);
+      }
+    }
+    return ticks;
+  };
+
+  const auto third_chord_tick = BEAT_TICKS * (1 + wait_beats);
+  // both notes of the first chord on channel 0, on keys of their own
+  QVERIFY(has_event(0, QByteArray::fromHex("903C")));
+  QVERIFY(has_event(0, QByteArray::fromHex("9040")));
+  // retuning channel 0's key 60 would bend its release tail, so the second
+  // chord moves to channel 1
+  QVERIFY(has_event(BEAT_TICKS, QByteArray::fromHex("913C")));
+  // the third chord comes back to channel 0 once its key is free
+  QVERIFY(has_event(third_chord_tick, QByteArray::fromHex("903C")));
+  QCOMPARE(get_retune_ticks(0, MIDDLE_C_MIDI),
+           QList<int>({0, third_chord_tick}));
+  QCOMPARE(get_retune_ticks(1, MIDDLE_C_MIDI), QList<int>({BEAT_TICKS}));
+}
@@ -1,4 +1,10 @@
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+
 #include "Tester.hpp"
+#include "other/SongFile.hpp"
+#include "rows/Chord.hpp"
 #include "xml/ZipArchive.hpp"
 
 // regression test: FluidDriver's move-assignment operator must free any
@@ -131,3 +137,56 @@ void Tester::test_open_error() {
   close_message_later(song_editor, waiting_for_message, error_message);
   open_text(song_editor, text);
 }
+
+// the Tester turns tracing on before anything traces, so a span shows up
+// in the trace file as one complete event
+void Tester::test_trace_span() {
+  QVERIFY(is_tracing());
+  {
+    const TraceSpan trace_span("test_trace_span");
+  }
+  flush_trace();
+
+  QFile trace_file(qEnvironmentVariable(TRACE_FILE_VARIABLE));
+  QVERIFY(trace_file.open(QIODevice::ReadOnly));
+  // the closing ] only gets written when the app exits
+  auto trace_bytes = trace_file.readAll();
+  QVERIFY(!trace_bytes.trimmed().endsWith(']'));
+  trace_bytes.append(']');
+  QJsonParseError parse_error{};
+  const auto trace_document =
+      QJsonDocument::fromJson(trace_bytes, &parse_error);
+  QCOMPARE(parse_error.error, QJsonParseError::NoError);
+  auto number_of_spans = 0;
+  for (const auto& event_value : trace_document.array()) {
+    const auto event = event_value.toObject();
+    if (event.value("name").toString() == "test_trace_span") {
+      QCOMPARE(event.value("ph").toString(), QString("X"));
+      QVERIFY(event.contains("ts"));
+      QVERIFY(event.value("dur").toDouble() >= 0);
+      number_of_spans = number_of_spans + 1;
+    }
+  }
+  QCOMPARE(number_of_spans, 1);
+}
+
+void Tester::test_read_song_pools_words() {
+  UserWarning warning;
+  const auto maybe_song_file = read_song_bytes(
+      "<song><gain>1</gain><starting_key>220</starting_key>"
+      "<starting_tempo>100</starting_tempo><starting_velocity>10</"
+      "starting_velocity><pitched_voices><pitched_voice><name>A</name>"
+      "<instrument>Marimba</instrument></pitched_voice></pitched_voices>"
+      "<unpitched_voices><unpitched_voice><name>B</name>"
+      "<percussion_set_pointer>Room</percussion_set_pointer><midi_number>36</"
+      "midi_number></unpitched_voice></unpitched_voices><chords><chord>"
+      "<words>verse</words></chord><chord><words>verse</words></chord>"
+      "</chords></song>",
+      warning);
+  QVERIFY(maybe_song_file.has_value());
+  const auto& chords = maybe_song_file->song.chords;
+  QCOMPARE(chords.size(), 2);
+  QCOMPARE(chords.at(0).words, "verse");
+  // one shared buffer, not a copy per chord
+  QCOMPARE(chords.at(0).words.constData(), chords.at(1).words.constData());
+}
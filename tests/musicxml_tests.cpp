@@ -1,10 +1,14 @@
+#include <QtTest/QSignalSpy>
 #include <QtWidgets/QLabel>
+#include <QtWidgets/QProgressDialog>
 
 #include "Tester.hpp"
 #include "musicxml/MeasureRepeatInfo.hpp"
 
 void Tester::test_musicxml_data() {
   QTest::addColumn<QString>("file_name");
+  // as they play: repeats without endings stay folded, which leaves fewer
+  // rows, but shouldn't change what plays
   QTest::addColumn<int>("number_of_chords");
 
   QTest::newRow("prelude") << "prelude.musicxml" << MUSIC_XML_ROWS;
@@ -21,12 +25,20 @@ void Tester::test_musicxml() {
 
   auto& song_widget = song_editor.song_widget;
 
-  import_musicxml_and_reload(song_editor.song_menu_bar, song_editor.song_widget,
-                             song_editor.piano_roll_widget,
-                             test_dir.filePath(file_name));
+  // however many chords there are, they go in all at once
+  QSignalSpy inserted_spy(&song_widget.switch_column.switch_table.chords_model,
+                          &QAbstractItemModel::rowsInserted);
+  import_musicxml_and_wait(song_editor, test_dir.filePath(file_name));
+  QCOMPARE(inserted_spy.count(), 1);
   QCOMPARE(
       get_model(song_widget.switch_column.switch_table).rowCount(QModelIndex()),
-      number_of_chords);
+      static_cast<int>(song_widget.song.chords.size()));
+  auto number_of_played_chords = 0;
+  for (const auto& played_run : get_played_runs(song_widget.song)) {
+    number_of_played_chords =
+        number_of_played_chords + played_run.number_of_chords;
+  }
+  QCOMPARE(number_of_played_chords, number_of_chords);
   open_file_and_reload(song_editor.song_menu_bar, song_editor.song_widget,
                        song_editor.piano_roll_widget,
                        test_dir.filePath("test_song.xml"));
@@ -63,9 +75,54 @@ void Tester::test_musicxml_error() {
   QFETCH(const QString, file_name);
 
   close_message_later(song_editor, waiting_for_message, error_message);
-  import_musicxml_and_reload(song_editor.song_menu_bar, song_editor.song_widget,
-                             song_editor.piano_roll_widget,
-                             test_dir.filePath(file_name));
+  import_musicxml_and_wait(song_editor, test_dir.filePath(file_name));
+}
+
+// a repeat without endings imports as a song repeat, rather than copies of
+// its chords, and plays, saves and loads as one
+void Tester::test_import_musicxml_repeat() {
+  static const auto NUMBER_OF_CHORDS = 4;
+  static const auto PLAYED_CHORDS_PER_CHORD = 1.5;
+
+  auto& song_widget = song_editor.song_widget;
+  const auto& song = song_widget.song;
+
+  import_musicxml_and_wait(song_editor,
+                           test_dir.filePath("simple_repeat.musicxml"));
+  QCOMPARE(song.chords.size(), NUMBER_OF_CHORDS);
+  const QList<Repeat> expected_repeats(
+      {Repeat{.first_chord_number = 1, .number_of_chords = 2, .times = 2}});
+  QCOMPARE(song.repeats, expected_repeats);
+
+  // every chord is a beat long, and the repeat plays two of them twice
+  const auto& playback_plan = get_playback_plan(song_widget);
+  QCOMPARE(playback_plan.passes.size(), 2);
+  QCOMPARE(playback_plan.passes.at(1).first_chord_number, 1);
+  QCOMPARE(playback_plan.played_end_time,
+           PLAYED_CHORDS_PER_CHORD * playback_plan.end_time);
+
+  QTemporaryFile temp_save_file;
+  QVERIFY(temp_save_file.open());
+  temp_save_file.close();
+  save_as_file(song_widget, temp_save_file.fileName());
+  open_file_and_reload(song_editor.song_menu_bar, song_editor.song_widget,
+                       song_editor.piano_roll_widget,
+                       temp_save_file.fileName());
+  QCOMPARE(song.repeats, expected_repeats);
+
+  // the repeat keeps to its chords as chords come and go
+  auto& chords_model = song_widget.switch_column.switch_table.chords_model;
+  chords_model.remove_rows(0, 2);
+  const QList<Repeat> shrunk_repeats(
+      {Repeat{.first_chord_number = 0, .number_of_chords = 1, .times = 2}});
+  QCOMPARE(song.repeats, shrunk_repeats);
+  chords_model.remove_rows(0, 1);
+  QVERIFY(song.repeats.isEmpty());
+
+  QFile(temp_save_file.fileName()).remove();
+  open_file_and_reload(song_editor.song_menu_bar, song_editor.song_widget,
+                       song_editor.piano_roll_widget,
+                       test_dir.filePath("test_song.xml"));
 }
 
 // regression test: a backward repeat with no forward repeat since the
@@ -128,9 +185,8 @@ void Tester::test_compute_measure_expansion_lone_backward_repeat() {
 void Tester::test_import_musicxml_ties_do_not_cross_voices() {
   auto& song_widget = song_editor.song_widget;
 
-  import_musicxml_and_reload(song_editor.song_menu_bar, song_editor.song_widget,
-                             song_editor.piano_roll_widget,
-                             test_dir.filePath("tied_voices.musicxml"));
+  import_musicxml_and_wait(song_editor,
+                           test_dir.filePath("tied_voices.musicxml"));
 
   auto& song = song_widget.song;
   QCOMPARE(song.chords.size(), 2);
@@ -162,9 +218,8 @@ void Tester::test_import_musicxml_ties_do_not_cross_voices() {
 void Tester::test_import_musicxml_orphan_tie_stop() {
   auto& song_widget = song_editor.song_widget;
 
-  import_musicxml_and_reload(song_editor.song_menu_bar, song_editor.song_widget,
-                             song_editor.piano_roll_widget,
-                             test_dir.filePath("orphan_tie.musicxml"));
+  import_musicxml_and_wait(song_editor,
+                           test_dir.filePath("orphan_tie.musicxml"));
 
   auto& song = song_widget.song;
   QCOMPARE(song.chords.size(), 1);
@@ -193,9 +248,8 @@ void Tester::test_import_musicxml_after_editing_chord_notes() {
   switch_to(song_editor, RowType::pitched_note_type, 1);
   insert_menu.insert_into_start_action.trigger();
 
-  import_musicxml_and_reload(song_editor.song_menu_bar, song_editor.song_widget,
-                             song_editor.piano_roll_widget,
-                             test_dir.filePath("prelude.musicxml"));
+  import_musicxml_and_wait(song_editor,
+                           test_dir.filePath("prelude.musicxml"));
   QCOMPARE(get_model(switch_table).rowCount(QModelIndex()), MUSIC_XML_ROWS);
 
   open_file_and_reload(song_editor.song_menu_bar, song_editor.song_widget,
@@ -206,7 +260,7 @@ void Tester::test_import_musicxml_after_editing_chord_notes() {
 // regression test: opening/importing a file bypasses the undo stack, so
 // replace_table (which normally resets the switch column's label and the
 // view menu's actions whenever the table switches to a different row
-// type) never runs for them; open_file_and_reload/import_musicxml_and_reload
+// type) never runs for them; open_file_and_reload/finish_import_and_reload
 // must reapply that same reset explicitly (via song_reloaded) instead of
 // leaving the label/actions stuck showing whatever was being edited before
 void Tester::test_open_after_editing_chord_notes_resets_menu() {
@@ -263,12 +317,31 @@ void Tester::test_failed_import_does_not_reset_notes_view() {
 
   close_message_later(song_editor, waiting_for_message,
                       "Invalid musicxml file");
-  import_musicxml_and_reload(song_editor.song_menu_bar, song_editor.song_widget,
-                             song_editor.piano_roll_widget,
-                             test_dir.filePath("not_musicxml.xml"));
+  import_musicxml_and_wait(song_editor,
+                           test_dir.filePath("not_musicxml.xml"));
 
   QCOMPARE(switch_column.editing_text.text(), "Pitched notes for chord 1");
 
   maybe_switch_back_to_chords(song_widget.undo_stack,
                               RowType::pitched_note_type);
 }
+
+void Tester::test_cancel_import() {
+  auto& song_widget = song_editor.song_widget;
+  auto& chords_model = song_widget.switch_column.switch_table.chords_model;
+  const auto number_of_chords = chords_model.rowCount(QModelIndex());
+
+  import_musicxml(song_widget, test_dir.filePath("prelude.musicxml"));
+  QVERIFY(song_widget.musicxml_importer_pointer != nullptr);
+  // the dialog blocks edits straight away, since the import would lose them
+  const auto& dialog = get_reference(song_widget.import_dialog_pointer);
+  QCOMPARE(dialog.windowModality(), Qt::WindowModal);
+  QCOMPARE(dialog.minimumDuration(), 0);
+  song_widget.musicxml_importer_pointer->cancelled.store(true);
+  QVERIFY(!finish_import(song_widget));
+
+  QVERIFY(song_widget.musicxml_importer_pointer == nullptr);
+  QVERIFY(song_widget.import_dialog_pointer == nullptr);
+  // the song is left alone, even if the import beat the cancel
+  QCOMPARE(chords_model.rowCount(QModelIndex()), number_of_chords);
+}
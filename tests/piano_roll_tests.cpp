@@ -534,12 +534,13 @@ void Tester::test_piano_roll_playback_selects_chord() {
   start_piano_roll_playhead(piano_roll_widget, 1200.0, 1800.0);
   QCOMPARE(get_only_range(switch_table).top(), 0);
 
-  // simulates one playback timer tick without waiting on the real
-  // QElapsedTimer -- elapsed() is at least 0, so current_ms is already
-  // >= the 1200ms baseline, landing on chord 2
-  update_playhead_position(piano_roll_widget.piano_roll_scene,
-                           piano_roll_widget.axis_scene, switch_table,
-                           piano_roll_widget.selecting_chord_from_playhead);
+  // simulates one playback timer tick without waiting on the sequencer --
+  // at the tick playback started on, the playhead is held at the 1200ms
+  // baseline, landing on chord 2
+  update_playhead_position(
+      piano_roll_widget.piano_roll_scene, piano_roll_widget.axis_scene,
+      switch_table, piano_roll_widget.selecting_chord_from_playhead,
+      piano_roll_widget.piano_roll_scene.playhead_start_tick);
   QCOMPARE(get_only_range(switch_table).top(), 2);
 
   stop_piano_roll_playhead(piano_roll_widget);
@@ -578,3 +579,40 @@ void Tester::test_piano_roll_zoom() {
   // restore, so later tests see the default 1x zoom
   set_notes_view_time_zoom(piano_roll_widget.piano_roll_scene, 1.0);
 }
+
+void Tester::test_piano_roll_previews_starting_changes() {
+  auto& song_widget = song_editor.song_widget;
+  auto& piano_roll_widget = song_editor.piano_roll_widget;
+  auto& scene = piano_roll_widget.piano_roll_scene;
+  auto& spin_boxes = song_widget.controls_column.spin_boxes;
+  auto& undo_stack = song_widget.undo_stack;
+
+  const auto old_note_items = scene.note_items;
+  const auto old_tempo = song_widget.song.starting_tempo;
+  const auto old_key = song_widget.song.starting_key;
+
+  // scrubbing transforms the bars already drawn, rather than redrawing them
+  spin_boxes.starting_tempo_editor.setValue(old_tempo * 2);
+  QCOMPARE(scene.note_items, old_note_items);
+  QCOMPARE(scene.view.transform().m11(), 0.5);
+  QVERIFY(piano_roll_widget.rebuild_timer.isActive());
+
+  spin_boxes.starting_key_editor.setValue(old_key * 2);
+  QCOMPARE(scene.note_items, old_note_items);
+  // an octave up
+  QCOMPARE(get_reference(scene.pitched_notes_item_pointer).y(),
+           -HALFSTEPS_PER_OCTAVE * PIANO_ROLL_PIXELS_PER_SEMITONE * 1.0);
+
+  // then the exact rebuild catches up once it settles
+  QTRY_VERIFY(!piano_roll_widget.rebuild_timer.isActive());
+  QCOMPARE(scene.view.transform().m11(), 1.0);
+  QCOMPARE(scene.built_starting_tempo, old_tempo * 2);
+  QCOMPARE(scene.built_starting_key, old_key * 2);
+  QCOMPARE(get_reference(scene.pitched_notes_item_pointer).y(), 0.0);
+
+  undo_stack.undo();
+  undo_stack.undo();
+  QTRY_VERIFY(!piano_roll_widget.rebuild_timer.isActive());
+  QCOMPARE(scene.built_starting_tempo, old_tempo);
+  QCOMPARE(scene.built_starting_key, old_key);
+}
@@ -1,4 +1,10 @@
+#include <QtWidgets/QDockWidget>
+#include <QtWidgets/QLabel>
+#include <QtWidgets/QStatusBar>
+#include <fluidsynth.h>
+
 #include "Tester.hpp"
+#include "widgets/PerformanceWidget.hpp"
 #include "widgets/piano_roll/PianoRollNotesScene.hpp"
 #include "widgets/piano_roll/PianoRollWidget.hpp"
 
@@ -132,3 +138,189 @@ void Tester::test_play_to_end() {
 
   maybe_switch_back_to_chords(song_widget.undo_stack, row_type);
 }
+
+void Tester::test_performance_dock_shows_busy_channels() {
+  auto& performance_widget = song_editor.performance_widget;
+  auto& show_performance_action =
+      song_editor.song_menu_bar.view_menu.show_performance_action;
+  auto& play_menu = song_editor.song_menu_bar.play_menu;
+
+  QVERIFY(song_editor.performance_dock.isHidden());
+  show_performance_action.trigger();
+  QVERIFY(!song_editor.performance_dock.isHidden());
+
+  select_cell(song_editor.song_widget.switch_column.switch_table, 0, 0);
+  play_menu.play_to_end_action.trigger();
+  // the dock is never really shown in these headless tests, so its timer
+  // never runs
+  update_performance_widget(performance_widget);
+  QVERIFY(!performance_widget.busy_channels_label.text().startsWith("0 "));
+  play_menu.stop_playing_action.trigger();
+
+  show_performance_action.trigger();
+  QVERIFY(song_editor.performance_dock.isHidden());
+}
+
+// one more overlapping pitched note than the primary synth has channels
+// should spill over onto a pooled synth instead of aborting with "MIDI
+// channel exhausted"
+void Tester::test_channel_pool_grows() {
+  auto& song_widget = song_editor.song_widget;
+  auto& player = song_widget.player;
+  const auto& program = get_some_programs(true).at(0);
+
+  stop_playing(player);
+  initialize_play(song_widget);
+  const auto start_time = player.play_state.current_time;
+  for (auto note_number = 0; note_number <= NUMBER_OF_MIDI_CHANNELS;
+       note_number = note_number + 1) {
+    const auto maybe_note_slot = get_note_slot(
+        song_widget, player, program, MIDDLE_C_MIDI, BIG_VELOCITY, start_time);
+    QVERIFY(maybe_note_slot.has_value());
+    play_note(player, *maybe_note_slot, program, MIDDLE_C_MIDI, BIG_VELOCITY,
+              start_time, start_time + WAIT_TIME);
+  }
+  QVERIFY(player.number_of_pooled_synths.load() > 0);
+  stop_playing(player);
+}
+
+// with key tuning, a just major third over middle C should share middle C's
+// channel, on a key retuned to its exact pitch, instead of needing a channel
+// of its own for a pitch bend
+void Tester::test_key_tuning_shares_channel() {
+  static const auto JUST_MAJOR_THIRD_HALFSTEPS = 3.8631;
+
+  auto& song_widget = song_editor.song_widget;
+  auto& player = song_widget.player;
+  auto& key_tuning_action =
+      song_editor.song_menu_bar.play_menu.key_tuning_action;
+  const auto& program = get_some_programs(true).at(0);
+
+  key_tuning_action.setChecked(true);
+  QVERIFY(player.use_key_tuning);
+  stop_playing(player);
+  initialize_play(song_widget);
+  const auto start_time = player.play_state.current_time;
+  const auto end_time = start_time + WAIT_TIME;
+
+  const auto maybe_root_slot = get_note_slot(
+      song_widget, player, program, MIDDLE_C_MIDI, BIG_VELOCITY, start_time);
+  QVERIFY(maybe_root_slot.has_value());
+  play_note(player, *maybe_root_slot, program, MIDDLE_C_MIDI, BIG_VELOCITY,
+            start_time, end_time);
+
+  const auto third_midi_number = MIDDLE_C_MIDI + JUST_MAJOR_THIRD_HALFSTEPS;
+  const auto maybe_third_slot =
+      get_note_slot(song_widget, player, program, third_midi_number,
+                    BIG_VELOCITY, start_time);
+  QVERIFY(maybe_third_slot.has_value());
+  QCOMPARE(maybe_third_slot->channel_number, maybe_root_slot->channel_number);
+  QCOMPARE(maybe_third_slot->key, static_cast<short>(MIDDLE_C_MIDI + 4));
+  play_note(player, *maybe_third_slot, program, third_midi_number,
+            BIG_VELOCITY, start_time, end_time);
+
+  stop_playing(player);
+  key_tuning_action.setChecked(false);
+  QVERIFY(!player.use_key_tuning);
+}
+
+void Tester::test_playback_plan() {
+  auto& song_widget = song_editor.song_widget;
+  auto& starting_tempo_editor =
+      song_widget.controls_column.spin_boxes.starting_tempo_editor;
+
+  const auto& playback_plan = get_playback_plan(song_widget);
+  const auto old_revision = playback_plan.song_revision;
+  QCOMPARE(playback_plan.chord_states.size(), song_widget.song.chords.size());
+
+  const auto planned_chord = get_planned_chords(playback_plan, 1, 1);
+  QVERIFY(!planned_chord.empty());
+  QVERIFY(std::ranges::all_of(
+      planned_chord, [](const PlannedNote& planned_note) -> auto {
+        return planned_note.chord_number == 1;
+      }));
+
+  const auto planned_notes = get_planned_notes(playback_plan, 1, false, 0, 1);
+  QCOMPARE(static_cast<int>(planned_notes.size()), 1);
+  QVERIFY(!planned_notes.front().is_pitched);
+  QCOMPARE(planned_notes.front().chord_number, 1);
+  QCOMPARE(planned_notes.front().note_number, 0);
+
+  // any edit makes the next play recompile it
+  const auto old_end_time = playback_plan.end_time;
+  starting_tempo_editor.setValue(STARTING_TEMPO_1);
+  QCOMPARE_NE(get_playback_plan(song_widget).song_revision, old_revision);
+  QCOMPARE_NE(get_playback_plan(song_widget).end_time, old_end_time);
+  song_widget.undo_stack.undo();
+  QCOMPARE(get_playback_plan(song_widget).end_time, old_end_time);
+}
+
+// a lone voice goes straight to the synth on the audition thread, skipping
+// the sequencer, so it should have been dispatched well before it ends
+void Tester::test_audition_voice() {
+  auto& song_widget = song_editor.song_widget;
+  auto& switch_table = song_widget.switch_column.switch_table;
+  auto& player = song_widget.player;
+  auto& play_menu = song_editor.song_menu_bar.play_menu;
+
+  switch_to(song_editor, RowType::pitched_voice_type, -1);
+  select_cell(switch_table, 0,
+              static_cast<int>(
+                  PitchedVoiceColumn::pitched_voice_instrument_column));
+  QVERIFY(is_audition(get_play_selection(song_widget)));
+  player.auditioner.dispatch_milliseconds.store(-1);
+  play_menu.play_action.trigger();
+  QThread::msleep(WAIT_TIME);
+  const auto dispatch_milliseconds =
+      player.auditioner.dispatch_milliseconds.load();
+  QVERIFY(dispatch_milliseconds >= 0);
+  QVERIFY(dispatch_milliseconds < WAIT_TIME);
+  QVERIFY(get_audition_latency(player) >= get_output_latency(player));
+  // the status bar reports this preview's latency, not the one before it
+  QTRY_COMPARE(get_reference(song_editor.statusBar()).currentMessage(),
+               SongEditor::tr("Audition latency: ") +
+                   QString::number(get_audition_latency(player), 'f', 1) +
+                   SongEditor::tr(" ms"));
+  play_menu.stop_playing_action.trigger();
+
+  maybe_switch_back_to_chords(song_widget.undo_stack,
+                              RowType::pitched_voice_type);
+}
+
+void Tester::test_pre_render_selection() {
+  static const auto PRE_RENDER_TIMEOUT = 10000;
+  auto& song_widget = song_editor.song_widget;
+  auto& switch_table = song_widget.switch_column.switch_table;
+  auto& player = song_widget.player;
+  auto& play_menu = song_editor.song_menu_bar.play_menu;
+
+  select_cell(switch_table, 0, 0);
+  play_menu.pre_render_action.setChecked(true);
+  const auto request_number = play_menu.pre_render_request_number;
+  QVERIFY(request_number > 0);
+  QTRY_VERIFY_WITH_TIMEOUT(
+      get_pre_rendered_audio(player.pre_renderer, request_number) != nullptr,
+      PRE_RENDER_TIMEOUT);
+  QVERIFY(!get_pre_rendered_audio(player.pre_renderer, request_number)
+               ->left_samples.empty());
+
+  // once the render is done, playing the same selection plays it rather
+  // than scheduling the notes live
+  const auto start_tick = static_cast<double>(
+      fluid_sequencer_get_tick(player.sequencer.internal_pointer));
+  play_menu.play_action.trigger();
+  {
+    const std::lock_guard lock(player.pre_rendered_playback.mutex);
+    QVERIFY(player.pre_rendered_playback.audio_pointer != nullptr);
+  }
+  // but still moves the player's clock on, like live playback would
+  QVERIFY(player.play_state.current_time > start_tick);
+  QVERIFY(player.final_time >= player.play_state.current_time);
+  play_menu.stop_playing_action.trigger();
+  {
+    const std::lock_guard lock(player.pre_rendered_playback.mutex);
+    QVERIFY(player.pre_rendered_playback.audio_pointer == nullptr);
+  }
+
+  play_menu.pre_render_action.setChecked(false);
+}
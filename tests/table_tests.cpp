@@ -1,6 +1,7 @@
 #include <QtWidgets/QSpinBox>
 
 #include "Tester.hpp"
+#include "other/MemoryUsage.hpp"
 #include "widgets/ControlsColumn.hpp"
 #include "widgets/SpinBoxes.hpp"
 
@@ -291,6 +292,93 @@ void Tester::test_delete() {
   maybe_switch_back_to_chords(undo_stack, row_type);
 }
 
+void Tester::test_display_follows_removed_row_data() {
+  add_editable_cell_pairs();
+}
+
+// cells are only worked out the first time they're displayed, so the rows
+// after a removed one have to take their displays with them
+void Tester::test_display_follows_removed_row() {
+  QFETCH(const RowType, row_type);
+  QFETCH(const int, chord_number);
+  QFETCH(const int, first_row_number);
+  QFETCH(const int, second_row_number);
+  QFETCH(const int, column_number);
+
+  auto& song_widget = song_editor.song_widget;
+  auto& switch_table = song_widget.switch_column.switch_table;
+  auto& undo_stack = song_widget.undo_stack;
+
+  switch_to(song_editor, row_type, chord_number);
+
+  auto& model = get_model(switch_table);
+  const auto& first_index = model.index(first_row_number, column_number);
+  const auto& second_index = model.index(second_row_number, column_number);
+
+  const auto first_value = first_index.data();
+  const auto second_value = second_index.data();
+
+  select_cell(switch_table, first_row_number, column_number);
+  song_editor.song_menu_bar.edit_menu.remove_rows_action.trigger();
+
+  QCOMPARE(first_index.data(), second_value);
+  undo_stack.undo();
+  QCOMPARE(first_index.data(), first_value);
+  QCOMPARE(second_index.data(), second_value);
+
+  maybe_switch_back_to_chords(undo_stack, row_type);
+}
+
+void Tester::test_undo_memory_counts_unshared_rows() {
+  auto& song_widget = song_editor.song_widget;
+  auto& undo_stack = song_widget.undo_stack;
+
+  const auto get_last_command_bytes = [&song_widget, &undo_stack]() -> auto {
+    MemoryCounter counter;
+    static_cast<void>(get_song_memory_entries(counter, song_widget.song));
+    return get_undo_memory_entries(counter, undo_stack).back().bytes;
+  };
+
+  select_cell(song_widget.switch_column.switch_table, 1, 0);
+  song_editor.song_menu_bar.edit_menu.remove_rows_action.trigger();
+  // the removed chord's notes are only in the undo stack
+  const auto removed_bytes = get_last_command_bytes();
+  undo_stack.undo();
+  // and now the song shares them again
+  QVERIFY(get_last_command_bytes() < removed_bytes);
+}
+
+void Tester::test_undo_restores_repeats() {
+  auto& song_widget = song_editor.song_widget;
+  auto& undo_stack = song_widget.undo_stack;
+  auto& repeats = song_widget.song.repeats;
+  auto& chords_model = song_widget.switch_column.switch_table.chords_model;
+
+  const QList<Repeat> old_repeats(
+      {Repeat{.first_chord_number = 1, .number_of_chords = 2, .times = 2}});
+  repeats = old_repeats;
+
+  // re-inserting the repeat's first chord mustn't push the repeat past it
+  undo_stack.push(make_remove_command(chords_model, 1, 1));
+  const QList<Repeat> shrunk_repeats(
+      {Repeat{.first_chord_number = 1, .number_of_chords = 1, .times = 2}});
+  QCOMPARE(repeats, shrunk_repeats);
+  undo_stack.undo();
+  QCOMPARE(repeats, old_repeats);
+
+  // a repeat that loses all of its chords comes back with them
+  undo_stack.push(make_remove_command(chords_model, 1, 2));
+  QVERIFY(repeats.isEmpty());
+  undo_stack.undo();
+  QCOMPARE(repeats, old_repeats);
+  undo_stack.redo();
+  QVERIFY(repeats.isEmpty());
+  undo_stack.undo();
+  QCOMPARE(repeats, old_repeats);
+
+  repeats.clear();
+}
+
 void Tester::test_next_previous_data() {
   add_table_columns();
 
@@ -117,6 +117,16 @@ inline void open_text(SongEditor& song_editor, const QString& song_text) {
                        song_editor.piano_roll_widget, temp_file.fileName());
 }
 
+// imports in the background like the Import action does, but waits for the
+// result rather than for import_timer
+inline void import_musicxml_and_wait(SongEditor& song_editor,
+                                     const QString& filename) {
+  auto& song_widget = song_editor.song_widget;
+  import_musicxml(song_widget, filename);
+  finish_import_and_reload(song_editor.song_menu_bar, song_widget,
+                           song_editor.piano_roll_widget);
+}
+
 // builds a minimal <song> fixture with one pitched/unpitched voice per given
 // name and, optionally, one <chord> per entry in chord_voice_numbers whose
 // pitched/unpitched notes reference voices by number (first/second of the
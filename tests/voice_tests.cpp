@@ -689,3 +689,26 @@ void Tester::test_voice_paste_insert_disabled() {
 
   maybe_switch_back_to_chords(undo_stack, row_type);
 }
+
+void Tester::test_voice_program_pointer_follows_program() {
+  PitchedVoice pitched_voice;
+  QCOMPARE(get_reference(pitched_voice.program_pointer).name,
+           pitched_voice.program);
+  pitched_voice.set_data(
+      static_cast<int>(PitchedVoiceColumn::pitched_voice_instrument_column),
+      QString("Marimba"));
+  QCOMPARE(get_reference(pitched_voice.program_pointer).name, "Marimba");
+
+  PitchedVoice copied_voice;
+  copied_voice.copy_column_from(
+      pitched_voice,
+      static_cast<int>(PitchedVoiceColumn::pitched_voice_instrument_column));
+  QCOMPARE(copied_voice.program_pointer, pitched_voice.program_pointer);
+
+  UnpitchedVoice unpitched_voice;
+  unpitched_voice.set_data(
+      static_cast<int>(
+          UnpitchedVoiceColumn::unpitched_voice_percussion_set_column),
+      QString("Room"));
+  QCOMPARE(get_reference(unpitched_voice.program_pointer).name, "Room");
+}